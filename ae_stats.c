@@ -0,0 +1,111 @@
+/*
+ * Exposure and white balance statistics, see ae_stats.h
+ */
+
+#include "ae_stats.h"
+
+void ae_stats_begin(ae_stats_acc *acc, ae_stats *stats, uint16 width, uint16 height) {
+    uint8 i;
+
+    /* whole macropixels only */
+    acc->line = (uint16)((width * 2) & ~3);
+    if (acc->line == 0) {
+        acc->line = 4;
+    }
+    acc->zone_bytes = (uint16)((acc->line / AE_STATS_ZONES_X) & ~3);
+    if (acc->zone_bytes == 0) {
+        acc->zone_bytes = 4;
+    }
+    acc->zone_lines = height / AE_STATS_ZONES_Y;
+    if (acc->zone_lines == 0) {
+        acc->zone_lines = 1;
+    }
+    acc->col = 0;
+    acc->row = 0;
+    acc->zx = 0;
+    acc->zy = 0;
+    for (i = 0; i < AE_STATS_BINS; i++) {
+        acc->hist[i] = 0;
+    }
+    for (i = 0; i < AE_STATS_ZONES; i++) {
+        acc->zone_sum[i] = 0;
+        acc->zone_count[i] = 0;
+    }
+    acc->u_sum = 0;
+    acc->v_sum = 0;
+    acc->chroma = 0;
+    acc->stats = stats;
+}
+
+/* n bytes inside one line of one zone, starting at acc->col */
+static inline void statsSegment(ae_stats_acc *acc, const uint8 *p, uint16 n, uint8 zone) {
+    uint16 phase = acc->col & 3;
+    uint32 sum = 0, count = 0, u = 0, v = 0, chroma = 0;
+    uint16 i;
+
+    for (i = (4 - phase) & 3; i < n; i += 4) {
+        uint8 y = p[i];
+        acc->hist[y / (256 / AE_STATS_BINS)]++;
+        sum += y;
+        count++;
+    }
+    for (i = (5 - phase) & 3; i < n; i += 4) {
+        u += p[i];
+        chroma++;
+    }
+    for (i = (7 - phase) & 3; i < n; i += 4) {
+        v += p[i];
+    }
+    acc->zone_sum[zone] += sum;
+    acc->zone_count[zone] += count;
+    acc->u_sum += u;
+    acc->v_sum += v;
+    acc->chroma += chroma;
+}
+
+void ae_stats_update(ae_stats_acc *acc, const uint8 *data, uint16 len) {
+    while (len > 0) {
+        /* the last zone column runs to the end of the line */
+        uint16 end = (acc->zx == AE_STATS_ZONES_X - 1) ?
+            acc->line : (uint16)((acc->zx + 1) * acc->zone_bytes);
+        uint16 n = (len < end - acc->col) ? len : end - acc->col;
+
+        statsSegment(acc, data, n, acc->zy * AE_STATS_ZONES_X + acc->zx);
+        data += n;
+        len -= n;
+        acc->col += n;
+
+        if (acc->col == acc->line) {
+            acc->col = 0;
+            acc->zx = 0;
+            acc->row++;
+            if (acc->zy < AE_STATS_ZONES_Y - 1 &&
+                acc->row == (acc->zy + 1) * acc->zone_lines) {
+                acc->zy++;
+            }
+        } else if (acc->col == end) {
+            acc->zx++;
+        }
+    }
+}
+
+void ae_stats_end(ae_stats_acc *acc) {
+    ae_stats *stats = acc->stats;
+    uint32 sum = 0, samples = 0;
+    uint8 i;
+
+    for (i = 0; i < AE_STATS_ZONES; i++) {
+        stats->zone_mean[i] = acc->zone_count[i] ?
+            (uint8)(acc->zone_sum[i] / acc->zone_count[i]) : 0;
+        sum += acc->zone_sum[i];
+        samples += acc->zone_count[i];
+    }
+    for (i = 0; i < AE_STATS_BINS; i++) {
+        stats->hist[i] = samples ?
+            (uint16)((uint64)acc->hist[i] * 0xFFFF / samples) : 0;
+    }
+    stats->y_mean = samples ? (uint8)(sum / samples) : 0;
+    stats->u_mean = acc->chroma ? (uint8)(acc->u_sum / acc->chroma) : 0x80;
+    stats->v_mean = acc->chroma ? (uint8)(acc->v_sum / acc->chroma) : 0x80;
+    stats->samples = samples;
+}
@@ -0,0 +1,62 @@
+/*
+ * Exposure and white balance statistics of a YUY2 frame
+ *
+ * Collected from the payload data on its way to the endpoint, so a host
+ * auto-exposure loop can work from a luma histogram and zone means
+ * without decoding frames. Every macropixel (Y0 U Y1 V) gives one luma
+ * sample, its Y0, and one chroma pair. The frame is split into a grid
+ * of AE_STATS_ZONES_X x AE_STATS_ZONES_Y zones; the last zone column
+ * and row take the pixels left over by the division. Data can be fed in
+ * pieces of any size as long as they follow each other from the start
+ * of the frame.
+ */
+
+#ifndef _AE_STATS_H_
+#define _AE_STATS_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AE_STATS_BINS           16      /* luma levels per bin: 256 / BINS */
+#define AE_STATS_ZONES_X        4
+#define AE_STATS_ZONES_Y        4
+#define AE_STATS_ZONES          (AE_STATS_ZONES_X * AE_STATS_ZONES_Y)
+
+typedef struct ae_stats {
+    uint8 y_mean;
+    uint8 u_mean;               /* 128 is neutral */
+    uint8 v_mean;
+    uint8 zone_mean[AE_STATS_ZONES];    /* luma, row by row */
+    uint16 hist[AE_STATS_BINS];         /* share of the samples, sums to about 65535 */
+    uint32 samples;
+} ae_stats;
+
+typedef struct ae_stats_acc {
+    uint16 line;                /* bytes per line */
+    uint16 zone_bytes;          /* bytes per zone column, a whole number of macropixels */
+    uint16 zone_lines;
+    uint16 col;                 /* byte offset in the current line */
+    uint16 row;
+    uint8 zx;
+    uint8 zy;
+    uint32 hist[AE_STATS_BINS];
+    uint32 zone_sum[AE_STATS_ZONES];
+    uint32 zone_count[AE_STATS_ZONES];
+    uint32 u_sum;
+    uint32 v_sum;
+    uint32 chroma;
+    ae_stats *stats;
+} ae_stats_acc;
+
+void ae_stats_begin(ae_stats_acc *acc, ae_stats *stats, uint16 width, uint16 height);
+void ae_stats_update(ae_stats_acc *acc, const uint8 *data, uint16 len);
+void ae_stats_end(ae_stats_acc *acc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
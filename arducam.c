@@ -0,0 +1,266 @@
+/*
+ * ArduCAM shield, see arducam.h
+ */
+
+#include <libmaple/gpio.h>
+
+#include "arducam.h"
+#include "ramfunc.h"
+#include "dwt.h"
+
+static inline void csLow(void) {
+    gpio_write_bit(ARDUCAM_CS_DEV, ARDUCAM_CS_BIT, 0);
+}
+
+static inline void csHigh(void) {
+    gpio_write_bit(ARDUCAM_CS_DEV, ARDUCAM_CS_BIT, 1);
+}
+
+/* SPI clock of each step, slowest first */
+static const spi_baud_rate spi_steps[ARDUCAM_SPI_STEPS] = {
+    SPI_BAUD_PCLK_DIV_16, SPI_BAUD_PCLK_DIV_8, SPI_BAUD_PCLK_DIV_4,
+};
+
+static arducam_spi_stats spi_stats;
+
+/* calibration */
+static uint32 cal_len;
+static uint32 cal_ref;          /* FIFO checksum at the safe step */
+static uint8 cal_next;          /* step tried by the next arducam_spi_cal_step() */
+static uint8 cal_marginal;      /* the failing step passed some rounds */
+static uint32 step_kb_us[ARDUCAM_SPI_STEPS];
+
+static inline uint8 spiXfer(uint8 val) {
+    spi_tx_reg(ARDUCAM_SPI, val);
+    while (!spi_is_rx_nonempty(ARDUCAM_SPI))
+        ;
+    return (uint8)spi_rx_reg(ARDUCAM_SPI);
+}
+
+/* not inside a burst, chip select has to be high */
+static void spiSetStep(uint8 step) {
+    spi_master_enable(ARDUCAM_SPI, spi_steps[step], SPI_MODE_0,
+                      SPI_FRAME_MSB | SPI_DFF_8_BIT | SPI_SW_SLAVE | SPI_SOFT_SS);
+    spi_stats.step = step;
+    spi_stats.hz = arducam_spi_hz(step);
+    spi_stats.kb_us = step_kb_us[step];
+}
+
+int arducam_init(void) {
+    gpio_set_mode(ARDUCAM_CS_DEV, ARDUCAM_CS_BIT, GPIO_OUTPUT_PP);
+    csHigh();
+    gpio_set_mode(GPIOA, 5, GPIO_AF_OUTPUT_PP);
+    gpio_set_mode(GPIOA, 6, GPIO_INPUT_FLOATING);
+    gpio_set_mode(GPIOA, 7, GPIO_AF_OUTPUT_PP);
+
+    spi_init(ARDUCAM_SPI);
+    spiSetStep(ARDUCAM_SPI_STEP_SAFE);
+    spi_stats.calibrated = ARDUCAM_SPI_STEP_SAFE;
+    spi_stats.failed = ARDUCAM_SPI_STEPS;
+
+    arducam_write_reg(ARDUCAM_TEST1, ARDUCAM_TEST_PATTERN);
+    if (arducam_read_reg(ARDUCAM_TEST1) != ARDUCAM_TEST_PATTERN) {
+        return -1;
+    }
+    arducam_write_reg(ARDUCAM_FIFO, ARDUCAM_FIFO_CLEAR);
+    return 0;
+}
+
+uint8 arducam_read_reg(uint8 addr) {
+    uint8 val;
+
+    csLow();
+    spiXfer(addr & ~ARDUCAM_WRITE);
+    val = spiXfer(0x00);
+    csHigh();
+    return val;
+}
+
+void arducam_write_reg(uint8 addr, uint8 val) {
+    csLow();
+    spiXfer(addr | ARDUCAM_WRITE);
+    spiXfer(val);
+    csHigh();
+}
+
+/* Frames taken back to back by the next captures, 1 to ARDUCAM_MAX_FRAMES */
+void arducam_set_frames(uint8 frames) {
+    if (frames < 1) {
+        frames = 1;
+    }
+    if (frames > ARDUCAM_MAX_FRAMES) {
+        frames = ARDUCAM_MAX_FRAMES;
+    }
+    arducam_write_reg(ARDUCAM_FRAMES, frames - 1);
+}
+
+void arducam_start_capture(void) {
+    arducam_write_reg(ARDUCAM_FIFO, ARDUCAM_FIFO_CLEAR);
+    arducam_write_reg(ARDUCAM_FIFO, ARDUCAM_FIFO_RDPTR_RST | ARDUCAM_FIFO_WRPTR_RST);
+    arducam_write_reg(ARDUCAM_FIFO, ARDUCAM_FIFO_START);
+}
+
+int arducam_capture_done(void) {
+    return (arducam_read_reg(ARDUCAM_TRIG) & ARDUCAM_TRIG_CAP_DONE) != 0;
+}
+
+/* ARDUCAM_TRIG_VSYNC, the VSYNC pin, and ARDUCAM_TRIG_CAP_DONE in one read */
+uint8 arducam_status(void) {
+    return arducam_read_reg(ARDUCAM_TRIG);
+}
+
+uint32 arducam_fifo_length(void) {
+    uint32 len;
+
+    len = arducam_read_reg(ARDUCAM_FIFO_SIZE1);
+    len |= (uint32)arducam_read_reg(ARDUCAM_FIFO_SIZE2) << 8;
+    len |= (uint32)(arducam_read_reg(ARDUCAM_FIFO_SIZE3) & 0x7F) << 16;
+    return len;
+}
+
+/* Read the captured frame again from the start, outside a burst */
+void arducam_fifo_rewind(void) {
+    arducam_write_reg(ARDUCAM_FIFO, ARDUCAM_FIFO_RDPTR_RST);
+}
+
+/* A burst read keeps chip select low between calls to
+ * arducam_burst_read(), nothing else may use the SPI bus until
+ * arducam_burst_end() */
+void arducam_burst_begin(void) {
+    csLow();
+    spiXfer(ARDUCAM_BURST_FIFO_READ);
+#if ARDUCAM_BURST_DUMMY
+    spiXfer(0x00);
+#endif
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, arducam_burst_read)
+void arducam_burst_read(uint8 *buf, uint16 len) {
+    while (len--) {
+        *buf++ = spiXfer(0x00);
+    }
+}
+
+void arducam_burst_end(void) {
+    while (spi_is_busy(ARDUCAM_SPI))
+        ;
+    csHigh();
+}
+
+uint32 arducam_spi_hz(uint8 step) {
+    return ARDUCAM_SPI_PCLK >> (4 - step);
+}
+
+/* Bit patterns through the test register, 0 if all of them come back */
+static int spiCheckReg(void) {
+    static const uint8 patterns[] = {0x55, 0xAA, 0x00, 0xFF, 0x01, 0x80, 0x7E, 0x81};
+    uint8 i;
+
+    for (i = 0; i < sizeof(patterns); i++) {
+        arducam_write_reg(ARDUCAM_TEST1, patterns[i]);
+        if (arducam_read_reg(ARDUCAM_TEST1) != patterns[i]) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Adler-32 of the first len bytes in the FIFO, timed for the step in use */
+static uint32 spiFifoSum(uint32 len) {
+    uint8 buf[32];
+    uint32 a = 1, b = 0;
+    uint32 start = dwt_cycles();
+    uint32 total = len;
+
+    arducam_fifo_rewind();
+    arducam_burst_begin();
+    while (len > 0) {
+        uint16 n = (len < sizeof(buf)) ? (uint16)len : sizeof(buf);
+        uint16 i;
+
+        arducam_burst_read(buf, n);
+        for (i = 0; i < n; i++) {
+            a += buf[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        len -= n;
+    }
+    arducam_burst_end();
+    if (total != 0) {
+        step_kb_us[spi_stats.step] = dwt_cycles_to_us(dwt_cycles() - start) * 1024 / total;
+        spi_stats.kb_us = step_kb_us[spi_stats.step];
+    }
+    return (b << 16) | a;
+}
+
+/*
+ * Start the calibration on a frame of len bytes captured in the FIFO,
+ * its checksum at the safe step is the reference. Returns -1 and stays
+ * at the safe step if two reads there do not agree.
+ */
+int arducam_spi_cal_begin(uint32 len) {
+    spiSetStep(ARDUCAM_SPI_STEP_SAFE);
+    spi_stats.calibrated = ARDUCAM_SPI_STEP_SAFE;
+    spi_stats.failed = ARDUCAM_SPI_STEPS;
+    cal_len = (len < ARDUCAM_SPI_CAL_BYTES) ? len : ARDUCAM_SPI_CAL_BYTES;
+    cal_ref = spiFifoSum(cal_len);
+    cal_next = ARDUCAM_SPI_STEP_SAFE + 1;
+    cal_marginal = 0;
+    if (cal_len == 0 || spiCheckReg() != 0 || spiFifoSum(cal_len) != cal_ref) {
+        spi_stats.failed = ARDUCAM_SPI_STEP_SAFE;
+        cal_next = ARDUCAM_SPI_STEPS;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Try the next faster step, ARDUCAM_SPI_CAL_ROUNDS times. Returns 1
+ * while there are steps left to try, 0 once the clock is set: the
+ * fastest step that passed every round, or the one below it when the
+ * step above failed only some rounds and the limit is that close.
+ */
+int arducam_spi_cal_step(void) {
+    uint8 round, passed = 0;
+
+    if (cal_next < ARDUCAM_SPI_STEPS) {
+        spiSetStep(cal_next);
+        for (round = 0; round < ARDUCAM_SPI_CAL_ROUNDS; round++) {
+            if (spiCheckReg() == 0 && spiFifoSum(cal_len) == cal_ref) {
+                passed++;
+            }
+        }
+        if (passed == ARDUCAM_SPI_CAL_ROUNDS) {
+            spi_stats.calibrated = cal_next++;
+        } else {
+            spi_stats.failed = cal_next;
+            cal_marginal = (passed != 0);
+            cal_next = ARDUCAM_SPI_STEPS;
+        }
+        if (cal_next < ARDUCAM_SPI_STEPS) {
+            return 1;
+        }
+    }
+
+    if (cal_marginal && spi_stats.calibrated > ARDUCAM_SPI_STEP_SAFE) {
+        spi_stats.calibrated--;
+    }
+    spiSetStep(spi_stats.calibrated);
+    return 0;
+}
+
+/* One step slower, outside a burst. Returns -1 at the safe step. */
+int arducam_spi_fallback(void) {
+    if (spi_stats.step == ARDUCAM_SPI_STEP_SAFE) {
+        return -1;
+    }
+    spiSetStep(spi_stats.step - 1);
+    spi_stats.fallbacks++;
+    return 0;
+}
+
+const arducam_spi_stats* arducam_spi_get_stats(void) {
+    return &spi_stats;
+}
@@ -0,0 +1,119 @@
+/*
+ * ArduCAM shield: SPI register access and capture FIFO
+ *
+ * The shield sits on SPI1 (PA5 SCK, PA6 MISO, PA7 MOSI) with chip
+ * select on PA4. The OV2640 itself is programmed over I2C1, see ov2640.h
+ *
+ * The SPI clock caps how fast the FIFO drains. It starts at the safe
+ * step; arducam_spi_cal_begin()/arducam_spi_cal_step() then try the
+ * faster steps against the test register and a frame captured in the
+ * FIFO, and keep the fastest one that passes with a step of margin
+ * below any that fails only now and then. arducam_spi_fallback() steps
+ * down again when the stream sees broken frames.
+ */
+
+#ifndef _ARDUCAM_H_
+#define _ARDUCAM_H_
+
+#include <libmaple/libmaple_types.h>
+#include <libmaple/spi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARDUCAM_SPI             SPI1
+#define ARDUCAM_CS_DEV          GPIOA
+#define ARDUCAM_CS_BIT          4
+/* SPI clock steps, slowest first: PCLK2 (72 MHz) / 16, / 8, / 4. The
+ * F103's SPI goes no faster than PCLK2 / 4; the ArduCAM Mini 2MP is
+ * only specified up to 8 MHz, anything past the safe step is measured */
+#define ARDUCAM_SPI_STEPS       3
+#define ARDUCAM_SPI_STEP_SAFE   0
+#define ARDUCAM_SPI_PCLK        72000000
+/* FIFO bytes compared per round and rounds per step */
+#define ARDUCAM_SPI_CAL_BYTES   4096
+#define ARDUCAM_SPI_CAL_ROUNDS  4
+
+/* registers, OR with ARDUCAM_WRITE to write */
+#define ARDUCAM_WRITE           0x80
+#define ARDUCAM_TEST1           0x00
+#define ARDUCAM_FRAMES          0x01
+#define ARDUCAM_TIM             0x03
+#define ARDUCAM_FIFO            0x04
+#define ARDUCAM_GPIO            0x06
+#define ARDUCAM_BURST_FIFO_READ 0x3C
+#define ARDUCAM_SINGLE_FIFO_READ 0x3D
+#define ARDUCAM_VER             0x40
+#define ARDUCAM_TRIG            0x41
+#define ARDUCAM_FIFO_SIZE1      0x42
+#define ARDUCAM_FIFO_SIZE2      0x43
+#define ARDUCAM_FIFO_SIZE3      0x44
+
+/* ARDUCAM_FIFO */
+#define ARDUCAM_FIFO_CLEAR      0x01
+#define ARDUCAM_FIFO_START      0x02
+#define ARDUCAM_FIFO_RDPTR_RST  0x10
+#define ARDUCAM_FIFO_WRPTR_RST  0x20
+
+/* ARDUCAM_TRIG */
+#define ARDUCAM_TRIG_VSYNC      0x01
+#define ARDUCAM_TRIG_CAP_DONE   0x08
+
+#define ARDUCAM_TEST_PATTERN    0x55
+
+/* 1 for the Mini 2MP Plus: 8 MB FIFO, multi-frame capture */
+#ifndef ARDUCAM_PLUS
+#define ARDUCAM_PLUS            0
+#endif
+
+#if ARDUCAM_PLUS
+#define ARDUCAM_FIFO_MAX        0x7FFFFF
+/* ARDUCAM_FRAMES holds frames - 1, 7 would capture until the FIFO is full */
+#define ARDUCAM_MAX_FRAMES      7
+#define ARDUCAM_BURST_DUMMY     0
+#else
+#define ARDUCAM_FIFO_MAX        0x5FFFF
+#define ARDUCAM_MAX_FRAMES      1
+/* the Mini 2MP (not the Plus) clocks out one dummy byte after a burst
+ * read command */
+#define ARDUCAM_BURST_DUMMY     1
+#endif
+
+typedef struct arducam_spi_stats {
+    uint32 hz;                  /* SPI clock in use */
+    uint32 kb_us;               /* 1 KB FIFO read and checksum, as timed by the
+                                 * calibration at this step; 0 if never read */
+    uint8 step;                 /* in use, ARDUCAM_SPI_STEP_SAFE is the slowest */
+    uint8 calibrated;           /* chosen by the calibration */
+    uint8 failed;               /* first step that failed it, ARDUCAM_SPI_STEPS if none */
+    uint8 fallbacks;            /* steps down since */
+} arducam_spi_stats;
+
+int arducam_init(void);
+uint8 arducam_read_reg(uint8 addr);
+void arducam_write_reg(uint8 addr, uint8 val);
+
+void arducam_set_frames(uint8 frames);
+void arducam_start_capture(void);
+int arducam_capture_done(void);
+uint8 arducam_status(void);
+uint32 arducam_fifo_length(void);
+
+void arducam_fifo_rewind(void);
+
+void arducam_burst_begin(void);
+void arducam_burst_read(uint8 *buf, uint16 len);
+void arducam_burst_end(void);
+
+uint32 arducam_spi_hz(uint8 step);
+int arducam_spi_cal_begin(uint32 len);
+int arducam_spi_cal_step(void);
+int arducam_spi_fallback(void);
+const arducam_spi_stats* arducam_spi_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Cortex-M3 DWT cycle counter, used for timing measurements.
+ *
+ * CYCCNT runs at the core clock (72 MHz on the blue pill) and wraps
+ * after roughly 59 seconds, so differences of two readings are valid
+ * for anything shorter than that. Off target the counter stands still,
+ * for the host tools that build device sources.
+ */
+
+#ifndef _DWT_H_
+#define _DWT_H_
+
+#include <libmaple/libmaple_types.h>
+
+#define DWT_CTRL        (*(volatile uint32*)0xE0001000)
+#define DWT_CYCCNT      (*(volatile uint32*)0xE0001004)
+#define DWT_DEMCR       (*(volatile uint32*)0xE000EDFC)
+
+#define DWT_DEMCR_TRCENA        (1 << 24)
+#define DWT_CTRL_CYCCNTENA      (1 << 0)
+
+#define DWT_CYCLES_PER_US       72
+
+#ifdef __arm__
+
+/* Starts the counter from 0, a running counter is left alone so that
+ * readings taken before stay comparable */
+static inline void dwt_enable(void) {
+    if (DWT_CTRL & DWT_CTRL_CYCCNTENA) {
+        return;
+    }
+    DWT_DEMCR |= DWT_DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+static inline uint32 dwt_cycles(void) {
+    return DWT_CYCCNT;
+}
+
+#else
+
+static inline void dwt_enable(void) {
+}
+
+static inline uint32 dwt_cycles(void) {
+    return 0;
+}
+
+#endif
+
+static inline uint32 dwt_cycles_to_us(uint32 cycles) {
+    return cycles / DWT_CYCLES_PER_US;
+}
+
+#endif
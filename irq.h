@@ -0,0 +1,32 @@
+/*
+ * Interrupt masking that nests
+ *
+ * nvic_globalirq_enable() unmasks whatever the caller had masked, so a
+ * section guarded with it and entered from an interrupt, or from code
+ * that already runs with interrupts off, opens them too early.
+ * irq_save() masks them and returns the PRIMASK it found, irq_restore()
+ * puts that back. Off target both do nothing, for the host tools.
+ */
+
+#ifndef _IRQ_H_
+#define _IRQ_H_
+
+#include <libmaple/libmaple_types.h>
+
+static inline __attribute__((always_inline)) uint32 irq_save(void) {
+    uint32 primask = 0;
+#ifdef __arm__
+    __asm__ __volatile__("mrs %0, primask\n\tcpsid i" : "=r"(primask) :: "memory");
+#endif
+    return primask;
+}
+
+static inline __attribute__((always_inline)) void irq_restore(uint32 primask) {
+#ifdef __arm__
+    __asm__ __volatile__("msr primask, %0" :: "r"(primask) : "memory");
+#else
+    (void)primask;
+#endif
+}
+
+#endif
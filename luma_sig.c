@@ -0,0 +1,67 @@
+/*
+ * Luma signature, see luma_sig.h
+ */
+
+#include "luma_sig.h"
+
+void luma_sig_begin(luma_sig_acc *acc, luma_sig *sig, uint32 frame_len) {
+    uint32 samples = (frame_len + LUMA_SIG_STEP - 1) / LUMA_SIG_STEP;
+
+    acc->per_block = samples / LUMA_SIG_BLOCKS;
+    if (acc->per_block == 0) {
+        acc->per_block = 1;
+    }
+    acc->sum = 0;
+    acc->count = 0;
+    acc->skip = 0;
+    acc->index = 0;
+    acc->sig = sig;
+}
+
+void luma_sig_update(luma_sig_acc *acc, const uint8 *data, uint16 len) {
+    uint32 i = acc->skip;
+    uint32 sum = acc->sum;
+    uint32 count = acc->count;
+
+    while (i < len) {
+        sum += data[i];
+        i += LUMA_SIG_STEP;
+        if (++count == acc->per_block) {
+            /* the few samples past the last whole run are dropped */
+            if (acc->index < LUMA_SIG_BLOCKS) {
+                acc->sig->block[acc->index++] = (uint8)(sum / count);
+            }
+            sum = 0;
+            count = 0;
+        }
+    }
+    acc->skip = (uint16)(i - len);
+    acc->sum = sum;
+    acc->count = count;
+}
+
+/* a short frame leaves its last runs at the mean of the samples seen */
+void luma_sig_end(luma_sig_acc *acc) {
+    uint8 fill = (acc->count != 0) ? (uint8)(acc->sum / acc->count) : 0;
+
+    if (acc->count == 0 && acc->index != 0) {
+        fill = acc->sig->block[acc->index - 1];
+    }
+    while (acc->index < LUMA_SIG_BLOCKS) {
+        acc->sig->block[acc->index++] = fill;
+    }
+}
+
+/* Largest change of any run, in luma levels */
+uint8 luma_sig_distance(const luma_sig *a, const luma_sig *b) {
+    uint8 i, d, max = 0;
+
+    for (i = 0; i < LUMA_SIG_BLOCKS; i++) {
+        d = (a->block[i] > b->block[i]) ?
+            a->block[i] - b->block[i] : b->block[i] - a->block[i];
+        if (d > max) {
+            max = d;
+        }
+    }
+    return max;
+}
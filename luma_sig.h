@@ -0,0 +1,47 @@
+/*
+ * Luma signature of a YUY2 frame, for change detection
+ *
+ * The frame is cut into LUMA_SIG_BLOCKS runs of equal length in FIFO
+ * order and every LUMA_SIG_STEP-th luma byte is averaged per run. No
+ * frame geometry is needed, so a cropped frame works the same way, and
+ * a change anywhere in the picture moves the mean of the runs that
+ * cover it. Data can be fed in pieces of any size as it comes out of
+ * the FIFO.
+ */
+
+#ifndef _LUMA_SIG_H_
+#define _LUMA_SIG_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LUMA_SIG_BLOCKS         64
+/* bytes between samples: every 4th pixel, Y sits on even offsets */
+#define LUMA_SIG_STEP           8
+
+typedef struct luma_sig {
+    uint8 block[LUMA_SIG_BLOCKS];       /* mean luma of each run */
+} luma_sig;
+
+typedef struct luma_sig_acc {
+    uint32 per_block;           /* samples per run */
+    uint32 sum;
+    uint32 count;
+    uint16 skip;                /* offset of the next sample in the next piece */
+    uint8 index;
+    luma_sig *sig;
+} luma_sig_acc;
+
+void luma_sig_begin(luma_sig_acc *acc, luma_sig *sig, uint32 frame_len);
+void luma_sig_update(luma_sig_acc *acc, const uint8 *data, uint16 len);
+void luma_sig_end(luma_sig_acc *acc);
+uint8 luma_sig_distance(const luma_sig *a, const luma_sig *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Static fixed-block pools, see mem_pool.h
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include "mem_pool.h"
+#include "uvc_stream.h"
+#include "irq.h"
+
+#define WORDS(size)             (((size) + 3) / 4)
+
+#define MEM_POOL_DEFINE(var, label, size, num)                          \
+    static uint32 var##_mem[WORDS(size) * (num)];                       \
+    mem_pool var = {                                                    \
+        .name       = label,                                            \
+        .base       = (uint8*)var##_mem,                                \
+        .block_size = WORDS(size) * 4,                                  \
+        .count      = num,                                              \
+        .used       = 0,                                                \
+        .high_water = 0,                                                \
+        .failures   = 0,                                                \
+        .bad_frees  = 0,                                                \
+        .free_map   = (num) == 32 ? 0xFFFFFFFF : (1UL << (num)) - 1,    \
+    }
+
+MEM_POOL_DEFINE(mem_pool_packet, "packet", sizeof(uvc_packet), UVC_STREAM_RING_SIZE);
+MEM_POOL_DEFINE(mem_pool_line, "line", MEM_POOL_LINE_SIZE, MEM_POOL_LINE_COUNT);
+MEM_POOL_DEFINE(mem_pool_scratch, "scratch", MEM_POOL_SCRATCH_SIZE, MEM_POOL_SCRATCH_COUNT);
+
+#define MEM_POOL_TOTAL                                                  \
+    (sizeof(mem_pool_packet_mem) + sizeof(mem_pool_line_mem) +          \
+     sizeof(mem_pool_scratch_mem))
+
+/* build fails here when the pools and the stack alone outgrow SRAM,
+ * mem_seal() checks the rest once linked */
+typedef char mem_pools_exceed_sram[(MEM_POOL_TOTAL + MEM_STACK_SIZE <= MEM_SRAM_SIZE) ? 1 : -1];
+typedef char mem_pool_too_many_blocks[
+    (UVC_STREAM_RING_SIZE <= MEM_POOL_MAX_BLOCKS &&
+     MEM_POOL_LINE_COUNT <= MEM_POOL_MAX_BLOCKS &&
+     MEM_POOL_SCRATCH_COUNT <= MEM_POOL_MAX_BLOCKS) ? 1 : -1];
+
+static mem_pool * const pools[MEM_NUM_POOLS] = {
+    &mem_pool_packet,
+    &mem_pool_line,
+    &mem_pool_scratch,
+};
+
+/* libmaple linker scripts: end of .bss, initial main stack pointer at
+ * the top of SRAM */
+extern char _end[];
+extern char __msp_init[];
+
+/* what mem_seal() fills the gap between heap and stack with */
+#define MEM_PAINT               0xC5C5C5C5UL
+/* left alone below the stack pointer of mem_seal() */
+#define MEM_PAINT_GUARD         64
+
+static char *heap_seal;
+static uint32 *paint_lo;
+
+void* mem_pool_alloc(mem_pool *pool) {
+    uint8 index;
+    void *block = NULL;
+    uint32 primask;
+
+    primask = irq_save();
+    if (pool->free_map == 0) {
+        pool->failures++;
+    } else {
+        index = __builtin_ctz(pool->free_map);
+        pool->free_map &= ~(1UL << index);
+        if (++pool->used > pool->high_water) {
+            pool->high_water = pool->used;
+        }
+        block = pool->base + index * pool->block_size;
+    }
+    irq_restore(primask);
+    return block;
+}
+
+/* A block that is not one of this pool's, or is free already, is
+ * counted and left alone: a double free must not hand the same block
+ * out twice or run used below zero. */
+void mem_pool_free(mem_pool *pool, void *block) {
+    uint32 offset;
+    uint32 bit;
+    uint32 primask;
+
+    if (block == NULL) {
+        return;
+    }
+    offset = (uint32)((uint8*)block - pool->base);
+    bit = 1UL << (offset / pool->block_size);
+
+    primask = irq_save();
+    /* a block below base wraps to a large offset */
+    if (offset >= (uint32)pool->count * pool->block_size ||
+        offset % pool->block_size != 0 || (pool->free_map & bit)) {
+        pool->bad_frees++;
+    } else {
+        pool->free_map |= bit;
+        pool->used--;
+    }
+    irq_restore(primask);
+}
+
+mem_pool* mem_pool_get(uint8 index) {
+    return (index < MEM_NUM_POOLS) ? pools[index] : NULL;
+}
+
+/*
+ * Called at the end of setup(). From then on the heap must not grow,
+ * mem_heap_growth() reports by how much it did. Returns -1 when less
+ * than MEM_STACK_SIZE is left above the heap, or above .bss if the heap
+ * is unused.
+ */
+int mem_seal(void) {
+    char *sp = (char*)__builtin_frame_address(0) - MEM_PAINT_GUARD;
+    char *top;
+    uint32 *p;
+
+    heap_seal = (char*)sbrk(0);
+    top = (heap_seal > _end) ? heap_seal : _end;
+    paint_lo = (uint32*)(((uintptr_t)top + 3) & ~(uintptr_t)3);
+    for (p = paint_lo; (char*)p < sp; p++) {
+        *p = MEM_PAINT;
+    }
+    return (__msp_init - top >= MEM_STACK_SIZE) ? 0 : -1;
+}
+
+uint32 mem_heap_growth(void) {
+    if (heap_seal == NULL) {
+        return 0;
+    }
+    return (uint32)((char*)sbrk(0) - heap_seal);
+}
+
+/* Deepest main stack use since mem_seal(): the first word of the gap
+ * that is no longer the pattern, counted from below. Heap growth past
+ * the seal may count as stack. */
+uint32 mem_stack_depth(void) {
+    const uint32 *p = paint_lo;
+
+    if (p == NULL) {
+        return 0;
+    }
+    while ((char*)p < __msp_init && *p == MEM_PAINT) {
+        p++;
+    }
+    return (uint32)(__msp_init - (char*)p);
+}
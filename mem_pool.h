@@ -0,0 +1,73 @@
+/*
+ * Static fixed-block pools for the streaming pipeline
+ *
+ * All pool memory is reserved at link time. Blocks are taken and
+ * returned in O(1) through a free bitmap; nothing here touches the heap.
+ *
+ * Whether it all fits is only known once linked: .data, which holds the
+ * RAMFUNC() code of ramfunc.h, .bss with the pools, and the heap that
+ * setup() used all sit below the main stack. mem_seal() checks at the
+ * end of setup() that MEM_STACK_SIZE is left between the heap top and
+ * the top of SRAM, from the libmaple linker symbols, and fills that gap
+ * with a pattern. mem_stack_depth() then finds the deepest stack use,
+ * `m` prints it. To size MEM_STACK_SIZE, stream every format with every
+ * control for a while and take that depth plus a margin. A pool set that
+ * cannot fit next to the stack whatever else is linked fails to build.
+ */
+
+#ifndef _MEM_POOL_H_
+#define _MEM_POOL_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* STM32F103C8 */
+#define MEM_SRAM_SIZE           (20 * 1024)
+/* main stack, to be sized from mem_stack_depth() as above */
+#ifndef MEM_STACK_SIZE
+#define MEM_STACK_SIZE          (2 * 1024)
+#endif
+
+/* block sizes are rounded up to whole words */
+#define MEM_POOL_LINE_SIZE      (320 * 2)
+#define MEM_POOL_LINE_COUNT     2
+#define MEM_POOL_SCRATCH_SIZE   64
+#define MEM_POOL_SCRATCH_COUNT  4
+
+/* at most 32 blocks per pool, one bit each in free_map */
+#define MEM_POOL_MAX_BLOCKS     32
+
+typedef struct mem_pool {
+    const char *name;
+    uint8 *base;
+    uint16 block_size;
+    uint8 count;
+    uint8 used;
+    uint8 high_water;           /* most blocks ever in use at once */
+    uint16 failures;            /* allocations refused, pool empty */
+    uint16 bad_frees;           /* frees refused, block not taken from here */
+    uint32 free_map;            /* bit set = block free */
+} mem_pool;
+
+extern mem_pool mem_pool_packet;        /* uvc_packet, stream ring */
+extern mem_pool mem_pool_line;          /* one YUY2 line */
+extern mem_pool mem_pool_scratch;       /* control request scratch */
+
+#define MEM_NUM_POOLS           3
+
+void* mem_pool_alloc(mem_pool *pool);
+void mem_pool_free(mem_pool *pool, void *block);
+mem_pool* mem_pool_get(uint8 index);
+
+int mem_seal(void);
+uint32 mem_heap_growth(void);
+uint32 mem_stack_depth(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * OV2640 sensor bring-up, see ov2640.h
+ */
+
+#include <libmaple/delay.h>
+
+#include "ov2640.h"
+#include "ov2640_regs.h"
+#include "ov2640_delta.h"
+#include "sccb.h"
+#include "dwt.h"
+
+/* ov2640_delta.h is generated, make sure it still matches the mode list */
+typedef char ov2640_delta_modes_check[
+    (OV2640_DELTA_MODES == OV2640_NUM_MODES &&
+     OV2640_DELTA_MODE_YUY2_320x240 == OV2640_MODE_YUY2_320x240 &&
+     OV2640_DELTA_MODE_MJPEG_1600x1200 == OV2640_MODE_MJPEG_1600x1200 &&
+     OV2640_DELTA_MODE_RAW8_320x240 == OV2640_MODE_RAW8_320x240) ? 1 : -1];
+
+#define OV2640_MAX_MODE_TABLES  3
+
+static const sccb_reg * const mode_tables[OV2640_NUM_MODES][OV2640_MAX_MODE_TABLES + 1] = {
+    {OV2640_MODE_YUY2_320x240_TABLES, NULL},
+    {OV2640_MODE_MJPEG_1600x1200_TABLES, NULL},
+    {OV2640_MODE_RAW8_320x240_TABLES, NULL},
+};
+
+/* DSP input size and largest output of each mode */
+static const struct {
+    uint16 in_w, in_h;
+    uint16 out_w, out_h;
+} mode_geometry[OV2640_NUM_MODES] = {
+    {800, 600, 320, 240},           /* SVGA readout, output fixed by the YUY2 frame */
+    {1600, 1200, 1600, 1200},       /* UXGA readout */
+    {800, 600, 320, 240},           /* the YUY2 window, Bayer out of the DSP */
+};
+
+/* DSP window registers, bank 0 */
+#define DSP_CTRLI               0x50
+#define DSP_HSIZE               0x51
+#define DSP_VSIZE               0x52
+#define DSP_XOFFL               0x53
+#define DSP_YOFFL               0x54
+#define DSP_VHYX                0x55
+#define DSP_TEST                0x57
+#define DSP_ZMOW                0x5a
+#define DSP_ZMOH                0x5b
+#define DSP_ZMHH                0x5c
+#define DSP_RESET               0xe0
+#define DSP_RESET_DVP           0x04
+#define CTRLI_LP_DP             0x80
+#define MAX_DIV                 3
+
+static uint8 cur_mode = OV2640_MODE_UNKNOWN;
+static ov2640_window cur_roi = {0, 0, OV2640_UXGA_WIDTH, OV2640_UXGA_HEIGHT};
+static uint8 roi_active = 0;
+static uint32 init_us;
+static uint32 mode_us;
+
+/* exposure registers read by ov2640_poll_ae(), in this order */
+static const uint8 ae_regs[] = {OV2640_GAIN, OV2640_REG04, OV2640_AEC, OV2640_REG45, OV2640_YAVG};
+static uint8 ae_vals[sizeof(ae_regs)];
+static uint8 ae_next;
+
+static int ov2640Probe(void) {
+    uint8 pid;
+
+    if (sccb_write(SCCB_BANK_SEL, 0x01) != 0) {
+        return -1;
+    }
+    if (sccb_read(OV2640_CHIPID_HIGH, &pid) != 0 || pid != OV2640_PID) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Bring-up in two halves around the soft reset, so that a caller can do
+ * other work while the sensor comes out of it. init_us counts the time
+ * spent in both, not the wait between them.
+ */
+int ov2640_init_begin(void) {
+    uint32 start;
+    int ret;
+
+    dwt_enable();
+    start = dwt_cycles();
+
+    sccb_init(I2C1, OV2640_I2C_ADDR);
+    if (ov2640Probe() != 0) {
+        return -1;
+    }
+
+    ret = sccb_write_table(OV2640_RESET);
+    /* the reset puts the sensor back on the DSP bank; after a failed one
+     * neither the bank nor the mode is known */
+    sccb_invalidate_bank();
+    cur_mode = OV2640_MODE_UNKNOWN;
+
+    init_us = dwt_cycles_to_us(dwt_cycles() - start);
+    return ret;
+}
+
+/* At least OV2640_RESET_DELAY_US after ov2640_init_begin(). Leaves the
+ * mode unknown, the first ov2640_set_mode() writes its full tables. */
+int ov2640_init_finish(void) {
+    uint32 start = dwt_cycles();
+    int ret;
+
+    ret = sccb_write_table(OV2640_JPEG_INIT);
+    init_us += dwt_cycles_to_us(dwt_cycles() - start);
+    return ret;
+}
+
+int ov2640_init(void) {
+    if (ov2640_init_begin() != 0) {
+        return -1;
+    }
+    delay_us(OV2640_RESET_DELAY_US);
+    if (ov2640_init_finish() != 0 ||
+        ov2640_set_mode(OV2640_MODE_YUY2_320x240) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int roiIsFull(const ov2640_window *roi) {
+    return roi->x == 0 && roi->y == 0 &&
+        roi->w == OV2640_UXGA_WIDTH && roi->h == OV2640_UXGA_HEIGHT;
+}
+
+/*
+ * Map a UXGA region onto a mode: win is the DSP input window, out the
+ * zoom output. Sizes go in steps of 4, which is what the registers hold.
+ */
+static int roiGeometry(uint8 mode, const ov2640_window *roi,
+                       ov2640_window *win, ov2640_window *out) {
+    uint32 in_w = mode_geometry[mode].in_w;
+    uint32 in_h = mode_geometry[mode].in_h;
+    uint32 w, h;
+
+    if (roi->w == 0 || roi->h == 0 ||
+        roi->x + roi->w > OV2640_UXGA_WIDTH || roi->y + roi->h > OV2640_UXGA_HEIGHT) {
+        return -1;
+    }
+    win->x = (uint16)((roi->x * in_w / OV2640_UXGA_WIDTH) & ~3u);
+    win->y = (uint16)((roi->y * in_h / OV2640_UXGA_HEIGHT) & ~3u);
+    win->w = (uint16)((roi->w * in_w / OV2640_UXGA_WIDTH) & ~3u);
+    win->h = (uint16)((roi->h * in_h / OV2640_UXGA_HEIGHT) & ~3u);
+    if (win->w < 4 || win->h < 4) {
+        return -1;
+    }
+
+    /* scale down to fit the mode's frame, keeping the aspect ratio */
+    w = win->w;
+    h = win->h;
+    if (w > mode_geometry[mode].out_w) {
+        h = h * mode_geometry[mode].out_w / w;
+        w = mode_geometry[mode].out_w;
+    }
+    if (h > mode_geometry[mode].out_h) {
+        w = w * mode_geometry[mode].out_h / h;
+        h = mode_geometry[mode].out_h;
+    }
+    out->x = 0;
+    out->y = 0;
+    out->w = (uint16)(w & ~3u);
+    out->h = (uint16)(h & ~3u);
+    return (out->w == 0 || out->h == 0) ? -1 : 0;
+}
+
+/* Build the window and zoom writes for a region, terminated like any
+ * other register table */
+static int roiTable(uint8 mode, const ov2640_window *roi, sccb_reg *t) {
+    ov2640_window win, out;
+    uint16 hsize, vsize, zmow, zmoh;
+    uint8 hdiv = 0, vdiv = 0;
+
+    if (roiGeometry(mode, roi, &win, &out) != 0) {
+        return -1;
+    }
+    hsize = win.w >> 2;
+    vsize = win.h >> 2;
+    zmow = out.w >> 2;
+    zmoh = out.h >> 2;
+
+    /* pre-divide large windows, the zoom engine does the rest */
+    while (hdiv < MAX_DIV && (win.w >> (hdiv + 1)) >= out.w) {
+        hdiv++;
+    }
+    while (vdiv < MAX_DIV && (win.h >> (vdiv + 1)) >= out.h) {
+        vdiv++;
+    }
+
+    t[0].reg = SCCB_BANK_SEL;   t[0].val = 0x00;
+    t[1].reg = DSP_RESET;       t[1].val = DSP_RESET_DVP;
+    t[2].reg = DSP_CTRLI;
+    t[2].val = ((hdiv | vdiv) ? CTRLI_LP_DP : 0) | (vdiv << 3) | hdiv;
+    t[3].reg = DSP_HSIZE;       t[3].val = hsize & 0xff;
+    t[4].reg = DSP_VSIZE;       t[4].val = vsize & 0xff;
+    t[5].reg = DSP_XOFFL;       t[5].val = win.x & 0xff;
+    t[6].reg = DSP_YOFFL;       t[6].val = win.y & 0xff;
+    t[7].reg = DSP_VHYX;
+    t[7].val = ((vsize >> 1) & 0x80) | (((win.y >> 8) & 0x07) << 4) |
+        ((hsize >> 5) & 0x08) | ((win.x >> 8) & 0x07);
+    t[8].reg = DSP_TEST;        t[8].val = (hsize >> 2) & 0x80;
+    t[9].reg = DSP_ZMOW;        t[9].val = zmow & 0xff;
+    t[10].reg = DSP_ZMOH;       t[10].val = zmoh & 0xff;
+    t[11].reg = DSP_ZMHH;
+    t[11].val = ((zmoh >> 6) & 0x04) | ((zmow >> 8) & 0x03);
+    t[12].reg = DSP_RESET;      t[12].val = 0x00;
+    t[13].reg = SCCB_REG_END;   t[13].val = SCCB_REG_END;
+    return 0;
+}
+
+static int roiApply(void) {
+    sccb_reg table[OV2640_ROI_TABLE_LEN];
+
+    if (roiTable(cur_mode, &cur_roi, table) != 0) {
+        return -1;
+    }
+    return sccb_write_table(table);
+}
+
+int ov2640_set_mode(uint8 mode) {
+    const sccb_reg * const *table;
+    uint32 start;
+    int ret = 0;
+
+    if (mode >= OV2640_NUM_MODES) {
+        return -1;
+    }
+    if (mode == cur_mode) {
+        return 0;
+    }
+
+    start = dwt_cycles();
+    /* the deltas assume the stock window of the current mode */
+    if (cur_mode != OV2640_MODE_UNKNOWN && !roi_active) {
+        ret = sccb_write_table(OV2640_DELTA[cur_mode][mode]);
+    } else {
+        for (table = mode_tables[mode]; *table != NULL; table++) {
+            if (sccb_write_table(*table) != 0) {
+                ret = -1;
+            }
+        }
+    }
+    cur_mode = mode;
+    if (ret == 0 && roi_active && roiApply() != 0) {
+        ret = -1;
+    }
+    mode_us = dwt_cycles_to_us(dwt_cycles() - start);
+
+    /* after a failed write the register state is anybody's guess, the
+     * next switch programs the full mode tables again */
+    if (ret != 0) {
+        cur_mode = OV2640_MODE_UNKNOWN;
+    }
+    return ret;
+}
+
+/*
+ * Crop the sensor to a region of interest. The region stays in effect
+ * across mode switches, so it has to map onto every mode; the full
+ * array brings back the stock window.
+ */
+int ov2640_set_roi(const ov2640_window *roi) {
+    ov2640_window win, out;
+    uint8 mode = cur_mode;
+    uint8 m;
+
+    if (mode == OV2640_MODE_UNKNOWN) {
+        return -1;
+    }
+    for (m = 0; m < OV2640_NUM_MODES; m++) {
+        if (roiGeometry(m, roi, &win, &out) != 0) {
+            return -1;
+        }
+    }
+    cur_roi = *roi;
+
+    if (roiIsFull(roi)) {
+        if (!roi_active) {
+            return 0;
+        }
+        /* reload the mode tables rather than guessing the stock window */
+        roi_active = 0;
+        cur_mode = OV2640_MODE_UNKNOWN;
+        return ov2640_set_mode(mode);
+    }
+
+    roi_active = 1;
+    if (roiApply() != 0) {
+        cur_mode = OV2640_MODE_UNKNOWN;
+        return -1;
+    }
+    return 0;
+}
+
+/* Output frame size of a mode with the current region of interest */
+int ov2640_output_size(uint8 mode, ov2640_window *out) {
+    ov2640_window win;
+
+    if (mode >= OV2640_NUM_MODES) {
+        return -1;
+    }
+    return roiGeometry(mode, &cur_roi, &win, out);
+}
+
+uint8 ov2640_get_mode(void) {
+    return cur_mode;
+}
+
+/* Registers were written behind our back, the next switch programs the
+ * full mode tables instead of a delta */
+void ov2640_invalidate_mode(void) {
+    cur_mode = OV2640_MODE_UNKNOWN;
+}
+
+/*
+ * Read the sensor's own exposure state one register per call, so the
+ * reads can be spread over short time slots. A call that has to select
+ * the sensor bank first leaves the read to the next one, no call puts
+ * more than one register access on the bus. Returns 1 when ae holds a
+ * new complete set, 0 while reading and -1 on a bus error, after which
+ * the set starts over.
+ */
+int ov2640_poll_ae(ov2640_ae *ae) {
+    uint16 writes = sccb_get_stats()->writes;
+
+    if (sccb_select_bank(0x01) != 0) {
+        ae_next = 0;
+        return -1;
+    }
+    if (sccb_get_stats()->writes != writes) {
+        return 0;
+    }
+    if (sccb_read(ae_regs[ae_next], &ae_vals[ae_next]) != 0) {
+        ae_next = 0;
+        return -1;
+    }
+    if (++ae_next < sizeof(ae_regs)) {
+        return 0;
+    }
+    ae_next = 0;
+
+    ae->gain = ae_vals[0];
+    ae->exposure = (uint16)(((ae_vals[3] & 0x3F) << 10) | (ae_vals[2] << 2) | (ae_vals[1] & 0x03));
+    ae->y_avg = ae_vals[4];
+    return 1;
+}
+
+uint32 ov2640_init_us(void) {
+    return init_us;
+}
+
+uint32 ov2640_mode_us(void) {
+    return mode_us;
+}
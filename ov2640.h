@@ -0,0 +1,74 @@
+/*
+ * OV2640 sensor bring-up over SCCB
+ */
+
+#ifndef _OV2640_H_
+#define _OV2640_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OV2640_I2C_ADDR         0x30
+
+/* sensor bank */
+#define OV2640_CHIPID_HIGH      0x0A
+#define OV2640_CHIPID_LOW       0x0B
+#define OV2640_PID              0x26
+
+/* sensor bank exposure registers */
+#define OV2640_GAIN             0x00
+#define OV2640_REG04            0x04    /* AEC[1:0] */
+#define OV2640_AEC              0x10    /* AEC[9:2] */
+#define OV2640_YAVG             0x2F    /* average luma the AEC works from */
+#define OV2640_REG45            0x45    /* AEC[15:10] */
+
+/* time the sensor needs after a soft reset before it accepts writes */
+#define OV2640_RESET_DELAY_US   5000
+
+/* sensor modes, in the order of the OV2640_MODE_*_TABLES in ov2640_regs.h */
+#define OV2640_MODE_YUY2_320x240        0
+#define OV2640_MODE_MJPEG_1600x1200     1
+#define OV2640_MODE_RAW8_320x240        2
+#define OV2640_NUM_MODES                3
+#define OV2640_MODE_UNKNOWN             0xFF
+
+/* window coordinates are in pixels of the full UXGA sensor array */
+#define OV2640_UXGA_WIDTH       1600
+#define OV2640_UXGA_HEIGHT      1200
+
+typedef struct ov2640_window {
+    uint16 x;
+    uint16 y;
+    uint16 w;
+    uint16 h;
+} ov2640_window;
+
+typedef struct ov2640_ae {
+    uint16 exposure;            /* in lines */
+    uint8 gain;
+    uint8 y_avg;
+} ov2640_ae;
+
+/* bank select, DSP reset, 10 window/zoom registers, reset release, end */
+#define OV2640_ROI_TABLE_LEN    14
+
+int ov2640_init(void);
+int ov2640_init_begin(void);
+int ov2640_init_finish(void);
+int ov2640_set_mode(uint8 mode);
+uint8 ov2640_get_mode(void);
+void ov2640_invalidate_mode(void);
+int ov2640_set_roi(const ov2640_window *roi);
+int ov2640_output_size(uint8 mode, ov2640_window *out);
+int ov2640_poll_ae(ov2640_ae *ae);
+uint32 ov2640_init_us(void);
+uint32 ov2640_mode_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * OV2640 mode switch tables
+ *
+ * generated by tools/ov2640_delta.py from ov2640_regs.h, do not edit.
+ * OV2640_DELTA[from][to] takes the sensor from one mode to another.
+ */
+
+#ifndef _OV2640_DELTA_H_
+#define _OV2640_DELTA_H_
+
+#include "sccb.h"
+
+#define OV2640_DELTA_MODE_YUY2_320x240         0
+#define OV2640_DELTA_MODE_MJPEG_1600x1200      1
+#define OV2640_DELTA_MODE_RAW8_320x240         2
+#define OV2640_DELTA_MODES 3
+
+/* 34 register writes */
+static const sccb_reg OV2640_DELTA_YUY2_320x240_TO_MJPEG_1600x1200[] = {
+    {0xff, 0x01},
+    {0x12, 0x00},
+    {0x04, 0x08},
+    {0x11, 0x01},
+    {0x18, 0x75},
+    {0x32, 0x36},
+    {0x19, 0x01},
+    {0x1a, 0x97},
+    {0x03, 0x0f},
+    {0x4f, 0xbb},
+    {0x50, 0x9c},
+    {0x5a, 0x57},
+    {0x6d, 0x80},
+    {0x3d, 0x34},
+    {0x39, 0x02},
+    {0x35, 0x88},
+    {0x22, 0x0a},
+    {0x37, 0x40},
+    {0x34, 0xa0},
+    {0x06, 0x02},
+    {0x0d, 0xb7},
+    {0x0e, 0x01},
+    {0xff, 0x00},
+    {0xe0, 0x14},
+    {0xc0, 0xc8},
+    {0xc1, 0x96},
+    {0x86, 0x3d},
+    {0x50, 0x00},
+    {0x51, 0x90},
+    {0x52, 0x2c},
+    {0x55, 0x88},
+    {0x5a, 0x90},
+    {0x5b, 0x2c},
+    {0x5c, 0x05},
+    {0xd3, 0x82},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+/* 3 register writes */
+static const sccb_reg OV2640_DELTA_YUY2_320x240_TO_RAW8_320x240[] = {
+    {0xff, 0x00},
+    {0xe0, 0x04},
+    {0xda, 0x04},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+/* 34 register writes */
+static const sccb_reg OV2640_DELTA_MJPEG_1600x1200_TO_YUY2_320x240[] = {
+    {0xff, 0x01},
+    {0x12, 0x40},
+    {0x11, 0x00},
+    {0x04, 0x28},
+    {0x3d, 0x38},
+    {0x18, 0x43},
+    {0x19, 0x00},
+    {0x1a, 0x4b},
+    {0x32, 0x09},
+    {0x03, 0x0a},
+    {0x4f, 0xca},
+    {0x50, 0xa8},
+    {0x5a, 0x23},
+    {0x6d, 0x00},
+    {0x39, 0x12},
+    {0x35, 0xda},
+    {0x22, 0x1a},
+    {0x37, 0xc3},
+    {0x34, 0xc0},
+    {0x06, 0x88},
+    {0x0d, 0x87},
+    {0x0e, 0x41},
+    {0xff, 0x00},
+    {0xe0, 0x04},
+    {0xd3, 0x04},
+    {0xc0, 0x64},
+    {0xc1, 0x4b},
+    {0x86, 0x35},
+    {0x50, 0x89},
+    {0x51, 0xc8},
+    {0x52, 0x96},
+    {0x55, 0x00},
+    {0x5a, 0x50},
+    {0x5b, 0x3c},
+    {0x5c, 0x00},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+/* 35 register writes */
+static const sccb_reg OV2640_DELTA_MJPEG_1600x1200_TO_RAW8_320x240[] = {
+    {0xff, 0x01},
+    {0x12, 0x40},
+    {0x11, 0x00},
+    {0x04, 0x28},
+    {0x3d, 0x38},
+    {0x18, 0x43},
+    {0x19, 0x00},
+    {0x1a, 0x4b},
+    {0x32, 0x09},
+    {0x03, 0x0a},
+    {0x4f, 0xca},
+    {0x50, 0xa8},
+    {0x5a, 0x23},
+    {0x6d, 0x00},
+    {0x39, 0x12},
+    {0x35, 0xda},
+    {0x22, 0x1a},
+    {0x37, 0xc3},
+    {0x34, 0xc0},
+    {0x06, 0x88},
+    {0x0d, 0x87},
+    {0x0e, 0x41},
+    {0xff, 0x00},
+    {0xe0, 0x04},
+    {0xd3, 0x04},
+    {0xda, 0x04},
+    {0xc0, 0x64},
+    {0xc1, 0x4b},
+    {0x86, 0x35},
+    {0x50, 0x89},
+    {0x51, 0xc8},
+    {0x52, 0x96},
+    {0x55, 0x00},
+    {0x5a, 0x50},
+    {0x5b, 0x3c},
+    {0x5c, 0x00},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+/* 3 register writes */
+static const sccb_reg OV2640_DELTA_RAW8_320x240_TO_YUY2_320x240[] = {
+    {0xff, 0x00},
+    {0xe0, 0x04},
+    {0xda, 0x10},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+/* 35 register writes */
+static const sccb_reg OV2640_DELTA_RAW8_320x240_TO_MJPEG_1600x1200[] = {
+    {0xff, 0x01},
+    {0x12, 0x00},
+    {0x04, 0x08},
+    {0x11, 0x01},
+    {0x18, 0x75},
+    {0x32, 0x36},
+    {0x19, 0x01},
+    {0x1a, 0x97},
+    {0x03, 0x0f},
+    {0x4f, 0xbb},
+    {0x50, 0x9c},
+    {0x5a, 0x57},
+    {0x6d, 0x80},
+    {0x3d, 0x34},
+    {0x39, 0x02},
+    {0x35, 0x88},
+    {0x22, 0x0a},
+    {0x37, 0x40},
+    {0x34, 0xa0},
+    {0x06, 0x02},
+    {0x0d, 0xb7},
+    {0x0e, 0x01},
+    {0xff, 0x00},
+    {0xe0, 0x14},
+    {0xda, 0x10},
+    {0xc0, 0xc8},
+    {0xc1, 0x96},
+    {0x86, 0x3d},
+    {0x50, 0x00},
+    {0x51, 0x90},
+    {0x52, 0x2c},
+    {0x55, 0x88},
+    {0x5a, 0x90},
+    {0x5b, 0x2c},
+    {0x5c, 0x05},
+    {0xd3, 0x82},
+    {0xe0, 0x00},
+    {0xff, 0xff},
+};
+
+static const sccb_reg * const OV2640_DELTA[OV2640_DELTA_MODES][OV2640_DELTA_MODES] = {
+    {NULL, OV2640_DELTA_YUY2_320x240_TO_MJPEG_1600x1200, OV2640_DELTA_YUY2_320x240_TO_RAW8_320x240},
+    {OV2640_DELTA_MJPEG_1600x1200_TO_YUY2_320x240, NULL, OV2640_DELTA_MJPEG_1600x1200_TO_RAW8_320x240},
+    {OV2640_DELTA_RAW8_320x240_TO_YUY2_320x240, OV2640_DELTA_RAW8_320x240_TO_MJPEG_1600x1200, NULL},
+};
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Run selected hot paths from SRAM
+ *
+ * At 72 MHz the F103 fetches from flash with two wait states. A function
+ * marked RAMFUNC(sel, name) with its selector set to 1 is put in a
+ * .data.ramfunc.<name> section, which the libmaple linker scripts
+ * collect into .data: the startup code copies it to SRAM with the rest
+ * of the initialised data. The cost shows up in the linker map under
+ * the same section names, tools/ramfunc_report.py sums it up.
+ *
+ * Override a selector with 0 (for example in the board's build flags)
+ * to keep that function in flash.
+ */
+
+#ifndef _RAMFUNC_H_
+#define _RAMFUNC_H_
+
+/* endpoint refill, called for every streaming packet */
+#ifndef RAMFUNC_STREAM_TX
+#define RAMFUNC_STREAM_TX       1
+#endif
+
+/* PMA copy kernels */
+#ifndef RAMFUNC_PMA_WRITE
+#define RAMFUNC_PMA_WRITE       1
+#endif
+
+/* payload framing, the ArduCAM burst read loop and the test pattern
+ * source that stands in for it */
+#ifndef RAMFUNC_STREAM_DRAIN
+#define RAMFUNC_STREAM_DRAIN    1
+#endif
+
+/* SRAM is out of BL range of flash: callers in the same file load the
+ * address into a register, the linker adds veneers for the others.
+ * Host builds of the same sources (tools/) keep everything in .text. */
+#ifdef __arm__
+#define RAMFUNC_ATTR(name) \
+    __attribute__((section(".data.ramfunc." #name), noinline, long_call))
+#else
+#define RAMFUNC_ATTR(name)
+#endif
+
+#define RAMFUNC(sel, name)      RAMFUNC_SEL_(sel, name)
+#define RAMFUNC_SEL_(sel, name) RAMFUNC_SEL_##sel(name)
+#define RAMFUNC_SEL_1(name)     RAMFUNC_ATTR(name)
+#define RAMFUNC_SEL_0(name)
+
+#endif
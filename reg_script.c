@@ -0,0 +1,172 @@
+/*
+ * Sensor register scripts, see reg_script.h
+ */
+
+#include <libmaple/delay.h>
+
+#include "reg_script.h"
+#include "usb_uvc.h"
+#include "sccb.h"
+#include "ov2640.h"
+#include "mem_pool.h"
+#include "trace.h"
+
+/* both from mem_pool_scratch */
+static uint8 *rx_buf;
+static uint8 *reply;
+
+static uint8 status;
+static uint8 nread;
+static uint16 executed;
+static uint8 reply_pending;
+static int rx_len = -1;                 /* packet being worked through */
+static uint16 rx_off;
+static uint8 ops_per_poll = REG_SCRIPT_OPS_PER_POLL;
+
+int reg_script_init(void) {
+    if (rx_buf == NULL) {
+        rx_buf = (uint8*)mem_pool_alloc(&mem_pool_scratch);
+    }
+    if (reply == NULL) {
+        reply = (uint8*)mem_pool_alloc(&mem_pool_scratch);
+    }
+    return (rx_buf != NULL && reply != NULL) ? 0 : -1;
+}
+
+static void scriptFail(uint8 error) {
+    if (status == REG_SCRIPT_OK) {
+        status = error;
+    }
+}
+
+static int flushWrites(sccb_reg *table, uint8 *n) {
+    int ret = 0;
+
+    if (*n == 0) {
+        return 0;
+    }
+    table[*n].reg = SCCB_REG_END;
+    table[*n].val = SCCB_REG_END;
+    ov2640_invalidate_mode();
+    if (sccb_write_table(table) != 0) {
+        scriptFail(REG_SCRIPT_EBUS);
+        ret = -1;
+    } else {
+        executed += *n;
+    }
+    *n = 0;
+    return ret;
+}
+
+static void scriptRun(const uint8 *ops, uint16 len) {
+    sccb_reg table[REG_SCRIPT_OPS_PER_POLL + 1];
+    uint8 nwrites = 0;
+    uint16 i;
+
+    for (i = 0; i < len && status == REG_SCRIPT_OK; i += REG_SCRIPT_OP_SIZE) {
+        const uint8 *op = ops + i;
+
+        if (op[0] == REG_SCRIPT_WRITE) {
+            table[nwrites].reg = op[1];
+            table[nwrites].val = op[2];
+            nwrites++;
+            continue;
+        }
+        if (flushWrites(table, &nwrites) != 0) {
+            return;
+        }
+
+        switch (op[0]) {
+        case REG_SCRIPT_READ:
+            if (nread == REG_SCRIPT_MAX_READS) {
+                scriptFail(REG_SCRIPT_EREADS);
+            } else if (sccb_read(op[1], &reply[REG_SCRIPT_REPLY_HEADER + nread]) != 0) {
+                scriptFail(REG_SCRIPT_EBUS);
+            } else {
+                nread++;
+                executed++;
+            }
+            break;
+        case REG_SCRIPT_TRACE:
+            nread += trace_read(&reply[REG_SCRIPT_REPLY_HEADER + nread],
+                                (REG_SCRIPT_MAX_READS - nread) / TRACE_ENTRY_SIZE) *
+                TRACE_ENTRY_SIZE;
+            executed++;
+            break;
+        case REG_SCRIPT_TRACE_MASK:
+            trace_set_mask(op[2]);
+            executed++;
+            break;
+        case REG_SCRIPT_DELAY:
+            delay_us((uint32)op[3] * 1000);
+            executed++;
+            break;
+        default:
+            scriptFail(REG_SCRIPT_EOP);
+            break;
+        }
+    }
+    flushWrites(table, &nwrites);
+}
+
+void reg_script_poll(void) {
+    uint16 n;
+
+    if (rx_buf == NULL) {
+        return;
+    }
+    /* hold further requests back until the host has taken the reply */
+    if (reply_pending) {
+        if (usb_uvc_vendor_write(reply, REG_SCRIPT_REPLY_HEADER + nread) != 0) {
+            return;
+        }
+        reply_pending = 0;
+        status = REG_SCRIPT_OK;
+        nread = 0;
+        executed = 0;
+    }
+
+    if (rx_len < 0) {
+        rx_len = usb_uvc_vendor_read(rx_buf);
+        if (rx_len < 0) {
+            return;
+        }
+        rx_off = 0;
+        if (rx_len % REG_SCRIPT_OP_SIZE) {
+            scriptFail(REG_SCRIPT_EOP);
+        }
+    }
+
+    n = (uint16)rx_len - rx_off;
+    if (n > ops_per_poll * REG_SCRIPT_OP_SIZE) {
+        n = ops_per_poll * REG_SCRIPT_OP_SIZE;
+    }
+    if (n > 0 && status == REG_SCRIPT_OK) {
+        scriptRun(rx_buf + rx_off, n);
+    }
+    rx_off += n;
+    if (rx_off < rx_len && status == REG_SCRIPT_OK) {
+        return;
+    }
+
+    if (rx_len < USB_RX_EPSIZE) {
+        reply[0] = status;
+        reply[1] = nread;
+        reply[2] = (uint8)executed;
+        reply[3] = (uint8)(executed >> 8);
+        reply_pending = 1;
+    }
+    rx_len = -1;
+}
+
+/* Fewer operations per poll for a shorter task, at most the build value */
+void reg_script_set_ops(uint8 ops) {
+    if (ops == 0 || ops > REG_SCRIPT_OPS_PER_POLL) {
+        ops = REG_SCRIPT_OPS_PER_POLL;
+    }
+    ops_per_poll = ops;
+}
+
+uint8 reg_script_get_ops(void) {
+    return ops_per_poll;
+}
@@ -0,0 +1,66 @@
+/*
+ * Sensor register scripts over the vendor bulk interface
+ *
+ * A script is a bulk OUT transfer of 4-byte operations, 16 to a packet,
+ * ended by a short or zero-length packet. Each reg_script_poll() works
+ * through reg_script_set_ops() operations, runs of writes among them
+ * go out as one batched sccb_write_table(). Once the script has ended,
+ * a single reply packet comes back on the vendor IN endpoint:
+ *
+ *   [0]    status, REG_SCRIPT_*
+ *   [1]    number of values read
+ *   [2..3] operations executed, little endian
+ *   [4..]  the values read, in script order
+ *
+ * After an error the rest of the script is skipped, the reply still
+ * comes at its end. Scripts that write bypass the mode bookkeeping in
+ * ov2640.c, the next mode switch reloads the full tables.
+ *
+ * The same scripts drain the event trace of trace.h: a TRACE operation
+ * appends as many whole 8-byte events as still fit among the values.
+ */
+
+#ifndef _REG_SCRIPT_H_
+#define _REG_SCRIPT_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* operations: {op, reg, val, arg} */
+#define REG_SCRIPT_WRITE        0x00    /* reg = val, 0xFF selects the bank */
+#define REG_SCRIPT_READ         0x01    /* append reg to the reply */
+#define REG_SCRIPT_DELAY        0x02    /* wait arg milliseconds */
+#define REG_SCRIPT_TRACE        0x03    /* append trace events */
+#define REG_SCRIPT_TRACE_MASK   0x04    /* record the TRACE_CLASS_* in val */
+
+#define REG_SCRIPT_OP_SIZE      4
+#define REG_SCRIPT_REPLY_HEADER 4
+#define REG_SCRIPT_MAX_READS    60
+
+/* operations per reg_script_poll(), a read about 100 us on a 400 kHz
+ * bus; two and the control task's AE read fit in the time a full
+ * packet ring lasts on the bus, see usb_datachannel.cpp. The most
+ * reg_script_set_ops() allows. */
+#ifndef REG_SCRIPT_OPS_PER_POLL
+#define REG_SCRIPT_OPS_PER_POLL 2
+#endif
+
+/* reply status */
+#define REG_SCRIPT_OK           0x00
+#define REG_SCRIPT_EBUS         0x01    /* SCCB transfer failed */
+#define REG_SCRIPT_EOP          0x02    /* unknown operation or torn packet */
+#define REG_SCRIPT_EREADS       0x03    /* more than REG_SCRIPT_MAX_READS reads */
+
+int reg_script_init(void);
+void reg_script_poll(void);
+void reg_script_set_ops(uint8 ops);
+uint8 reg_script_get_ops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
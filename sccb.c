@@ -0,0 +1,152 @@
+/*
+ * SCCB register engine, see sccb.h
+ *
+ * The libmaple i2c driver runs a whole message list from the event and
+ * error interrupts, so a batch of register writes costs one call and no
+ * per-register polling. SCCB does not support register auto-increment,
+ * every write is its own 2-byte message.
+ */
+
+#include "sccb.h"
+#include "dwt.h"
+
+static i2c_dev *sccb_dev;
+static uint8 sccb_addr;
+static uint8 sccb_bank = SCCB_BANK_UNKNOWN;
+static sccb_stats stats;
+
+static i2c_msg batch_msgs[SCCB_BATCH];
+static uint8 batch_data[SCCB_BATCH][2];
+static uint8 batch_len;
+
+void sccb_init(i2c_dev *dev, uint8 addr) {
+    sccb_dev = dev;
+    sccb_addr = addr;
+    sccb_bank = SCCB_BANK_UNKNOWN;
+
+    i2c_master_enable(dev, I2C_FAST_MODE | I2C_BUS_RESET);
+}
+
+static int sccbXfer(i2c_msg *msgs, uint16 num) {
+    if (i2c_master_xfer(sccb_dev, msgs, num, SCCB_TIMEOUT_MS) != 0) {
+        stats.bus_errors++;
+        sccb_bank = SCCB_BANK_UNKNOWN;
+        return -1;
+    }
+    return 0;
+}
+
+int sccb_write(uint8 reg, uint8 val) {
+    uint8 data[2] = {reg, val};
+    i2c_msg msg = {
+        .addr    = sccb_addr,
+        .flags   = 0,
+        .length  = 2,
+        .xferred = 0,
+        .data    = data,
+    };
+
+    if (sccbXfer(&msg, 1) != 0) {
+        return -1;
+    }
+    stats.writes++;
+    if (reg == SCCB_BANK_SEL) {
+        sccb_bank = val;
+    }
+    return 0;
+}
+
+int sccb_read(uint8 reg, uint8 *val) {
+    /* SCCB needs a stop between the address phase and the read phase,
+     * so this has to be two separate transfers */
+    i2c_msg msg = {
+        .addr    = sccb_addr,
+        .flags   = 0,
+        .length  = 1,
+        .xferred = 0,
+        .data    = &reg,
+    };
+
+    if (sccbXfer(&msg, 1) != 0) {
+        return -1;
+    }
+    msg.flags = I2C_MSG_READ;
+    msg.data = val;
+    msg.xferred = 0;
+    return sccbXfer(&msg, 1);
+}
+
+static int batchFlush(void) {
+    int ret;
+
+    if (batch_len == 0) {
+        return 0;
+    }
+    ret = sccbXfer(batch_msgs, batch_len);
+    if (ret == 0) {
+        stats.writes += batch_len;
+    }
+    batch_len = 0;
+    return ret;
+}
+
+static void batchAdd(uint8 reg, uint8 val) {
+    i2c_msg *msg = &batch_msgs[batch_len];
+
+    batch_data[batch_len][0] = reg;
+    batch_data[batch_len][1] = val;
+    msg->addr = sccb_addr;
+    msg->flags = 0;
+    msg->length = 2;
+    msg->xferred = 0;
+    msg->data = batch_data[batch_len];
+    batch_len++;
+}
+
+int sccb_write_table(const sccb_reg *table) {
+    uint32 start = dwt_cycles();
+    int ret = 0;
+
+    batch_len = 0;
+    for (; table->reg != SCCB_REG_END || table->val != SCCB_REG_END; table++) {
+        if (table->reg == SCCB_BANK_SEL) {
+            if (table->val == sccb_bank) {
+                stats.bank_skips++;
+                continue;
+            }
+            /* a batch never spans two banks */
+            if (batchFlush() != 0) {
+                ret = -1;
+            }
+            sccb_bank = table->val;
+        } else if (batch_len == SCCB_BATCH) {
+            if (batchFlush() != 0) {
+                ret = -1;
+            }
+        }
+        batchAdd(table->reg, table->val);
+    }
+    if (batchFlush() != 0) {
+        ret = -1;
+    }
+
+    stats.table_us = dwt_cycles_to_us(dwt_cycles() - start);
+    return ret;
+}
+
+/* Select a register bank, nothing goes on the bus if it is active */
+int sccb_select_bank(uint8 bank) {
+    if (bank == sccb_bank) {
+        stats.bank_skips++;
+        return 0;
+    }
+    return sccb_write(SCCB_BANK_SEL, bank);
+}
+
+void sccb_invalidate_bank(void) {
+    sccb_bank = SCCB_BANK_UNKNOWN;
+}
+
+const sccb_stats* sccb_get_stats(void) {
+    return &stats;
+}
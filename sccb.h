@@ -0,0 +1,55 @@
+/*
+ * SCCB (I2C) register engine for the OV2640.
+ *
+ * Register tables are arrays of sccb_reg terminated by
+ * {SCCB_REG_END, SCCB_REG_END}, the same layout the ArduCAM library
+ * uses. sccb_write_table() groups the writes of one register bank into
+ * a single interrupt-driven i2c transfer and drops bank selects that
+ * would not change the active bank.
+ */
+
+#ifndef _SCCB_H_
+#define _SCCB_H_
+
+#include <libmaple/libmaple_types.h>
+#include <libmaple/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sccb_reg {
+    uint8 reg;
+    uint8 val;
+} sccb_reg;
+
+#define SCCB_REG_END            0xFF
+
+/* OV2640 register 0xFF selects between the DSP (0) and sensor (1) banks */
+#define SCCB_BANK_SEL           0xFF
+#define SCCB_BANK_UNKNOWN       0xFF
+
+/* writes per i2c transfer, a bank select always starts a new one */
+#define SCCB_BATCH              16
+#define SCCB_TIMEOUT_MS         20
+
+typedef struct sccb_stats {
+    uint32 table_us;            /* duration of the last sccb_write_table() */
+    uint16 writes;              /* register writes put on the bus */
+    uint16 bank_skips;          /* redundant bank selects dropped */
+    uint16 bus_errors;          /* failed i2c transfers */
+} sccb_stats;
+
+void sccb_init(i2c_dev *dev, uint8 addr);
+int sccb_write(uint8 reg, uint8 val);
+int sccb_read(uint8 reg, uint8 *val);
+int sccb_write_table(const sccb_reg *table);
+int sccb_select_bank(uint8 bank);
+void sccb_invalidate_bank(void);
+const sccb_stats* sccb_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
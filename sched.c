@@ -0,0 +1,122 @@
+/*
+ * Cooperative scheduler, see sched.h
+ */
+
+#include "sched.h"
+
+static sched_task *tasks[SCHED_MAX_TASKS];     /* by priority */
+static uint8 num_tasks;
+static sched_clock clock_us;
+static uint8 exempt;            /* set by the task running now */
+
+void sched_init(sched_clock clock) {
+    clock_us = clock;
+    num_tasks = 0;
+}
+
+/* Worst-case round: every task due and using its whole budget */
+static uint32 roundBudget(const sched_task *extra) {
+    uint32 sum = extra ? extra->budget_us : 0;
+    uint8 i;
+
+    for (i = 0; i < num_tasks; i++) {
+        sum += tasks[i]->budget_us;
+    }
+    return sum;
+}
+
+int sched_add(sched_task *task) {
+    uint32 round = roundBudget(task);
+    uint8 i;
+
+    if (num_tasks == SCHED_MAX_TASKS || task->run == NULL) {
+        return -1;
+    }
+    if (task->deadline_us != 0 && round > task->deadline_us) {
+        return -1;
+    }
+    for (i = 0; i < num_tasks; i++) {
+        if (tasks[i]->deadline_us != 0 && round > tasks[i]->deadline_us) {
+            return -1;
+        }
+    }
+
+    i = num_tasks;
+    while (i > 0 && tasks[i - 1]->priority > task->priority) {
+        tasks[i] = tasks[i - 1];
+        i--;
+    }
+    tasks[i] = task;
+    num_tasks++;
+
+    task->last_start = clock_us();
+    task->runs = 0;
+    task->overruns = 0;
+    task->misses = 0;
+    task->exempt = 0;
+    task->max_run_us = 0;
+    task->max_gap_us = 0;
+    return 0;
+}
+
+static void taskRun(sched_task *task, uint32 now) {
+    uint32 gap = now - task->last_start;
+    uint32 elapsed;
+
+    if (task->runs != 0) {
+        if (gap > task->max_gap_us) {
+            task->max_gap_us = gap;
+        }
+        if (task->deadline_us != 0 && gap > task->deadline_us) {
+            task->misses++;
+        }
+    }
+    task->last_start = now;
+
+    exempt = 0;
+    task->run();
+
+    elapsed = clock_us() - now;
+    task->runs++;
+    if (exempt) {
+        uint8 i;
+
+        task->exempt++;
+        now = clock_us();
+        for (i = 0; i < num_tasks; i++) {
+            tasks[i]->last_start = now;
+        }
+        return;
+    }
+    if (elapsed > task->max_run_us) {
+        task->max_run_us = elapsed;
+    }
+    if (elapsed > task->budget_us) {
+        task->overruns++;
+    }
+}
+
+void sched_run(void) {
+    uint8 i;
+
+    for (i = 0; i < num_tasks; i++) {
+        sched_task *task = tasks[i];
+        uint32 now = clock_us();
+
+        if (task->runs == 0 || now - task->last_start >= task->period_us) {
+            taskRun(task, now);
+        }
+    }
+}
+
+void sched_exempt(void) {
+    exempt = 1;
+}
+
+uint8 sched_num_tasks(void) {
+    return num_tasks;
+}
+
+sched_task* sched_get_task(uint8 index) {
+    return (index < num_tasks) ? tasks[index] : NULL;
+}
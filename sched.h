@@ -0,0 +1,65 @@
+/*
+ * Cooperative run-to-completion scheduler
+ *
+ * Tasks never preempt each other. sched_run() runs one round: every
+ * task that is due, once, highest priority first. A round is as long as
+ * the tasks in it, so the budgets of all tasks together bound how long
+ * any task waits for its next turn; sched_add() refuses a task whose
+ * budget would push a higher-priority task past its deadline.
+ *
+ * Each run is timed against the task's budget, and the gap between two
+ * starts against its deadline. Overruns and misses are counted, not
+ * acted on. A task that does long work only while nobody can miss a
+ * deadline, such as a sensor mode switch with the stream stopped, calls
+ * sched_exempt() from that run: it is not held against the budget and
+ * every gap restarts after it.
+ *
+ * Nothing here touches the hardware. The clock comes from
+ * sched_init(), so the same code runs on the host with a virtual clock,
+ * see tools/sched_sim.c.
+ */
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCHED_MAX_TASKS         8
+
+typedef struct sched_task {
+    const char *name;
+    void (*run)(void);
+    uint8 priority;             /* 0 runs first */
+    uint32 period_us;           /* 0: every round */
+    uint32 budget_us;           /* longest a single run should take */
+    uint32 deadline_us;         /* longest gap between two starts, 0: none */
+
+    /* kept by the scheduler */
+    uint32 last_start;
+    uint32 runs;
+    uint32 overruns;            /* runs longer than budget_us */
+    uint32 misses;              /* starts later than deadline_us */
+    uint32 exempt;              /* runs that called sched_exempt() */
+    uint32 max_run_us;
+    uint32 max_gap_us;
+} sched_task;
+
+/* microseconds, free running, wraps at 2^32 */
+typedef uint32 (*sched_clock)(void);
+
+void sched_init(sched_clock clock);
+int sched_add(sched_task *task);
+void sched_run(void);
+void sched_exempt(void);
+uint8 sched_num_tasks(void);
+sched_task* sched_get_task(uint8 index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Synthetic frame source, see test_pattern.h
+ */
+
+#include "test_pattern.h"
+#include "test_pattern_jpeg.h"
+#include "ramfunc.h"
+
+/* 100% bars, BT.601 studio range */
+const uint8 test_pattern_bars[TEST_PATTERN_BAR_COUNT][4] = {
+    {235, 128, 235, 128},       /* white */
+    {210,  16, 210, 146},       /* yellow */
+    {170, 166, 170,  16},       /* cyan */
+    {145,  54, 145,  34},       /* green */
+    {106, 202, 106, 222},       /* magenta */
+    { 81,  90,  81, 240},       /* red */
+    { 41, 240,  41, 110},       /* blue */
+    { 16, 128,  16, 128},       /* black */
+};
+
+static uint8 pattern;
+static uint16 line_bytes;
+static uint16 bar_bytes;
+static uint16 height;
+static uint32 length;
+static uint32 next_seq;         /* sequence number of the next frame taken */
+static uint32 first_seq;        /* of the first frame of this capture */
+
+/* read position */
+static uint32 seq;
+static uint32 frame_len;
+static uint32 offset;
+
+uint32 test_pattern_frame_length(uint32 n) {
+    switch (pattern) {
+    case TEST_PATTERN_JPEG:
+        return TEST_PATTERN_JPEG_PAD + TEST_PATTERN_JPEG_FRAME_LEN[n % TEST_PATTERN_JPEG_FRAMES];
+    case TEST_PATTERN_BARS:
+    case TEST_PATTERN_RAMP:
+        return (uint32)line_bytes * height;
+    default:
+        return 0;
+    }
+}
+
+/* frames frames of width x height, width is rounded down to whole
+ * macropixels */
+void test_pattern_capture(uint8 p, uint16 width, uint16 h, uint8 frames) {
+    uint8 i;
+
+    pattern = p;
+    line_bytes = (uint16)((width * 2) & ~3);
+    if (line_bytes == 0) {
+        line_bytes = 4;
+    }
+    bar_bytes = (uint16)((line_bytes / TEST_PATTERN_BAR_COUNT) & ~3);
+    if (bar_bytes == 0) {
+        bar_bytes = 4;
+    }
+    height = h ? h : 1;
+
+    first_seq = next_seq;
+    length = 0;
+    for (i = 0; i < frames; i++) {
+        length += test_pattern_frame_length(next_seq++);
+    }
+    test_pattern_rewind();
+}
+
+uint32 test_pattern_length(void) {
+    return length;
+}
+
+uint32 test_pattern_first_seq(void) {
+    return first_seq;
+}
+
+void test_pattern_rewind(void) {
+    seq = first_seq;
+    frame_len = test_pattern_frame_length(seq);
+    offset = 0;
+}
+
+static inline __attribute__((always_inline)) void readBars(uint8 *buf, uint16 n) {
+    uint32 line = offset / line_bytes;
+    uint16 col = (uint16)(offset - line * line_bytes);
+    uint16 band = height - height / 8;
+    uint8 shift = (uint8)(seq * 4);
+
+    while (n > 0) {
+        uint16 run = line_bytes - col;
+        uint16 i;
+
+        if (run > n) {
+            run = n;
+        }
+        if (line >= band) {
+            for (i = 0; i < run; i++, col++) {
+                buf[i] = (col & 1) ? 0x80 : (uint8)((col >> 1) + shift);
+            }
+        } else {
+            i = 0;
+            while (i < run) {
+                uint8 bar = col / bar_bytes;
+                uint16 edge;
+
+                if (bar >= TEST_PATTERN_BAR_COUNT - 1) {
+                    bar = TEST_PATTERN_BAR_COUNT - 1;
+                    edge = line_bytes;
+                } else {
+                    edge = (bar + 1) * bar_bytes;
+                }
+                for (; i < run && col < edge; i++, col++) {
+                    buf[i] = test_pattern_bars[bar][col & 3];
+                }
+            }
+        }
+        buf += run;
+        n -= run;
+        if (col == line_bytes) {
+            col = 0;
+            line++;
+        }
+    }
+}
+
+static inline __attribute__((always_inline)) void readRamp(uint8 *buf, uint16 n) {
+    uint8 v = (uint8)(offset + seq);
+
+    while (n--) {
+        *buf++ = v++;
+    }
+}
+
+/* SOI, the COM segments, then the canned frame after its SOI */
+static inline __attribute__((always_inline)) void readJpeg(uint8 *buf, uint16 n) {
+    const uint8 *jpeg = TEST_PATTERN_JPEG_FRAME[seq % TEST_PATTERN_JPEG_FRAMES];
+    uint32 off = offset;
+
+    while (n--) {
+        if (off < 2) {
+            *buf++ = jpeg[off];
+        } else if (off < 2 + TEST_PATTERN_JPEG_PAD) {
+            uint16 seg = (uint16)((off - 2) % TEST_PATTERN_COM_SIZE);
+
+            switch (seg) {
+            case 0:
+                *buf++ = 0xFF;
+                break;
+            case 1:
+                *buf++ = 0xFE;
+                break;
+            case 2:
+                *buf++ = (uint8)((TEST_PATTERN_COM_SIZE - 2) >> 8);
+                break;
+            case 3:
+                *buf++ = (uint8)(TEST_PATTERN_COM_SIZE - 2);
+                break;
+            default:
+                *buf++ = 0x00;
+                break;
+            }
+        } else {
+            *buf++ = jpeg[off - TEST_PATTERN_JPEG_PAD];
+        }
+        off++;
+    }
+}
+
+/* Past the end of the capture the next frames follow, as a FIFO would
+ * hand out whatever the sensor wrote next. In SRAM next to the pattern
+ * drains, with the generators inlined into it. */
+RAMFUNC(RAMFUNC_STREAM_DRAIN, test_pattern_read)
+void test_pattern_read(uint8 *buf, uint16 len) {
+    while (len > 0) {
+        uint16 n = (frame_len - offset < len) ? (uint16)(frame_len - offset) : len;
+
+        switch (pattern) {
+        case TEST_PATTERN_BARS:
+            readBars(buf, n);
+            break;
+        case TEST_PATTERN_RAMP:
+            readRamp(buf, n);
+            break;
+        case TEST_PATTERN_JPEG:
+            readJpeg(buf, n);
+            break;
+        default:
+            return;
+        }
+        buf += n;
+        len -= n;
+        offset += n;
+        if (offset == frame_len) {
+            frame_len = test_pattern_frame_length(++seq);
+            offset = 0;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Synthetic frame source in place of the ArduCAM FIFO
+ *
+ * The stream reads a test pattern the way it reads a capture: take one,
+ * ask its length, read it out in pieces of any size, rewind. Nothing
+ * here touches the hardware, so with a pattern selected the stream
+ * measures the framing, endpoint refill and scheduling alone, and the
+ * same code builds on the host (tools/pattern_bench.c).
+ *
+ * A capture is ready as soon as it is taken. Every frame of it has its
+ * own sequence number, so consecutive frames differ:
+ *
+ * - BARS: YUY2 100% colour bars, the bottom eighth a luma ramp that
+ *   moves by four pixels per frame
+ * - RAMP: byte k of frame n is (k + n) & 0xFF, for checking every byte
+ * - JPEG: the canned frames of test_pattern_jpeg.h in turn, each padded
+ *   with COM segments to TEST_PATTERN_JPEG_PAD bytes more so that they
+ *   weigh what a sensor JPEG does
+ */
+
+#ifndef _TEST_PATTERN_H_
+#define _TEST_PATTERN_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEST_PATTERN_OFF        0       /* frames come from the sensor */
+#define TEST_PATTERN_BARS       1
+#define TEST_PATTERN_RAMP       2
+#define TEST_PATTERN_JPEG       3
+#define TEST_PATTERN_COUNT      4
+
+#define TEST_PATTERN_BAR_COUNT  8
+
+/* COM segment bytes in front of each canned JPEG, a multiple of
+ * TEST_PATTERN_COM_SIZE */
+#ifndef TEST_PATTERN_JPEG_PAD
+#define TEST_PATTERN_JPEG_PAD   32768
+#endif
+/* one COM segment, marker and length included */
+#define TEST_PATTERN_COM_SIZE   1024
+
+typedef char test_pattern_pad_check[
+    (TEST_PATTERN_JPEG_PAD % TEST_PATTERN_COM_SIZE == 0) ? 1 : -1];
+
+/* Y U Y V of each bar, left to right */
+extern const uint8 test_pattern_bars[TEST_PATTERN_BAR_COUNT][4];
+
+void test_pattern_capture(uint8 pattern, uint16 width, uint16 height, uint8 frames);
+uint32 test_pattern_length(void);
+uint32 test_pattern_frame_length(uint32 seq);
+uint32 test_pattern_first_seq(void);
+void test_pattern_rewind(void);
+void test_pattern_read(uint8 *buf, uint16 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ * Canned JPEG frames of the test pattern source
+ *
+ * generated by tools/test_pattern_jpeg.py, do not edit.
+ * 320x240 colour bars, the second frame mirrored.
+ */
+
+#ifndef _TEST_PATTERN_JPEG_H_
+#define _TEST_PATTERN_JPEG_H_
+
+#include <libmaple/libmaple_types.h>
+
+#define TEST_PATTERN_JPEG_FRAMES 2
+
+static const uint8 TEST_PATTERN_JPEG_FRAME_0[1958] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+    0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+    0x00, 0x08, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0xf0,
+    0x01, 0x40, 0x03, 0x01, 0x11, 0x00, 0x02, 0x11, 0x00, 0x03, 0x11, 0x00,
+    0xff, 0xc4, 0x00, 0x31, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+    0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x10, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x00,
+    0x03, 0x00, 0x00, 0x3f, 0x00, 0xb7, 0xf0, 0x00, 0x00, 0x00, 0x50, 0x4b,
+    0xbf, 0xa9, 0x50, 0x00, 0x00, 0x05, 0x50, 0x5e, 0xad, 0x76, 0xb0, 0x00,
+    0x00, 0x05, 0x04, 0xb0, 0x05, 0x28, 0x00, 0x00, 0x00, 0xaa, 0x4b, 0xd4,
+    0x2f, 0xac, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x00, 0x00, 0x00,
+    0x15, 0x41, 0x7a, 0xa5, 0xda, 0xc0, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14,
+    0xa8, 0x00, 0x00, 0x02, 0xff, 0x00, 0xe0, 0x00, 0x00, 0x00, 0xa0, 0x97,
+    0x7f, 0x52, 0xa0, 0x00, 0x00, 0x0a, 0xa0, 0xbd, 0x5a, 0xed, 0x60, 0x00,
+    0x00, 0x0a, 0x09, 0x60, 0x0a, 0x50, 0x00, 0x00, 0x01, 0x54, 0x97, 0xa8,
+    0x5f, 0x58, 0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x00, 0x00, 0x00,
+    0x2a, 0x82, 0xf5, 0x4b, 0xb5, 0x80, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29,
+    0x50, 0x00, 0x00, 0x05, 0xff, 0x00, 0xc0, 0x00, 0x00, 0x01, 0x41, 0x2e,
+    0xfe, 0xa5, 0x40, 0x00, 0x00, 0x15, 0x41, 0x7a, 0xb5, 0xda, 0xc0, 0x00,
+    0x00, 0x14, 0x12, 0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa9, 0x2f, 0x50,
+    0xbe, 0xb0, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02, 0x94, 0x00, 0x00, 0x00,
+    0x55, 0x05, 0xea, 0x97, 0x6b, 0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52,
+    0xa0, 0x00, 0x00, 0x0b, 0xff, 0x00, 0x80, 0x00, 0x00, 0x02, 0x82, 0x5d,
+    0xfd, 0x4a, 0x80, 0x00, 0x00, 0x2a, 0x82, 0xf5, 0x6b, 0xb5, 0x80, 0x00,
+    0x00, 0x28, 0x25, 0x80, 0x29, 0x40, 0x00, 0x00, 0x05, 0x52, 0x5e, 0xa1,
+    0x7d, 0x60, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05, 0x28, 0x00, 0x00, 0x00,
+    0xaa, 0x0b, 0xd5, 0x2e, 0xd6, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5,
+    0x40, 0x00, 0x00, 0x17, 0xff, 0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0xbb,
+    0xfa, 0x95, 0x00, 0x00, 0x00, 0x55, 0x05, 0xea, 0xd7, 0x6b, 0x00, 0x00,
+    0x00, 0x50, 0x4b, 0x00, 0x52, 0x80, 0x00, 0x00, 0x0a, 0xa4, 0xbd, 0x42,
+    0xfa, 0xc0, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a, 0x50, 0x00, 0x00, 0x01,
+    0x54, 0x17, 0xaa, 0x5d, 0xac, 0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a,
+    0x80, 0x00, 0x00, 0x2f, 0xfe, 0x00, 0x00, 0x00, 0x0a, 0x09, 0x77, 0xf5,
+    0x2a, 0x00, 0x00, 0x00, 0xaa, 0x0b, 0xd5, 0xae, 0xd6, 0x00, 0x00, 0x00,
+    0xa0, 0x96, 0x00, 0xa5, 0x00, 0x00, 0x00, 0x15, 0x49, 0x7a, 0x85, 0xf5,
+    0x80, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa8,
+    0x2f, 0x54, 0xbb, 0x58, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02, 0x95, 0x00,
+    0x00, 0x00, 0x5f, 0xfc, 0x00, 0x00, 0x00, 0x14, 0x12, 0xef, 0xea, 0x54,
+    0x00, 0x00, 0x01, 0x54, 0x17, 0xab, 0x5d, 0xac, 0x00, 0x00, 0x01, 0x41,
+    0x2c, 0x01, 0x4a, 0x00, 0x00, 0x00, 0x2a, 0x92, 0xf5, 0x0b, 0xeb, 0x00,
+    0x00, 0x00, 0x28, 0x25, 0x80, 0x29, 0x40, 0x00, 0x00, 0x05, 0x50, 0x5e,
+    0xa9, 0x76, 0xb0, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05, 0x2a, 0x00, 0x00,
+    0x00, 0xbf, 0xf8, 0x00, 0x00, 0x00, 0x28, 0x25, 0xdf, 0xd4, 0xa8, 0x00,
+    0x00, 0x02, 0xa8, 0x2f, 0x56, 0xbb, 0x58, 0x00, 0x00, 0x02, 0x82, 0x58,
+    0x02, 0x94, 0x00, 0x00, 0x00, 0x55, 0x25, 0xea, 0x17, 0xd6, 0x00, 0x00,
+    0x00, 0x50, 0x4b, 0x00, 0x52, 0x80, 0x00, 0x00, 0x0a, 0xa0, 0xbd, 0x52,
+    0xed, 0x60, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a, 0x54, 0x00, 0x00, 0x01,
+    0x7f, 0xf0, 0x00, 0x00, 0x00, 0x50, 0x4b, 0xbf, 0xa9, 0x50, 0x00, 0x00,
+    0x05, 0x50, 0x5e, 0xad, 0x76, 0xb0, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05,
+    0x28, 0x00, 0x00, 0x00, 0xaa, 0x4b, 0xd4, 0x2f, 0xac, 0x00, 0x00, 0x00,
+    0xa0, 0x96, 0x00, 0xa5, 0x00, 0x00, 0x00, 0x15, 0x41, 0x7a, 0xa5, 0xda,
+    0xc0, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14, 0xa8, 0x00, 0x00, 0x02, 0xff,
+    0x00, 0xe0, 0x00, 0x00, 0x00, 0xa0, 0x97, 0x7f, 0x52, 0xa0, 0x00, 0x00,
+    0x0a, 0xa0, 0xbd, 0x5a, 0xed, 0x60, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a,
+    0x50, 0x00, 0x00, 0x01, 0x54, 0x97, 0xa8, 0x5f, 0x58, 0x00, 0x00, 0x01,
+    0x41, 0x2c, 0x01, 0x4a, 0x00, 0x00, 0x00, 0x2a, 0x82, 0xf5, 0x4b, 0xb5,
+    0x80, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29, 0x50, 0x00, 0x00, 0x05, 0xff,
+    0x00, 0xc0, 0x00, 0x00, 0x01, 0x41, 0x2e, 0xfe, 0xa5, 0x40, 0x00, 0x00,
+    0x15, 0x41, 0x7a, 0xb5, 0xda, 0xc0, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14,
+    0xa0, 0x00, 0x00, 0x02, 0xa9, 0x2f, 0x50, 0xbe, 0xb0, 0x00, 0x00, 0x02,
+    0x82, 0x58, 0x02, 0x94, 0x00, 0x00, 0x00, 0x55, 0x05, 0xea, 0x97, 0x6b,
+    0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52, 0xa0, 0x00, 0x00, 0x0b, 0xff,
+    0x00, 0x80, 0x00, 0x00, 0x02, 0x82, 0x5d, 0xfd, 0x4a, 0x80, 0x00, 0x00,
+    0x2a, 0x82, 0xf5, 0x6b, 0xb5, 0x80, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29,
+    0x40, 0x00, 0x00, 0x05, 0x52, 0x5e, 0xa1, 0x7d, 0x60, 0x00, 0x00, 0x05,
+    0x04, 0xb0, 0x05, 0x28, 0x00, 0x00, 0x00, 0xaa, 0x0b, 0xd5, 0x2e, 0xd6,
+    0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x40, 0x00, 0x00, 0x17, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0xbb, 0xfa, 0x95, 0x00, 0x00, 0x00,
+    0x55, 0x05, 0xea, 0xd7, 0x6b, 0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52,
+    0x80, 0x00, 0x00, 0x0a, 0xa4, 0xbd, 0x42, 0xfa, 0xc0, 0x00, 0x00, 0x0a,
+    0x09, 0x60, 0x0a, 0x50, 0x00, 0x00, 0x01, 0x54, 0x17, 0xaa, 0x5d, 0xac,
+    0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x80, 0x00, 0x00, 0x2f, 0xfe,
+    0x00, 0x00, 0x00, 0x0a, 0x09, 0x77, 0xf5, 0x2a, 0x00, 0x00, 0x00, 0xaa,
+    0x0b, 0xd5, 0xae, 0xd6, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x00,
+    0x00, 0x00, 0x15, 0x49, 0x7a, 0x85, 0xf5, 0x80, 0x00, 0x00, 0x14, 0x12,
+    0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa8, 0x2f, 0x54, 0xbb, 0x58, 0x00,
+    0x00, 0x02, 0x82, 0x58, 0x02, 0x95, 0x00, 0x00, 0x00, 0x5f, 0xfc, 0x00,
+    0x00, 0x00, 0x14, 0x12, 0xef, 0xea, 0x54, 0x00, 0x00, 0x01, 0x54, 0x17,
+    0xab, 0x5d, 0xac, 0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x00, 0x00,
+    0x00, 0x2a, 0x92, 0xf5, 0x0b, 0xeb, 0x00, 0x00, 0x00, 0x28, 0x25, 0x80,
+    0x29, 0x40, 0x00, 0x00, 0x05, 0x50, 0x5e, 0xa9, 0x76, 0xb0, 0x00, 0x00,
+    0x05, 0x04, 0xb0, 0x05, 0x2a, 0x00, 0x00, 0x00, 0xbf, 0xf8, 0x00, 0x00,
+    0x00, 0x28, 0x25, 0xdf, 0xd4, 0xa8, 0x00, 0x00, 0x02, 0xa8, 0x2f, 0x56,
+    0xbb, 0x58, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02, 0x94, 0x00, 0x00, 0x00,
+    0x55, 0x25, 0xea, 0x17, 0xd6, 0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52,
+    0x80, 0x00, 0x00, 0x0a, 0xa0, 0xbd, 0x52, 0xed, 0x60, 0x00, 0x00, 0x0a,
+    0x09, 0x60, 0x0a, 0x54, 0x00, 0x00, 0x01, 0x7f, 0xf0, 0x00, 0x00, 0x00,
+    0x50, 0x4b, 0xbf, 0xa9, 0x50, 0x00, 0x00, 0x05, 0x50, 0x5e, 0xad, 0x76,
+    0xb0, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05, 0x28, 0x00, 0x00, 0x00, 0xaa,
+    0x4b, 0xd4, 0x2f, 0xac, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x00,
+    0x00, 0x00, 0x15, 0x41, 0x7a, 0xa5, 0xda, 0xc0, 0x00, 0x00, 0x14, 0x12,
+    0xc0, 0x14, 0xa8, 0x00, 0x00, 0x02, 0xff, 0x00, 0xe0, 0x00, 0x00, 0x00,
+    0xa0, 0x97, 0x7f, 0x52, 0xa0, 0x00, 0x00, 0x0a, 0xa0, 0xbd, 0x5a, 0xed,
+    0x60, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a, 0x50, 0x00, 0x00, 0x01, 0x54,
+    0x97, 0xa8, 0x5f, 0x58, 0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x00,
+    0x00, 0x00, 0x2a, 0x82, 0xf5, 0x4b, 0xb5, 0x80, 0x00, 0x00, 0x28, 0x25,
+    0x80, 0x29, 0x50, 0x00, 0x00, 0x05, 0xff, 0x00, 0xc0, 0x00, 0x00, 0x01,
+    0x41, 0x2e, 0xfe, 0xa5, 0x40, 0x00, 0x00, 0x15, 0x41, 0x7a, 0xb5, 0xda,
+    0xc0, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa9,
+    0x2f, 0x50, 0xbe, 0xb0, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02, 0x94, 0x00,
+    0x00, 0x00, 0x55, 0x05, 0xea, 0x97, 0x6b, 0x00, 0x00, 0x00, 0x50, 0x4b,
+    0x00, 0x52, 0xa0, 0x00, 0x00, 0x0b, 0xff, 0x00, 0x80, 0x00, 0x00, 0x02,
+    0x82, 0x5d, 0xfd, 0x4a, 0x80, 0x00, 0x00, 0x2a, 0x82, 0xf5, 0x6b, 0xb5,
+    0x80, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29, 0x40, 0x00, 0x00, 0x05, 0x52,
+    0x5e, 0xa1, 0x7d, 0x60, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05, 0x28, 0x00,
+    0x00, 0x00, 0xaa, 0x0b, 0xd5, 0x2e, 0xd6, 0x00, 0x00, 0x00, 0xa0, 0x96,
+    0x00, 0xa5, 0x40, 0x00, 0x00, 0x17, 0xff, 0x00, 0x00, 0x00, 0x00, 0x05,
+    0x04, 0xbb, 0xfa, 0x95, 0x00, 0x00, 0x00, 0x55, 0x05, 0xea, 0xd7, 0x6b,
+    0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52, 0x80, 0x00, 0x00, 0x0a, 0xa4,
+    0xbd, 0x42, 0xfa, 0xc0, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a, 0x50, 0x00,
+    0x00, 0x01, 0x54, 0x17, 0xaa, 0x5d, 0xac, 0x00, 0x00, 0x01, 0x41, 0x2c,
+    0x01, 0x4a, 0x80, 0x00, 0x00, 0x2f, 0xfe, 0x00, 0x00, 0x00, 0x0a, 0x09,
+    0x77, 0xf5, 0x2a, 0x00, 0x00, 0x00, 0xaa, 0x0b, 0xd5, 0xae, 0xd6, 0x00,
+    0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x00, 0x00, 0x00, 0x15, 0x49, 0x7a,
+    0x85, 0xf5, 0x80, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14, 0xa0, 0x00, 0x00,
+    0x02, 0xa8, 0x2f, 0x54, 0xbb, 0x58, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02,
+    0x95, 0x00, 0x00, 0x00, 0x5f, 0xfc, 0x00, 0x00, 0x00, 0x14, 0x12, 0xef,
+    0xea, 0x54, 0x00, 0x00, 0x01, 0x54, 0x17, 0xab, 0x5d, 0xac, 0x00, 0x00,
+    0x01, 0x41, 0x2c, 0x01, 0x4a, 0x00, 0x00, 0x00, 0x2a, 0x92, 0xf5, 0x0b,
+    0xeb, 0x00, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29, 0x40, 0x00, 0x00, 0x05,
+    0x50, 0x5e, 0xa9, 0x76, 0xb0, 0x00, 0x00, 0x05, 0x04, 0xb0, 0x05, 0x2a,
+    0x00, 0x00, 0x00, 0xbf, 0xf8, 0x00, 0x00, 0x00, 0x28, 0x25, 0xdf, 0xd4,
+    0xa8, 0x00, 0x00, 0x02, 0xa8, 0x2f, 0x56, 0xbb, 0x58, 0x00, 0x00, 0x02,
+    0x82, 0x58, 0x02, 0x94, 0x00, 0x00, 0x00, 0x55, 0x25, 0xea, 0x17, 0xd6,
+    0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52, 0x80, 0x00, 0x00, 0x0a, 0xa0,
+    0xbd, 0x52, 0xed, 0x60, 0x00, 0x00, 0x0a, 0x09, 0x60, 0x0a, 0x54, 0x00,
+    0x00, 0x01, 0x7f, 0xf0, 0x00, 0x00, 0x00, 0x50, 0x4b, 0xbf, 0xa9, 0x50,
+    0x00, 0x00, 0x05, 0x50, 0x5e, 0xad, 0x76, 0xb0, 0x00, 0x00, 0x05, 0x04,
+    0xb0, 0x05, 0x28, 0x00, 0x00, 0x00, 0xaa, 0x4b, 0xd4, 0x2f, 0xac, 0x00,
+    0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x00, 0x00, 0x00, 0x15, 0x41, 0x7a,
+    0xa5, 0xda, 0xc0, 0x00, 0x00, 0x14, 0x12, 0xc0, 0x14, 0xa8, 0x00, 0x00,
+    0x02, 0xff, 0x00, 0xe0, 0x00, 0x00, 0x00, 0xa0, 0x97, 0x7f, 0x52, 0xa0,
+    0x00, 0x00, 0x0a, 0xa0, 0xbd, 0x5a, 0xed, 0x60, 0x00, 0x00, 0x0a, 0x09,
+    0x60, 0x0a, 0x50, 0x00, 0x00, 0x01, 0x54, 0x97, 0xa8, 0x5f, 0x58, 0x00,
+    0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x00, 0x00, 0x00, 0x2a, 0x82, 0xf5,
+    0x4b, 0xb5, 0x80, 0x00, 0x00, 0x28, 0x25, 0x80, 0x29, 0x50, 0x00, 0x00,
+    0x05, 0xff, 0x00, 0xc0, 0x00, 0x00, 0x01, 0x41, 0x2e, 0xfe, 0xa5, 0x40,
+    0x00, 0x00, 0x15, 0x41, 0x7a, 0xb5, 0xda, 0xc0, 0x00, 0x00, 0x14, 0x12,
+    0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa9, 0x2f, 0x50, 0xbe, 0xb0, 0x00,
+    0x00, 0x02, 0x82, 0x58, 0x02, 0x94, 0x00, 0x00, 0x00, 0x55, 0x05, 0xea,
+    0x97, 0x6b, 0x00, 0x00, 0x00, 0x50, 0x4b, 0x00, 0x52, 0xa0, 0x00, 0x00,
+    0x0b, 0xff, 0x00, 0x80, 0x00, 0x00, 0x02, 0x82, 0x5d, 0xfd, 0x4a, 0x80,
+    0x00, 0x00, 0x2a, 0x82, 0xf5, 0x6b, 0xb5, 0x80, 0x00, 0x00, 0x28, 0x25,
+    0x80, 0x29, 0x40, 0x00, 0x00, 0x05, 0x52, 0x5e, 0xa1, 0x7d, 0x60, 0x00,
+    0x00, 0x05, 0x04, 0xb0, 0x05, 0x28, 0x00, 0x00, 0x00, 0xaa, 0x0b, 0xd5,
+    0x2e, 0xd6, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00, 0xa5, 0x40, 0x00, 0x00,
+    0x17, 0xff, 0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0xbb, 0xfa, 0x95, 0x00,
+    0x00, 0x00, 0x55, 0x05, 0xea, 0xd7, 0x6b, 0x00, 0x00, 0x00, 0x50, 0x4b,
+    0x00, 0x52, 0x80, 0x00, 0x00, 0x0a, 0xa4, 0xbd, 0x42, 0xfa, 0xc0, 0x00,
+    0x00, 0x0a, 0x09, 0x60, 0x0a, 0x50, 0x00, 0x00, 0x01, 0x54, 0x17, 0xaa,
+    0x5d, 0xac, 0x00, 0x00, 0x01, 0x41, 0x2c, 0x01, 0x4a, 0x80, 0x00, 0x00,
+    0x2f, 0xfe, 0x00, 0x00, 0x00, 0x0a, 0x09, 0x77, 0xf5, 0x2a, 0x00, 0x00,
+    0x00, 0xaa, 0x0b, 0xd5, 0xae, 0xd6, 0x00, 0x00, 0x00, 0xa0, 0x96, 0x00,
+    0xa5, 0x00, 0x00, 0x00, 0x15, 0x49, 0x7a, 0x85, 0xf5, 0x80, 0x00, 0x00,
+    0x14, 0x12, 0xc0, 0x14, 0xa0, 0x00, 0x00, 0x02, 0xa8, 0x2f, 0x54, 0xbb,
+    0x58, 0x00, 0x00, 0x02, 0x82, 0x58, 0x02, 0x95, 0x00, 0x00, 0x00, 0x7f,
+    0xff, 0xd9,
+};
+
+static const uint8 TEST_PATTERN_JPEG_FRAME_1[1942] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+    0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+    0x00, 0x08, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0xf0,
+    0x01, 0x40, 0x03, 0x01, 0x11, 0x00, 0x02, 0x11, 0x00, 0x03, 0x11, 0x00,
+    0xff, 0xc4, 0x00, 0x31, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+    0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x10, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x00,
+    0x03, 0x00, 0x00, 0x3f, 0x00, 0xbb, 0xf8, 0x00, 0x00, 0x00, 0x29, 0xd5,
+    0xbf, 0xa8, 0xa0, 0x00, 0x00, 0x05, 0x6f, 0x5d, 0x55, 0x79, 0x40, 0x00,
+    0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00, 0xad, 0xab, 0xab,
+    0xae, 0x52, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00,
+    0x15, 0xbd, 0x75, 0x45, 0xe5, 0x00, 0x00, 0x00, 0x14, 0xea, 0xf0, 0x0a,
+    0x28, 0x00, 0x00, 0x01, 0x70, 0x00, 0x00, 0x00, 0x00, 0x53, 0xab, 0x7f,
+    0x51, 0x40, 0x00, 0x00, 0x0a, 0xde, 0xba, 0xaa, 0xf2, 0x80, 0x00, 0x00,
+    0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b, 0x57, 0x57, 0x5c,
+    0xa4, 0x00, 0x00, 0x01, 0x4e, 0xad, 0xfd, 0x45, 0x80, 0x00, 0x00, 0x2b,
+    0x7a, 0xea, 0x8b, 0xca, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xe0, 0x14, 0x50,
+    0x00, 0x00, 0x02, 0xe0, 0x00, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2,
+    0x80, 0x00, 0x00, 0x15, 0xbd, 0x75, 0x55, 0xe5, 0x00, 0x00, 0x00, 0x14,
+    0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00, 0x02, 0xb6, 0xae, 0xae, 0xb9, 0x48,
+    0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa, 0x8b, 0x00, 0x00, 0x00, 0x56, 0xf5,
+    0xd5, 0x17, 0x94, 0x00, 0x00, 0x00, 0x53, 0xab, 0xc0, 0x28, 0xa0, 0x00,
+    0x00, 0x05, 0xc0, 0x00, 0x00, 0x00, 0x01, 0x4e, 0xad, 0xfd, 0x45, 0x00,
+    0x00, 0x00, 0x2b, 0x7a, 0xea, 0xab, 0xca, 0x00, 0x00, 0x00, 0x29, 0xd5,
+    0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05, 0x6d, 0x5d, 0x5d, 0x72, 0x90, 0x00,
+    0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa,
+    0x2f, 0x28, 0x00, 0x00, 0x00, 0xa7, 0x57, 0x80, 0x51, 0x40, 0x00, 0x00,
+    0x0b, 0x80, 0x00, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa, 0x8a, 0x00, 0x00,
+    0x00, 0x56, 0xf5, 0xd5, 0x57, 0x94, 0x00, 0x00, 0x00, 0x53, 0xab, 0x7f,
+    0x51, 0x60, 0x00, 0x00, 0x0a, 0xda, 0xba, 0xba, 0xe5, 0x20, 0x00, 0x00,
+    0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b, 0xd7, 0x54, 0x5e,
+    0x50, 0x00, 0x00, 0x01, 0x4e, 0xaf, 0x00, 0xa2, 0x80, 0x00, 0x00, 0x17,
+    0x00, 0x00, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x14, 0x00, 0x00, 0x00,
+    0xad, 0xeb, 0xaa, 0xaf, 0x28, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2,
+    0xc0, 0x00, 0x00, 0x15, 0xb5, 0x75, 0x75, 0xca, 0x40, 0x00, 0x00, 0x14,
+    0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00, 0x02, 0xb7, 0xae, 0xa8, 0xbc, 0xa0,
+    0x00, 0x00, 0x02, 0x9d, 0x5e, 0x01, 0x45, 0x00, 0x00, 0x00, 0x2e, 0x00,
+    0x00, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x28, 0x00, 0x00, 0x01, 0x5b,
+    0xd7, 0x55, 0x5e, 0x50, 0x00, 0x00, 0x01, 0x4e, 0xad, 0xfd, 0x45, 0x80,
+    0x00, 0x00, 0x2b, 0x6a, 0xea, 0xeb, 0x94, 0x80, 0x00, 0x00, 0x29, 0xd5,
+    0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05, 0x6f, 0x5d, 0x51, 0x79, 0x40, 0x00,
+    0x00, 0x05, 0x3a, 0xbc, 0x02, 0x8a, 0x00, 0x00, 0x00, 0x5c, 0x00, 0x00,
+    0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x50, 0x00, 0x00, 0x02, 0xb7, 0xae,
+    0xaa, 0xbc, 0xa0, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa, 0x8b, 0x00, 0x00,
+    0x00, 0x56, 0xd5, 0xd5, 0xd7, 0x29, 0x00, 0x00, 0x00, 0x53, 0xab, 0x7f,
+    0x51, 0x60, 0x00, 0x00, 0x0a, 0xde, 0xba, 0xa2, 0xf2, 0x80, 0x00, 0x00,
+    0x0a, 0x75, 0x78, 0x05, 0x14, 0x00, 0x00, 0x00, 0xb8, 0x00, 0x00, 0x00,
+    0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xa0, 0x00, 0x00, 0x05, 0x6f, 0x5d, 0x55,
+    0x79, 0x40, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00,
+    0xad, 0xab, 0xab, 0xae, 0x52, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2,
+    0xc0, 0x00, 0x00, 0x15, 0xbd, 0x75, 0x45, 0xe5, 0x00, 0x00, 0x00, 0x14,
+    0xea, 0xf0, 0x0a, 0x28, 0x00, 0x00, 0x01, 0x70, 0x00, 0x00, 0x00, 0x00,
+    0x53, 0xab, 0x7f, 0x51, 0x40, 0x00, 0x00, 0x0a, 0xde, 0xba, 0xaa, 0xf2,
+    0x80, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b,
+    0x57, 0x57, 0x5c, 0xa4, 0x00, 0x00, 0x01, 0x4e, 0xad, 0xfd, 0x45, 0x80,
+    0x00, 0x00, 0x2b, 0x7a, 0xea, 0x8b, 0xca, 0x00, 0x00, 0x00, 0x29, 0xd5,
+    0xe0, 0x14, 0x50, 0x00, 0x00, 0x02, 0xe0, 0x00, 0x00, 0x00, 0x00, 0xa7,
+    0x56, 0xfe, 0xa2, 0x80, 0x00, 0x00, 0x15, 0xbd, 0x75, 0x55, 0xe5, 0x00,
+    0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00, 0x02, 0xb6, 0xae,
+    0xae, 0xb9, 0x48, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa, 0x8b, 0x00, 0x00,
+    0x00, 0x56, 0xf5, 0xd5, 0x17, 0x94, 0x00, 0x00, 0x00, 0x53, 0xab, 0xc0,
+    0x28, 0xa0, 0x00, 0x00, 0x05, 0xc0, 0x00, 0x00, 0x00, 0x01, 0x4e, 0xad,
+    0xfd, 0x45, 0x00, 0x00, 0x00, 0x2b, 0x7a, 0xea, 0xab, 0xca, 0x00, 0x00,
+    0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05, 0x6d, 0x5d, 0x5d,
+    0x72, 0x90, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00,
+    0xad, 0xeb, 0xaa, 0x2f, 0x28, 0x00, 0x00, 0x00, 0xa7, 0x57, 0x80, 0x51,
+    0x40, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa,
+    0x8a, 0x00, 0x00, 0x00, 0x56, 0xf5, 0xd5, 0x57, 0x94, 0x00, 0x00, 0x00,
+    0x53, 0xab, 0x7f, 0x51, 0x60, 0x00, 0x00, 0x0a, 0xda, 0xba, 0xba, 0xe5,
+    0x20, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b,
+    0xd7, 0x54, 0x5e, 0x50, 0x00, 0x00, 0x01, 0x4e, 0xaf, 0x00, 0xa2, 0x80,
+    0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x14,
+    0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa, 0xaf, 0x28, 0x00, 0x00, 0x00, 0xa7,
+    0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00, 0x15, 0xb5, 0x75, 0x75, 0xca, 0x40,
+    0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00, 0x02, 0xb7, 0xae,
+    0xa8, 0xbc, 0xa0, 0x00, 0x00, 0x02, 0x9d, 0x5e, 0x01, 0x45, 0x00, 0x00,
+    0x00, 0x2e, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x28, 0x00,
+    0x00, 0x01, 0x5b, 0xd7, 0x55, 0x5e, 0x50, 0x00, 0x00, 0x01, 0x4e, 0xad,
+    0xfd, 0x45, 0x80, 0x00, 0x00, 0x2b, 0x6a, 0xea, 0xeb, 0x94, 0x80, 0x00,
+    0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05, 0x6f, 0x5d, 0x51,
+    0x79, 0x40, 0x00, 0x00, 0x05, 0x3a, 0xbc, 0x02, 0x8a, 0x00, 0x00, 0x00,
+    0x5c, 0x00, 0x00, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x50, 0x00, 0x00,
+    0x02, 0xb7, 0xae, 0xaa, 0xbc, 0xa0, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa,
+    0x8b, 0x00, 0x00, 0x00, 0x56, 0xd5, 0xd5, 0xd7, 0x29, 0x00, 0x00, 0x00,
+    0x53, 0xab, 0x7f, 0x51, 0x60, 0x00, 0x00, 0x0a, 0xde, 0xba, 0xa2, 0xf2,
+    0x80, 0x00, 0x00, 0x0a, 0x75, 0x78, 0x05, 0x14, 0x00, 0x00, 0x00, 0xb8,
+    0x00, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xa0, 0x00, 0x00, 0x05,
+    0x6f, 0x5d, 0x55, 0x79, 0x40, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16,
+    0x00, 0x00, 0x00, 0xad, 0xab, 0xab, 0xae, 0x52, 0x00, 0x00, 0x00, 0xa7,
+    0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00, 0x15, 0xbd, 0x75, 0x45, 0xe5, 0x00,
+    0x00, 0x00, 0x14, 0xea, 0xf0, 0x0a, 0x28, 0x00, 0x00, 0x01, 0x70, 0x00,
+    0x00, 0x00, 0x00, 0x53, 0xab, 0x7f, 0x51, 0x40, 0x00, 0x00, 0x0a, 0xde,
+    0xba, 0xaa, 0xf2, 0x80, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00,
+    0x00, 0x01, 0x5b, 0x57, 0x57, 0x5c, 0xa4, 0x00, 0x00, 0x01, 0x4e, 0xad,
+    0xfd, 0x45, 0x80, 0x00, 0x00, 0x2b, 0x7a, 0xea, 0x8b, 0xca, 0x00, 0x00,
+    0x00, 0x29, 0xd5, 0xe0, 0x14, 0x50, 0x00, 0x00, 0x02, 0xe0, 0x00, 0x00,
+    0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0x80, 0x00, 0x00, 0x15, 0xbd, 0x75,
+    0x55, 0xe5, 0x00, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00,
+    0x02, 0xb6, 0xae, 0xae, 0xb9, 0x48, 0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa,
+    0x8b, 0x00, 0x00, 0x00, 0x56, 0xf5, 0xd5, 0x17, 0x94, 0x00, 0x00, 0x00,
+    0x53, 0xab, 0xc0, 0x28, 0xa0, 0x00, 0x00, 0x05, 0xc0, 0x00, 0x00, 0x00,
+    0x01, 0x4e, 0xad, 0xfd, 0x45, 0x00, 0x00, 0x00, 0x2b, 0x7a, 0xea, 0xab,
+    0xca, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05,
+    0x6d, 0x5d, 0x5d, 0x72, 0x90, 0x00, 0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x16,
+    0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa, 0x2f, 0x28, 0x00, 0x00, 0x00, 0xa7,
+    0x57, 0x80, 0x51, 0x40, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x00, 0x02,
+    0x9d, 0x5b, 0xfa, 0x8a, 0x00, 0x00, 0x00, 0x56, 0xf5, 0xd5, 0x57, 0x94,
+    0x00, 0x00, 0x00, 0x53, 0xab, 0x7f, 0x51, 0x60, 0x00, 0x00, 0x0a, 0xda,
+    0xba, 0xba, 0xe5, 0x20, 0x00, 0x00, 0x0a, 0x75, 0x6f, 0xea, 0x2c, 0x00,
+    0x00, 0x01, 0x5b, 0xd7, 0x54, 0x5e, 0x50, 0x00, 0x00, 0x01, 0x4e, 0xaf,
+    0x00, 0xa2, 0x80, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 0x00, 0x05, 0x3a,
+    0xb7, 0xf5, 0x14, 0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa, 0xaf, 0x28, 0x00,
+    0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00, 0x15, 0xb5, 0x75,
+    0x75, 0xca, 0x40, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4, 0x58, 0x00, 0x00,
+    0x02, 0xb7, 0xae, 0xa8, 0xbc, 0xa0, 0x00, 0x00, 0x02, 0x9d, 0x5e, 0x01,
+    0x45, 0x00, 0x00, 0x00, 0x2e, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x75, 0x6f,
+    0xea, 0x28, 0x00, 0x00, 0x01, 0x5b, 0xd7, 0x55, 0x5e, 0x50, 0x00, 0x00,
+    0x01, 0x4e, 0xad, 0xfd, 0x45, 0x80, 0x00, 0x00, 0x2b, 0x6a, 0xea, 0xeb,
+    0x94, 0x80, 0x00, 0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xb0, 0x00, 0x00, 0x05,
+    0x6f, 0x5d, 0x51, 0x79, 0x40, 0x00, 0x00, 0x05, 0x3a, 0xbc, 0x02, 0x8a,
+    0x00, 0x00, 0x00, 0x5c, 0x00, 0x00, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4,
+    0x50, 0x00, 0x00, 0x02, 0xb7, 0xae, 0xaa, 0xbc, 0xa0, 0x00, 0x00, 0x02,
+    0x9d, 0x5b, 0xfa, 0x8b, 0x00, 0x00, 0x00, 0x56, 0xd5, 0xd5, 0xd7, 0x29,
+    0x00, 0x00, 0x00, 0x53, 0xab, 0x7f, 0x51, 0x60, 0x00, 0x00, 0x0a, 0xde,
+    0xba, 0xa2, 0xf2, 0x80, 0x00, 0x00, 0x0a, 0x75, 0x78, 0x05, 0x14, 0x00,
+    0x00, 0x00, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xa0,
+    0x00, 0x00, 0x05, 0x6f, 0x5d, 0x55, 0x79, 0x40, 0x00, 0x00, 0x05, 0x3a,
+    0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00, 0xad, 0xab, 0xab, 0xae, 0x52, 0x00,
+    0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00, 0x15, 0xbd, 0x75,
+    0x45, 0xe5, 0x00, 0x00, 0x00, 0x14, 0xea, 0xf0, 0x0a, 0x28, 0x00, 0x00,
+    0x01, 0x70, 0x00, 0x00, 0x00, 0x00, 0x53, 0xab, 0x7f, 0x51, 0x40, 0x00,
+    0x00, 0x0a, 0xde, 0xba, 0xaa, 0xf2, 0x80, 0x00, 0x00, 0x0a, 0x75, 0x6f,
+    0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b, 0x57, 0x57, 0x5c, 0xa4, 0x00, 0x00,
+    0x01, 0x4e, 0xad, 0xfd, 0x45, 0x80, 0x00, 0x00, 0x2b, 0x7a, 0xea, 0x8b,
+    0xca, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xe0, 0x14, 0x50, 0x00, 0x00, 0x02,
+    0xe0, 0x00, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0x80, 0x00, 0x00,
+    0x15, 0xbd, 0x75, 0x55, 0xe5, 0x00, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4,
+    0x58, 0x00, 0x00, 0x02, 0xb6, 0xae, 0xae, 0xb9, 0x48, 0x00, 0x00, 0x02,
+    0x9d, 0x5b, 0xfa, 0x8b, 0x00, 0x00, 0x00, 0x56, 0xf5, 0xd5, 0x17, 0x94,
+    0x00, 0x00, 0x00, 0x53, 0xab, 0xc0, 0x28, 0xa0, 0x00, 0x00, 0x05, 0xc0,
+    0x00, 0x00, 0x00, 0x01, 0x4e, 0xad, 0xfd, 0x45, 0x00, 0x00, 0x00, 0x2b,
+    0x7a, 0xea, 0xab, 0xca, 0x00, 0x00, 0x00, 0x29, 0xd5, 0xbf, 0xa8, 0xb0,
+    0x00, 0x00, 0x05, 0x6d, 0x5d, 0x5d, 0x72, 0x90, 0x00, 0x00, 0x05, 0x3a,
+    0xb7, 0xf5, 0x16, 0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa, 0x2f, 0x28, 0x00,
+    0x00, 0x00, 0xa7, 0x57, 0x80, 0x51, 0x40, 0x00, 0x00, 0x0b, 0x80, 0x00,
+    0x00, 0x00, 0x02, 0x9d, 0x5b, 0xfa, 0x8a, 0x00, 0x00, 0x00, 0x56, 0xf5,
+    0xd5, 0x57, 0x94, 0x00, 0x00, 0x00, 0x53, 0xab, 0x7f, 0x51, 0x60, 0x00,
+    0x00, 0x0a, 0xda, 0xba, 0xba, 0xe5, 0x20, 0x00, 0x00, 0x0a, 0x75, 0x6f,
+    0xea, 0x2c, 0x00, 0x00, 0x01, 0x5b, 0xd7, 0x54, 0x5e, 0x50, 0x00, 0x00,
+    0x01, 0x4e, 0xaf, 0x00, 0xa2, 0x80, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00,
+    0x00, 0x05, 0x3a, 0xb7, 0xf5, 0x14, 0x00, 0x00, 0x00, 0xad, 0xeb, 0xaa,
+    0xaf, 0x28, 0x00, 0x00, 0x00, 0xa7, 0x56, 0xfe, 0xa2, 0xc0, 0x00, 0x00,
+    0x15, 0xb5, 0x75, 0x75, 0xca, 0x40, 0x00, 0x00, 0x14, 0xea, 0xdf, 0xd4,
+    0x58, 0x00, 0x00, 0x02, 0xb7, 0xae, 0xa8, 0xbc, 0xa0, 0x00, 0x00, 0x02,
+    0x9d, 0x5e, 0x01, 0x45, 0x00, 0x00, 0x00, 0x3f, 0xff, 0xd9,
+};
+
+static const uint8 * const TEST_PATTERN_JPEG_FRAME[TEST_PATTERN_JPEG_FRAMES] = {
+    TEST_PATTERN_JPEG_FRAME_0, TEST_PATTERN_JPEG_FRAME_1,
+};
+
+static const uint16 TEST_PATTERN_JPEG_FRAME_LEN[TEST_PATTERN_JPEG_FRAMES] = {
+    1958, 1942,
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Host benchmark and check for the exposure statistics kernel
+ *
+ *   cc -O2 -Itools/host -I. -o ae_stats_bench tools/ae_stats_bench.c ae_stats.c
+ *   ./ae_stats_bench [frames]
+ *
+ * Feeds synthetic 320x240 YUY2 frames through ae_stats_update() in the
+ * piece sizes uvc_stream.c uses (a 52-byte first payload, then 62
+ * bytes), compares the result with a straightforward per-pixel
+ * computation and reports the time per frame and per piece.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ae_stats.h"
+
+#define WIDTH       320
+#define HEIGHT      240
+#define FRAME_LEN   (WIDTH * HEIGHT * 2)
+#define FIRST_PIECE 52
+#define PIECE       62
+
+static uint8 frame[FRAME_LEN];
+static int failures;
+
+static void makeFrame(void) {
+    int x, y;
+
+    for (y = 0; y < HEIGHT; y++) {
+        for (x = 0; x < WIDTH; x++) {
+            uint8 *p = &frame[(y * WIDTH + x) * 2];
+            int luma = 16 + (x * 200) / WIDTH + (rand() % 9) - 4;
+
+            /* a bright window in the top right zone */
+            if (x >= 250 && x < 300 && y >= 10 && y < 50) {
+                luma = 235;
+            }
+            p[0] = (uint8)luma;
+            /* U on even pixels, V on odd ones, warm tint */
+            p[1] = (x & 1) ? (uint8)(150 + y % 4) : (uint8)(110 - x % 4);
+        }
+    }
+}
+
+static uint32 collect(ae_stats *stats, uint32 *pieces) {
+    ae_stats_acc acc;
+    uint32 off = 0, n = FIRST_PIECE;
+
+    *pieces = 0;
+    ae_stats_begin(&acc, stats, WIDTH, HEIGHT);
+    while (off < FRAME_LEN) {
+        if (n > FRAME_LEN - off) {
+            n = FRAME_LEN - off;
+        }
+        ae_stats_update(&acc, frame + off, (uint16)n);
+        off += n;
+        n = PIECE;
+        (*pieces)++;
+    }
+    ae_stats_end(&acc);
+    return off;
+}
+
+/* the same statistics, pixel by pixel */
+static void reference(ae_stats *stats) {
+    uint32 hist[AE_STATS_BINS] = {0};
+    uint32 zsum[AE_STATS_ZONES] = {0}, zcount[AE_STATS_ZONES] = {0};
+    uint32 u = 0, v = 0, sum = 0, samples = 0, chroma = 0;
+    int zone_w = (WIDTH / 2 / AE_STATS_ZONES_X) * 2;
+    int zone_h = HEIGHT / AE_STATS_ZONES_Y;
+    int x, y, i;
+
+    for (y = 0; y < HEIGHT; y++) {
+        for (x = 0; x < WIDTH; x += 2) {
+            const uint8 *p = &frame[(y * WIDTH + x) * 2];
+            int zx = x / zone_w, zy = y / zone_h;
+
+            if (zx >= AE_STATS_ZONES_X) {
+                zx = AE_STATS_ZONES_X - 1;
+            }
+            if (zy >= AE_STATS_ZONES_Y) {
+                zy = AE_STATS_ZONES_Y - 1;
+            }
+            hist[p[0] / (256 / AE_STATS_BINS)]++;
+            zsum[zy * AE_STATS_ZONES_X + zx] += p[0];
+            zcount[zy * AE_STATS_ZONES_X + zx]++;
+            sum += p[0];
+            samples++;
+            u += p[1];
+            v += p[3];
+            chroma++;
+        }
+    }
+    for (i = 0; i < AE_STATS_ZONES; i++) {
+        stats->zone_mean[i] = (uint8)(zsum[i] / zcount[i]);
+    }
+    for (i = 0; i < AE_STATS_BINS; i++) {
+        stats->hist[i] = (uint16)((uint64_t)hist[i] * 0xFFFF / samples);
+    }
+    stats->y_mean = (uint8)(sum / samples);
+    stats->u_mean = (uint8)(u / chroma);
+    stats->v_mean = (uint8)(v / chroma);
+    stats->samples = samples;
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 500;
+    ae_stats got, want;
+    uint32 pieces;
+    double t;
+    int i;
+
+    if (frames <= 0) {
+        frames = 1;
+    }
+    makeFrame();
+    reference(&want);
+    collect(&got, &pieces);
+
+    if (memcmp(got.zone_mean, want.zone_mean, sizeof(got.zone_mean)) != 0 ||
+        memcmp(got.hist, want.hist, sizeof(got.hist)) != 0 ||
+        got.y_mean != want.y_mean || got.u_mean != want.u_mean ||
+        got.v_mean != want.v_mean || got.samples != want.samples) {
+        printf("FAIL: kernel and reference disagree\n");
+        failures++;
+    }
+
+    printf("mean Y %u U %u V %u, %u samples\nzones:", got.y_mean, got.u_mean, got.v_mean,
+           got.samples);
+    for (i = 0; i < AE_STATS_ZONES; i++) {
+        printf("%s%4u", (i % AE_STATS_ZONES_X) ? "" : "\n ", got.zone_mean[i]);
+    }
+    printf("\nhistogram:");
+    for (i = 0; i < AE_STATS_BINS; i++) {
+        printf(" %u", got.hist[i]);
+    }
+    printf("\n");
+
+    t = now();
+    for (i = 0; i < frames; i++) {
+        collect(&got, &pieces);
+    }
+    t = now() - t;
+    printf("%.1f us per frame, %.1f ns per %u-byte piece\n",
+           t * 1e6 / frames, t * 1e9 / frames / pieces, PIECE);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * Frame boundary checks for burst captures against a simulated FIFO
+ *
+ *   cc -O2 -Itools/host -I. -o burst_sim tools/burst_sim.c
+ *   ./burst_sim
+ *
+ * Fills a FIFO with several YUY2 or JPEG frames back to back, the way
+ * an ArduCAM Plus leaves a burst capture, drains it through
+ * uvc_payload_fill() with the same header bookkeeping as drainLoop() in
+ * uvc_stream.c, and has a simulated host rebuild the frames from FID and
+ * EOF. Checks that every frame arrives intact with its own FID and PTS,
+ * that JPEG padding and junk between frames is dropped, and that the
+ * FIFO is left unread after the last frame. Exits non-zero when a check
+ * fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uvc_payload.h"
+#include "check.h"
+
+#define PACKET_SIZE     64
+#define HEADER_SIZE     2
+#define HEADER_SIZE_TS  12
+#define MAX_FRAMES      7
+#define FIFO_SIZE       (1 << 20)
+#define YUY2_FRAME      (64 * 48 * 2)
+
+/* the simulated FIFO */
+static uint8 fifo[FIFO_SIZE];
+static uint32 fifo_len;
+static uint32 fifo_pos;
+
+static void fifoRead(uint8 *buf, uint16 len) {
+    if (fifo_pos + len > fifo_len) {
+        printf("  FAIL: read past the FIFO end\n");
+        failures++;
+        len = (uint16)(fifo_len - fifo_pos);
+    }
+    memcpy(buf, fifo + fifo_pos, len);
+    fifo_pos += len;
+}
+
+/* where each frame sits in the FIFO */
+static uint32 frame_off[MAX_FRAMES];
+static uint32 frame_size[MAX_FRAMES];
+
+static void fifoAppend(const uint8 *data, uint32 len) {
+    memcpy(fifo + fifo_len, data, len);
+    fifo_len += len;
+}
+
+static void makeYuy2(uint8 frames, uint32 extra) {
+    uint8 f;
+    uint32 i;
+
+    fifo_len = 0;
+    for (f = 0; f < frames; f++) {
+        frame_off[f] = fifo_len;
+        frame_size[f] = YUY2_FRAME;
+        for (i = 0; i < YUY2_FRAME; i++) {
+            fifo[fifo_len++] = (uint8)(f * 37 + i);
+        }
+    }
+    /* a few bytes of the next frame the sensor had started on */
+    for (i = 0; i < extra; i++) {
+        fifo[fifo_len++] = 0xEE;
+    }
+}
+
+/* a JPEG of len bytes with stuffed 0xFF in the entropy data */
+static void makeJpeg(uint8 *out, uint32 len) {
+    uint32 i;
+
+    out[0] = 0xFF;
+    out[1] = 0xD8;
+    for (i = 2; i < len - 2; i++) {
+        out[i] = (out[i - 1] == 0xFF) ? 0x00 : (uint8)rand();
+    }
+    if (out[len - 3] == 0xFF) {
+        out[len - 3] = 0x12;
+    }
+    out[len - 2] = 0xFF;
+    out[len - 1] = 0xD9;
+}
+
+/* pad bytes between frames, ending in pad_ff 0xFF bytes */
+static void makeJpegBurst(uint8 frames, const uint32 *sizes, uint32 pad, uint32 pad_ff) {
+    static uint8 jpeg[65536];
+    uint8 f;
+    uint32 i;
+
+    fifo_len = 0;
+    for (f = 0; f < frames; f++) {
+        makeJpeg(jpeg, sizes[f]);
+        frame_off[f] = fifo_len;
+        frame_size[f] = sizes[f];
+        fifoAppend(jpeg, sizes[f]);
+        for (i = 0; i < pad; i++) {
+            fifo[fifo_len++] = (i >= pad - pad_ff) ? 0xFF : 0x00;
+        }
+    }
+    /* the rest of the FIFO line after the last frame */
+    for (i = 0; i < 4096; i++) {
+        fifo[fifo_len++] = 0x55;
+    }
+}
+
+/* what the simulated host rebuilt */
+typedef struct host_frame {
+    uint8 data[65536];
+    uint32 len;
+    uint8 fid;
+    uint32 pts;
+} host_frame;
+
+static host_frame host[MAX_FRAMES + 1];
+static uint8 host_frames;
+static uint32 host_len;
+static int host_fid = -1;
+static uint8 host_errors;
+
+static void hostPacket(const uint8 *pkt, uint16 len) {
+    uint8 hlen = pkt[0];
+    uint8 bits = pkt[1];
+    host_frame *f = &host[host_frames];
+
+    if (host_frames > MAX_FRAMES) {
+        host_errors++;
+        return;
+    }
+    if (host_len == 0) {
+        /* the first payload of a frame has a new FID and the PTS */
+        if (host_fid >= 0 && (bits & UVC_STREAM_FID) == host_fid) {
+            host_errors++;
+        }
+        if (!(bits & UVC_STREAM_PTS) || hlen != HEADER_SIZE_TS) {
+            host_errors++;
+        }
+        f->fid = bits & UVC_STREAM_FID;
+        memcpy(&f->pts, pkt + 2, 4);
+    } else if ((bits & UVC_STREAM_FID) != f->fid || (bits & UVC_STREAM_PTS)) {
+        host_errors++;
+    }
+    memcpy(f->data + host_len, pkt + hlen, len - hlen);
+    host_len += len - hlen;
+    if (bits & UVC_STREAM_EOF) {
+        f->len = host_len;
+        host_fid = f->fid;
+        host_len = 0;
+        host_frames++;
+    }
+}
+
+/*
+ * The device side, as drainLoop() does it: ring_room packets per call,
+ * so a burst is drained over several calls
+ */
+static uint8 fid;
+
+static void drain(uint8 framing, uint32 frame_len, uint8 frames,
+                  uint32 pts_start, uint32 pts_end, uint8 ring_room) {
+    uvc_payload p;
+    uint8 pkt[PACKET_SIZE];
+
+    fifo_pos = 0;
+    uvc_payload_begin(&p, fifo_len, frame_len, frames);
+    while (!uvc_payload_done(&p)) {
+        uint8 room = ring_room;
+
+        while (room && !uvc_payload_done(&p)) {
+            uint8 flags = UVC_STREAM_EOH | fid;
+            uint8 hlen = HEADER_SIZE;
+            uint16 len;
+
+            if (uvc_payload_frame_start(&p)) {
+                uint32 pts = uvc_payload_burst_pts(pts_start, pts_end, p.frame, frames);
+                memcpy(pkt + 2, &pts, 4);
+                hlen = HEADER_SIZE_TS;
+                flags |= UVC_STREAM_PTS | UVC_STREAM_SCR;
+            }
+            if (framing == UVC_FRAMING_EOI) {
+                len = uvc_payload_fill(&p, pkt, PACKET_SIZE, hlen, flags,
+                                       UVC_FRAMING_EOI, fifoRead);
+            } else {
+                len = uvc_payload_fill(&p, pkt, PACKET_SIZE, hlen, flags,
+                                       UVC_FRAMING_FIXED, fifoRead);
+            }
+            if (len == 0) {
+                continue;
+            }
+            hostPacket(pkt, len);
+            if (pkt[1] & UVC_STREAM_EOF) {
+                fid ^= UVC_STREAM_FID;
+            }
+            room--;
+        }
+    }
+}
+
+static void hostReset(void) {
+    host_frames = 0;
+    host_len = 0;
+    host_errors = 0;
+}
+
+static void checkFrames(uint8 frames, uint32 pts_start, uint32 pts_end) {
+    uint8 f;
+
+    CHECK(host_frames == frames);
+    CHECK(host_len == 0);
+    CHECK(host_errors == 0);
+    for (f = 0; f < host_frames && f < frames; f++) {
+        CHECK(host[f].len == frame_size[f]);
+        CHECK(memcmp(host[f].data, fifo + frame_off[f], frame_size[f]) == 0);
+        CHECK(host[f].pts == uvc_payload_burst_pts(pts_start, pts_end, f, frames));
+        if (f > 0) {
+            CHECK((int32_t)(host[f].pts - host[f - 1].pts) > 0);
+        }
+    }
+}
+
+int main(void) {
+    uint32 sizes[MAX_FRAMES] = {5000, 777, 12345, 64, 3000, 10, 4099};
+    uint8 frames;
+
+    /* YUY2: fixed size frames, the partial one after them is not read */
+    for (frames = 1; frames <= MAX_FRAMES; frames++) {
+        hostReset();
+        makeYuy2(frames, 1000);
+        drain(UVC_FRAMING_FIXED, YUY2_FRAME, frames, 1000, 1000 + frames * 66666, 8);
+        printf("YUY2 burst of %u: %u frames\n", frames, host_frames);
+        checkFrames(frames, 1000, 1000 + frames * 66666);
+        CHECK(fifo_pos == (uint32)frames * YUY2_FRAME);
+    }
+
+    /* a FIFO shorter than the burst ends with a short frame */
+    hostReset();
+    makeYuy2(2, 0);
+    fifo_len -= 100;
+    frame_size[1] -= 100;
+    drain(UVC_FRAMING_FIXED, YUY2_FRAME, 3, 0, 300, 8);
+    checkFrames(2, 0, 200);
+
+    /* JPEG: frames of any length, junk between them */
+    for (frames = 1; frames <= MAX_FRAMES; frames++) {
+        hostReset();
+        makeJpegBurst(frames, sizes, 37, 0);
+        drain(UVC_FRAMING_EOI, 0, frames, 0xFFFF0000, 0xFFFF0000 + frames * 66666, 3);
+        printf("JPEG burst of %u: %u frames\n", frames, host_frames);
+        checkFrames(frames, 0xFFFF0000, 0xFFFF0000 + frames * 66666);
+        /* at most one packet read past the last EOI, the padding stays */
+        CHECK(fifo_pos < frame_off[frames - 1] + frame_size[frames - 1] + PACKET_SIZE);
+    }
+
+    /* an SOI split by a packet boundary, junk ending in 0xFF */
+    hostReset();
+    makeJpegBurst(4, sizes, PACKET_SIZE - 2 - 1, 5);
+    drain(UVC_FRAMING_EOI, 0, 4, 0, 4000, 1);
+    checkFrames(4, 0, 4000);
+
+    /* frames straight after one another */
+    hostReset();
+    makeJpegBurst(5, sizes, 0, 0);
+    drain(UVC_FRAMING_EOI, 0, 5, 0, 5000, 8);
+    checkFrames(5, 0, 5000);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,492 @@
+/*
+ * Fault recovery checks of the stream against a simulated host
+ *
+ *   cc -O2 -Itools/host -I. -o fault_sim tools/fault_sim.c
+ *   ./fault_sim
+ *
+ * Plays the capture, drain and fault recovery of uvc_stream.c, the
+ * packet ring, the endpoint and a full-speed bulk pipe on a virtual
+ * clock, with the same FID, EOF and ERR bookkeeping as streamRecover()
+ * and streamFrameQueued(). Frames go through uvc_payload_fill(). Faults
+ * are injected the three ways the device sees them: a halt cleared by
+ * the host at any point of the stream, a sensor that never finishes a
+ * capture, and a FIFO write pointer past the end. A host that rebuilds
+ * frames from FID and EOF, as uvcvideo does, checks that:
+ *
+ *   - every frame it does not discard is whole and uncorrupted
+ *   - no frame is cut off by a FID change, and no payload arrives for
+ *     a frame that has already ended
+ *   - a good frame follows the last fault within a capture and a drain
+ *
+ * The capture timeout comes from the committed frame interval as in
+ * uvc_stream_set_interval(); a healthy sensor up to half again slower
+ * than the committed rate never trips it, for any burst length. Exits
+ * non-zero when a check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "uvc_payload.h"
+#include "check.h"
+
+typedef unsigned long long ns;
+
+#define PACKET_SIZE     64
+#define HEADER_SIZE     2
+#define RING_SIZE       8               /* UVC_STREAM_RING_SIZE */
+#define FRAME_SIZE      (64 * 48 * 2)   /* YUY2 */
+#define PACKET_NS       (1000000ULL / 19)
+#define POLL_NS         100000ULL       /* a main loop pass */
+#define MAX_FRAMES      7               /* ARDUCAM_MAX_FRAMES */
+#define NEVER           (~0ULL)
+
+/* uvc_stream.h and usb_uvc.h */
+#define TIMEOUT_FRAMES  4
+#define TIMEOUT_MAX_US  8000000
+#define DEFAULT_INTERVAL 2000000
+#define ERROR_NONE      0
+#define ERROR_UNDERRUN  2
+#define ERROR_DISCONT   3
+
+/* uvc_stream_set_interval() */
+static uint32 captureTimeoutUs(uint32 interval) {
+    uint32 us;
+
+    if (interval == 0) {
+        interval = DEFAULT_INTERVAL;
+    }
+    us = interval / 10;
+    if (us > TIMEOUT_MAX_US / TIMEOUT_FRAMES) {
+        us = TIMEOUT_MAX_US / TIMEOUT_FRAMES;
+    }
+    return TIMEOUT_FRAMES * us;
+}
+
+/* a fixed LCG, so every run injects the same faults */
+static uint32 seed;
+
+static uint32 rnd(uint32 n) {
+    seed = seed * 1664525 + 1013904223;
+    return (uint32)(((unsigned long long)(seed >> 8) * n) >> 24);
+}
+
+typedef struct scenario {
+    const char *name;
+    uint32 interval;            /* committed dwFrameInterval, 100 ns */
+    ns sensor;                  /* sensor frame period, 0 for a pattern */
+    uint8 burst;
+    uint8 halts;                /* host clears a halt at random times */
+    uint8 hang_in;              /* 1 in hang_in captures never finishes */
+    uint8 overflow_in;          /* 1 in overflow_in captures overruns */
+} scenario;
+
+/* the FIFO, each frame numbered into its bytes */
+static uint32 fifo_seq;
+static uint32 fifo_pos;
+
+static uint8 frameByte(uint32 seq, uint32 i) {
+    return (uint8)(seq * 13 + i * 7);
+}
+
+static void fifoRead(uint8 *buf, uint16 len) {
+    uint16 i;
+
+    for (i = 0; i < len; i++, fifo_pos++) {
+        buf[i] = frameByte(fifo_seq + fifo_pos / FRAME_SIZE, fifo_pos % FRAME_SIZE);
+    }
+}
+
+/* the host */
+static struct {
+    int fid;                    /* of the frame being rebuilt, -1 none */
+    int last_fid;               /* of the last frame ended */
+    uint8 data[FRAME_SIZE + PACKET_SIZE];
+    uint32 len;
+    uint8 err;
+    uint32 good, dropped, corrupt, torn, stale;
+    ns last_good;
+} host;
+
+static void hostEnd(void) {
+    uint32 i;
+    int ok = host.len == FRAME_SIZE;
+
+    for (i = 1; ok && i < host.len; i++) {
+        ok = host.data[i] == (uint8)(host.data[0] + i * 7);
+    }
+    if (host.err) {
+        host.dropped++;
+    } else if (ok) {
+        host.good++;
+    } else {
+        host.corrupt++;
+    }
+    host.last_fid = host.fid;
+    host.fid = -1;
+    host.len = 0;
+    host.err = 0;
+}
+
+static void hostPacket(const uint8 *pkt, uint16 len, ns now) {
+    uint8 hlen = pkt[0];
+    int fid = pkt[1] & UVC_STREAM_FID;
+
+    if (host.fid >= 0 && fid != host.fid) {
+        /* the frame ends without its EOF, uvcvideo hands it on as is */
+        host.torn++;
+        hostEnd();
+    }
+    if (host.fid < 0 && fid == host.last_fid) {
+        /* uvcvideo drops it as out of sync, the ERR bit still taints
+         * the next frame */
+        host.stale++;
+        return;
+    }
+    host.fid = fid;
+    if (pkt[1] & UVC_STREAM_ERR) {
+        host.err = 1;
+    }
+    if (host.len + len - hlen <= sizeof(host.data)) {
+        memcpy(host.data + host.len, pkt + hlen, len - hlen);
+    }
+    host.len += len - hlen;
+    if (pkt[1] & UVC_STREAM_EOF) {
+        uint32 good = host.good;
+
+        hostEnd();
+        if (host.good != good) {
+            host.last_good = now;
+        }
+    }
+}
+
+/* the device, named after uvc_stream.c */
+enum { STREAM_CAPTURE, STREAM_DRAIN };
+
+static struct {
+    const scenario *sc;
+    ns now;
+    int state;
+    ns capture_start;
+    ns capture_done;
+    uint8 overflow;             /* this capture ran past the FIFO end */
+    uvc_payload payload;
+    uint32 seq;                 /* the next frame the sensor takes */
+    uint8 fid;
+    uint8 frame_open;
+    uint32 frames_queued;
+    uint32 frames_done;
+    uint8 fault_code;
+    uint8 recovering;
+    uint32 faults;
+    uint32 timeouts;
+    ns hang_found;              /* longest capture start to its timeout */
+
+    uint8 ring[RING_SIZE][PACKET_SIZE];
+    uint16 ring_len[RING_SIZE];
+    uint32 ring_head, ring_tail;
+    uint8 pma[PACKET_SIZE];
+    uint16 pma_len;
+    uint8 pma_valid;            /* the host reads it at tx_done */
+    uint8 tx_busy;
+    uint8 eof_in_flight;
+    ns tx_done;
+} dev;
+
+/* streamSend(), at time t */
+static void streamSend(ns t) {
+    uint32 slot = dev.ring_tail % RING_SIZE;
+
+    if (dev.ring_head == dev.ring_tail) {
+        dev.tx_busy = 0;
+        return;
+    }
+    memcpy(dev.pma, dev.ring[slot], dev.ring_len[slot]);
+    dev.pma_len = dev.ring_len[slot];
+    dev.eof_in_flight = dev.pma[1] & UVC_STREAM_EOF;
+    dev.pma_valid = 1;
+    dev.tx_done = t + PACKET_NS;
+    dev.ring_tail++;
+    dev.tx_busy = 1;
+}
+
+/* the pipe and uvc_stream_tx() from the endpoint interrupt, up to t */
+static void bus(ns t) {
+    while (dev.pma_valid && dev.tx_done <= t) {
+        ns at = dev.tx_done;
+
+        dev.pma_valid = 0;
+        hostPacket(dev.pma, dev.pma_len, at);
+        if (dev.eof_in_flight) {
+            dev.eof_in_flight = 0;
+            dev.frames_done++;
+        }
+        streamSend(at);
+    }
+}
+
+static void streamKick(void) {
+    if (!dev.tx_busy) {
+        streamSend(dev.now);
+    }
+}
+
+static void ringPush(const uint8 *pkt, uint16 len) {
+    uint32 slot = dev.ring_head % RING_SIZE;
+
+    memcpy(dev.ring[slot], pkt, len);
+    dev.ring_len[slot] = len;
+    dev.ring_head++;
+    streamKick();
+}
+
+static void streamQueueHeader(uint8 flags) {
+    uint8 pkt[HEADER_SIZE] = {HEADER_SIZE, (uint8)(UVC_STREAM_EOH | dev.fid | flags)};
+
+    ringPush(pkt, HEADER_SIZE);
+}
+
+static void streamStartCapture(void) {
+    const scenario *sc = dev.sc;
+
+    dev.capture_start = dev.now;
+    dev.overflow = sc->overflow_in && rnd(sc->overflow_in) == 0;
+    if (sc->sensor == 0) {
+        dev.capture_done = dev.now;
+    } else if (sc->hang_in && rnd(sc->hang_in) == 0) {
+        dev.capture_done = NEVER;
+    } else {
+        /* the sensor's next VSYNC, then burst frames */
+        ns vsync = (dev.now / sc->sensor + 1) * sc->sensor;
+
+        dev.capture_done = vsync + sc->burst * sc->sensor;
+    }
+    dev.state = STREAM_CAPTURE;
+}
+
+/* uvc_stream_fault() */
+static void streamFault(uint8 error) {
+    dev.pma_valid = 0;
+    dev.tx_busy = 1;
+    dev.fault_code = error;
+}
+
+/* streamRecover() */
+static void streamRecover(uint8 error) {
+    uint32 unread;
+
+    (void)error;
+    dev.fault_code = ERROR_NONE;
+    unread = dev.frames_queued - dev.frames_done;
+    dev.ring_tail = dev.ring_head;
+    dev.pma_valid = 0;
+    dev.tx_busy = 0;
+    dev.eof_in_flight = 0;
+
+    if (unread != 0 || dev.frame_open) {
+        if (unread & 1) {
+            dev.fid ^= UVC_STREAM_FID;
+        }
+        dev.frames_queued = dev.frames_done + 1;
+        streamQueueHeader(UVC_STREAM_ERR | UVC_STREAM_EOF);
+        dev.fid ^= UVC_STREAM_FID;
+        dev.frame_open = 0;
+    }
+    dev.faults++;
+    dev.recovering = 1;
+    streamStartCapture();
+}
+
+/* streamCaptured() */
+static void streamCaptured(void) {
+    if (dev.overflow) {
+        streamRecover(ERROR_DISCONT);
+        return;
+    }
+    fifo_seq = dev.seq;
+    fifo_pos = 0;
+    dev.seq += dev.sc->burst;
+    uvc_payload_begin(&dev.payload, (uint32)FRAME_SIZE * dev.sc->burst, FRAME_SIZE,
+                      dev.sc->burst);
+    dev.state = STREAM_DRAIN;
+}
+
+/* drainLoop() */
+static void streamDrain(void) {
+    while (dev.ring_head - dev.ring_tail < RING_SIZE) {
+        uint8 pkt[PACKET_SIZE];
+        uint16 len;
+
+        len = uvc_payload_fill(&dev.payload, pkt, PACKET_SIZE, HEADER_SIZE,
+                               UVC_STREAM_EOH | dev.fid, UVC_FRAMING_FIXED, fifoRead);
+        dev.frame_open = 1;
+        if (pkt[1] & UVC_STREAM_EOF) {
+            /* streamFrameQueued() */
+            dev.fid ^= UVC_STREAM_FID;
+            dev.frame_open = 0;
+            dev.frames_queued++;
+            dev.recovering = 0;
+        }
+        ringPush(pkt, len);
+        if (uvc_payload_done(&dev.payload)) {
+            streamStartCapture();
+            return;
+        }
+    }
+}
+
+/* uvc_stream_poll() */
+static void streamPoll(void) {
+    if (dev.fault_code != ERROR_NONE) {
+        streamRecover(dev.fault_code);
+    }
+    if (dev.state == STREAM_CAPTURE) {
+        if (dev.now < dev.capture_done) {
+            if (dev.now - dev.capture_start >
+                (ns)captureTimeoutUs(dev.sc->interval) * 1000 * dev.sc->burst) {
+                if (dev.now - dev.capture_start > dev.hang_found) {
+                    dev.hang_found = dev.now - dev.capture_start;
+                }
+                dev.timeouts++;
+                streamRecover(ERROR_UNDERRUN);
+            }
+            return;
+        }
+        streamCaptured();
+    }
+    if (dev.state == STREAM_DRAIN) {
+        streamDrain();
+    }
+}
+
+/* longest the last fault may keep good frames from the host: a capture
+ * from the next VSYNC and its drain */
+static ns recoveryBound(const scenario *sc) {
+    ns capture = (sc->burst + 1) * sc->sensor;
+    ns drain = (ns)(FRAME_SIZE / (PACKET_SIZE - HEADER_SIZE) + 1) * sc->burst * PACKET_NS;
+
+    return capture + drain + RING_SIZE * PACKET_NS + 2 * POLL_NS;
+}
+
+static void run(const scenario *sc, ns length) {
+    ns bound = recoveryBound(sc);
+    ns next_halt = NEVER;
+    ns fault_at = NEVER;        /* the last fault not recovered from */
+    ns worst = 0;
+    uint32 faults = 0;
+
+    memset(&dev, 0, sizeof(dev));
+    memset(&host, 0, sizeof(host));
+    host.fid = -1;
+    host.last_fid = -1;
+    seed = 12345;
+    dev.sc = sc;
+    if (sc->halts) {
+        next_halt = bound + rnd((uint32)bound);
+    }
+    streamStartCapture();
+
+    for (dev.now = 0; dev.now < length; dev.now += POLL_NS) {
+        bus(dev.now);
+        if (host.last_good > fault_at && fault_at != NEVER) {
+            if (host.last_good - fault_at > worst) {
+                worst = host.last_good - fault_at;
+            }
+            fault_at = NEVER;
+        }
+        if (dev.now >= next_halt) {
+            /* usbClearFeature() from the USB interrupt */
+            streamFault(ERROR_DISCONT);
+            next_halt = dev.now + bound + rnd((uint32)bound);
+            fault_at = dev.now;
+        }
+        faults = dev.faults;
+        streamPoll();
+        if (dev.faults != faults) {
+            fault_at = dev.now;
+        }
+    }
+
+    printf("  %-26s %5u faults %6u good %5u dropped, recovery %6.1f ms (bound %.1f)\n",
+           sc->name, dev.faults, host.good, host.dropped, worst / 1e6, bound / 1e6);
+    CHECK(host.corrupt == 0);
+    CHECK(host.torn == 0);
+    CHECK(host.stale == 0);
+    CHECK(host.dropped <= dev.faults);
+    CHECK(host.good > 0);
+    CHECK(worst <= bound);
+    /* a hang is found at the timeout for the burst, by the next pass */
+    CHECK(dev.hang_found <= (ns)captureTimeoutUs(sc->interval) * 1000 * sc->burst + POLL_NS);
+    if (!sc->hang_in) {
+        CHECK(dev.timeouts == 0);
+    } else if (!sc->halts) {
+        CHECK(dev.timeouts != 0);
+    }
+    if (!sc->halts && !sc->hang_in && !sc->overflow_in) {
+        CHECK(dev.faults == 0);
+    } else {
+        CHECK(dev.faults > 0);
+    }
+}
+
+/* a healthy sensor up to half again slower than the committed rate */
+static void checkNoFalseTimeouts(void) {
+    static const uint32 intervals[] = {333333, 666666, 1000000, DEFAULT_INTERVAL, 10000000};
+    uint32 tripped = 0;
+    uint8 i, burst;
+
+    for (i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+        for (burst = 1; burst <= MAX_FRAMES; burst++) {
+            scenario sc = {"", intervals[i], (ns)intervals[i] * 150, burst, 0, 0, 0};
+
+            memset(&dev, 0, sizeof(dev));
+            memset(&host, 0, sizeof(host));
+            host.fid = -1;
+            host.last_fid = -1;
+            dev.sc = &sc;
+            streamStartCapture();
+            for (dev.now = 0; dev.now < 8 * (burst + 1) * sc.sensor; dev.now += POLL_NS) {
+                bus(dev.now);
+                streamPoll();
+            }
+            tripped += dev.faults;
+            CHECK(host.good > 0 && host.corrupt == 0);
+        }
+    }
+    printf("  healthy sensor at 1.5 intervals: %u timeouts\n", tripped);
+    CHECK(tripped == 0);
+}
+
+static void checkTimeouts(void) {
+    /* 0 is the descriptor default */
+    CHECK(captureTimeoutUs(0) == captureTimeoutUs(DEFAULT_INTERVAL));
+    CHECK(captureTimeoutUs(DEFAULT_INTERVAL) == TIMEOUT_FRAMES * 200000);
+    CHECK(captureTimeoutUs(333333) == TIMEOUT_FRAMES * 33333);
+    /* a whole burst stays inside the DWT wrap, 2^32 cycles at 72 MHz */
+    CHECK((unsigned long long)captureTimeoutUs(0xFFFFFFFF) * MAX_FRAMES <
+          (1ULL << 32) / 72);
+}
+
+int main(void) {
+    static const scenario scenarios[] = {
+        {"halts, pattern", DEFAULT_INTERVAL, 0, 1, 1, 0, 0},
+        {"halts, sensor at 15 fps", 666666, 66666666, 1, 1, 0, 0},
+        {"halts, sensor burst of 3", 666666, 66666666, 3, 1, 0, 0},
+        {"sensor hangs", 666666, 66666666, 1, 0, 4, 0},
+        {"sensor hangs, burst of 7", DEFAULT_INTERVAL, 66666666, 7, 0, 4, 0},
+        {"FIFO overflows", 666666, 66666666, 1, 0, 0, 3},
+        {"everything at once", 666666, 66666666, 2, 1, 5, 5},
+        {"no faults", DEFAULT_INTERVAL, 0, 1, 0, 0, 0},
+    };
+    uint8 i;
+
+    checkTimeouts();
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        run(&scenarios[i], 120ULL * 1000000000);
+    }
+    checkNoFalseTimeouts();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,24 @@
+/*
+ * Pass/fail checks of the host tools
+ *
+ * CHECK() prints a condition that does not hold with its file and line
+ * and counts it in failures. A tool ends by printing "ok" or "FAILED"
+ * from that count and exits non-zero on any failure.
+ */
+
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Mock OV2640 behind the libmaple I2C master interface
+ *
+ * Enough of the sensor's SCCB behaviour to run sccb.c and ov2640.c on
+ * the host: register 0xFF switches between the DSP (0) and sensor (1)
+ * banks, a 2-byte write sets a register, a 1-byte write sets the
+ * address of the next read. Bit 7 of COM7 (sensor bank 0x12) is the
+ * soft reset: it clears the registers except the chip ID and falls
+ * back to the DSP bank. A transfer runs its messages in order and
+ * stops at the first one that is not acknowledged.
+ */
+
+#include <string.h>
+
+#include <libmaple/i2c.h>
+
+#include "i2c_host.h"
+#include "ov2640.h"
+
+#define BANK_SEL                0xFF
+#define SENSOR_COM7             0x12
+#define COM7_SRST               0x80
+
+static i2c_dev host_i2c1;
+i2c_dev* const I2C1 = &host_i2c1;
+
+uint8 i2c_host_regs[2][256];
+uint8 i2c_host_bank;
+i2c_host_write i2c_host_log[I2C_HOST_LOG_SIZE];
+uint16 i2c_host_log_len;
+uint32 i2c_host_resets;
+uint32 i2c_host_xfers;
+uint16 i2c_host_xfer_max;
+int i2c_host_fail_bank;
+int i2c_host_fail_reg;
+int i2c_host_nak_all;
+
+static uint8 read_addr;
+
+static void powerOn(void) {
+    memset(i2c_host_regs, 0, sizeof(i2c_host_regs));
+    i2c_host_regs[1][OV2640_CHIPID_HIGH] = OV2640_PID;
+    i2c_host_regs[1][OV2640_CHIPID_LOW] = 0x42;
+    i2c_host_bank = 0;
+}
+
+void i2c_host_reset(void) {
+    powerOn();
+    i2c_host_log_len = 0;
+    i2c_host_resets = 0;
+    i2c_host_xfers = 0;
+    i2c_host_xfer_max = 0;
+    i2c_host_fail_bank = -1;
+    i2c_host_fail_reg = -1;
+    i2c_host_nak_all = 0;
+    read_addr = 0;
+}
+
+uint16 i2c_host_writes_to(uint8 bank, uint8 reg) {
+    uint16 i, n = 0;
+
+    for (i = 0; i < i2c_host_log_len; i++) {
+        n += i2c_host_log[i].bank == bank && i2c_host_log[i].reg == reg;
+    }
+    return n;
+}
+
+static int regWrite(uint8 reg, uint8 val) {
+    if (i2c_host_bank == i2c_host_fail_bank && reg == i2c_host_fail_reg) {
+        return -1;
+    }
+    if (i2c_host_log_len < I2C_HOST_LOG_SIZE) {
+        i2c_host_write *w = &i2c_host_log[i2c_host_log_len++];
+
+        w->bank = i2c_host_bank;
+        w->reg = reg;
+        w->val = val;
+    }
+    if (reg == BANK_SEL) {
+        i2c_host_bank = val & 1;
+        return 0;
+    }
+    if (i2c_host_bank == 1 && reg == SENSOR_COM7 && (val & COM7_SRST)) {
+        i2c_host_resets++;
+        powerOn();
+        return 0;
+    }
+    i2c_host_regs[i2c_host_bank][reg] = val;
+    return 0;
+}
+
+void i2c_master_enable(i2c_dev *dev, uint32 flags) {
+    dev->flags = flags;
+}
+
+int32 i2c_master_xfer(i2c_dev *dev, i2c_msg *msgs, uint16 num, uint32 timeout) {
+    uint16 i;
+
+    (void)dev;
+    (void)timeout;
+    i2c_host_xfers++;
+    if (num > i2c_host_xfer_max) {
+        i2c_host_xfer_max = num;
+    }
+    if (i2c_host_nak_all) {
+        return I2C_ERROR_PROTOCOL;
+    }
+    for (i = 0; i < num; i++) {
+        i2c_msg *msg = &msgs[i];
+
+        if (msg->addr != OV2640_I2C_ADDR) {
+            return I2C_ERROR_PROTOCOL;
+        }
+        if (msg->flags & I2C_MSG_READ) {
+            msg->data[0] = i2c_host_regs[i2c_host_bank][read_addr];
+        } else if (msg->length == 1) {
+            read_addr = msg->data[0];
+        } else if (msg->length == 2) {
+            if (regWrite(msg->data[0], msg->data[1]) != 0) {
+                return I2C_ERROR_PROTOCOL;
+            }
+        } else {
+            return I2C_ERROR_PROTOCOL;
+        }
+        msg->xferred = msg->length;
+    }
+    return 0;
+}
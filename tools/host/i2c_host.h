@@ -0,0 +1,48 @@
+/*
+ * Mock OV2640 on the host I2C bus, see i2c_host.c
+ */
+
+#ifndef _I2C_HOST_H_
+#define _I2C_HOST_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_HOST_LOG_SIZE       4096
+
+typedef struct i2c_host_write {
+    uint8 bank;
+    uint8 reg;
+    uint8 val;
+} i2c_host_write;
+
+/* the two register banks as the sensor holds them */
+extern uint8 i2c_host_regs[2][256];
+extern uint8 i2c_host_bank;
+
+/* every register write that reached the sensor, in order */
+extern i2c_host_write i2c_host_log[I2C_HOST_LOG_SIZE];
+extern uint16 i2c_host_log_len;
+
+extern uint32 i2c_host_resets;         /* soft resets seen */
+extern uint32 i2c_host_xfers;          /* i2c_master_xfer() calls */
+extern uint16 i2c_host_xfer_max;       /* most messages in one of them */
+
+/* faults: a transfer with a write to fail_reg in fail_bank, or any
+ * transfer at all with nak_all, is not acknowledged */
+extern int i2c_host_fail_bank;
+extern int i2c_host_fail_reg;
+extern int i2c_host_nak_all;
+
+/* power-on state: registers cleared, chip ID in place, no faults */
+void i2c_host_reset(void);
+uint16 i2c_host_writes_to(uint8 bank, uint8 reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
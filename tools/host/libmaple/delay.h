@@ -0,0 +1,15 @@
+/*
+ * libmaple busy waits for building device sources on the host; the
+ * host tools do not wait
+ */
+
+#ifndef _LIBMAPLE_DELAY_H_
+#define _LIBMAPLE_DELAY_H_
+
+#include <libmaple/libmaple_types.h>
+
+static inline void delay_us(uint32 us) {
+    (void)us;
+}
+
+#endif
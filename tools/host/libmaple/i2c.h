@@ -0,0 +1,43 @@
+/*
+ * libmaple I2C master interface for building device sources on the
+ * host, served by the mock sensor of tools/host/i2c_host.c
+ */
+
+#ifndef _LIBMAPLE_I2C_H_
+#define _LIBMAPLE_I2C_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct i2c_msg {
+    uint16 addr;
+    uint16 flags;
+    uint16 length;
+    uint16 xferred;
+    uint8 *data;
+} i2c_msg;
+
+#define I2C_MSG_READ            0x1
+
+#define I2C_FAST_MODE           0x1
+#define I2C_BUS_RESET           0x8
+
+#define I2C_ERROR_PROTOCOL      (-1)
+
+typedef struct i2c_dev {
+    uint32 flags;
+} i2c_dev;
+
+extern i2c_dev* const I2C1;
+
+void i2c_master_enable(i2c_dev *dev, uint32 flags);
+int32 i2c_master_xfer(i2c_dev *dev, i2c_msg *msgs, uint16 num, uint32 timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for usb_pma.cpp: usb_pma_write() with the device's
+ * kernels, on an array laid out like the F103 packet memory
+ *
+ * Offsets are PMA byte offsets as on the device, each halfword takes
+ * one 32-bit slot of usb_pma_host. Build it along with the tool, the C
+ * compiler driver takes it as C++.
+ */
+
+#include "usb_pma.h"
+#include "usb_pma_copy.h"
+
+#define HOST_PMA_SIZE           512
+#define HOST_PACKET_SIZE        64
+
+extern "C" {
+volatile uint32 usb_pma_host[HOST_PMA_SIZE / 2];
+}
+
+extern "C" void usb_pma_write(const uint8 *buf, uint16 len, uint16 pma_offset) {
+    pmaCopy<HOST_PACKET_SIZE>(buf, len, usb_pma_host + pma_offset / 2);
+}
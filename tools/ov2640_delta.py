@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+"""Generate ov2640_delta.h from ov2640_regs.h.
+
+Every sensor mode is OV2640_JPEG_INIT followed by the tables named in its
+OV2640_MODE_<name>_TABLES define. For each ordered pair of modes this
+writes the shortest table that takes the sensor from one mode to the
+other, and checks that replaying it on top of the first mode ends in
+exactly the register state of the second.
+
+    tools/ov2640_delta.py            regenerate ov2640_delta.h
+    tools/ov2640_delta.py --check    fail if ov2640_delta.h is stale
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+REGS_H = os.path.join(ROOT, "ov2640_regs.h")
+DELTA_H = os.path.join(ROOT, "ov2640_delta.h")
+
+BANK_SEL = 0xFF
+BANK_DSP = 0x00
+BANK_SENSOR = 0x01
+END = (0xFF, 0xFF)
+
+# DSP R_DVP_SP reset strobe: written around DSP changes, never diffed
+DSP_RESET = (BANK_DSP, 0xE0)
+# sensor COM7, bit 7 is the soft reset
+COM7 = (BANK_SENSOR, 0x12)
+# indirect address/data ports, their state cannot be tracked
+INDIRECT = {(BANK_DSP, r) for r in (0x7C, 0x7D, 0x90, 0x91, 0x92, 0x93, 0x96, 0x97)}
+
+BASE_TABLE = "OV2640_JPEG_INIT"
+
+
+class TableError(Exception):
+    pass
+
+
+def parse_tables(text):
+    tables = {}
+    for m in re.finditer(r"static const sccb_reg (\w+)\[\] = \{(.*?)\n\};", text, re.S):
+        pairs = [(int(r, 16), int(v, 16)) for r, v in
+                 re.findall(r"\{\s*(0x[0-9a-fA-F]+)\s*,\s*(0x[0-9a-fA-F]+)\s*\}", m.group(2))]
+        if not pairs or pairs[-1] != END:
+            raise TableError("%s is not terminated by {0xff, 0xff}" % m.group(1))
+        if END in pairs[:-1]:
+            raise TableError("%s has an early terminator" % m.group(1))
+        tables[m.group(1)] = pairs[:-1]
+    return tables
+
+
+def parse_modes(text):
+    return [(name, [t.strip() for t in tables.split(",")])
+            for name, tables in re.findall(r"#define OV2640_MODE_(\w+)_TABLES\s+(.*)", text)]
+
+
+def replay(writes, state, bank):
+    """Apply writes to a {(bank, reg): val} map, returns the final bank."""
+    for reg, val in writes:
+        if reg == BANK_SEL:
+            if val not in (BANK_DSP, BANK_SENSOR):
+                raise TableError("bank select to 0x%02x" % val)
+            bank = val
+            continue
+        if bank is None:
+            raise TableError("write to 0x%02x before any bank select" % reg)
+        state[(bank, reg)] = val
+    return bank
+
+
+def mode_state(tables, names):
+    state, order = {}, {}
+    bank = replay(tables[BASE_TABLE], state, None)
+    for name in names:
+        cur = bank
+        for reg, val in tables[name]:
+            if reg == BANK_SEL:
+                cur = val
+            else:
+                order[(cur, reg)] = len(order)
+                if (cur, reg) in INDIRECT:
+                    raise TableError("%s writes indirect register 0x%02x" % (name, reg))
+        bank = replay(tables[name], state, bank)
+    return state, order
+
+
+def dsp_reset_value(tables, names):
+    value = 0
+    bank = None
+    for name in names:
+        for reg, val in tables[name]:
+            if reg == BANK_SEL:
+                bank = val
+            elif (bank, reg) == DSP_RESET:
+                value |= val
+    return value
+
+
+def delta(src, dst, dst_order, reset):
+    changed = [k for k in dst if k != DSP_RESET and src.get(k) != dst[k]]
+    if COM7 in changed and (src.get(COM7, 0) ^ dst[COM7]) & 0x80:
+        raise TableError("modes differ in the COM7 soft reset bit")
+    changed.sort(key=lambda k: dst_order.get(k, -1))
+
+    out = []
+    sensor = [k for k in changed if k[0] == BANK_SENSOR]
+    dsp = [k for k in changed if k[0] == BANK_DSP]
+    if sensor:
+        out.append((BANK_SEL, BANK_SENSOR))
+        # COM7 reloads the window defaults, it has to go first
+        if COM7 in sensor:
+            sensor.remove(COM7)
+            sensor.insert(0, COM7)
+        out += [(k[1], dst[k]) for k in sensor]
+    if dsp:
+        out.append((BANK_SEL, BANK_DSP))
+        if reset:
+            out.append((DSP_RESET[1], reset))
+        out += [(k[1], dst[k]) for k in dsp]
+        if reset:
+            out.append((DSP_RESET[1], 0x00))
+    return out
+
+
+def verify(src, dst, writes, bank):
+    state = dict(src)
+    replay(writes, state, bank)
+    state.pop(DSP_RESET, None)
+    want = dict(dst)
+    want.pop(DSP_RESET, None)
+    if state != want:
+        bad = sorted(k for k in set(state) | set(want) if state.get(k) != want.get(k))
+        raise TableError("delta does not reach the target mode: %s" %
+                         ", ".join("%d:0x%02x" % k for k in bad))
+
+
+def fmt_table(name, writes):
+    lines = ["static const sccb_reg %s[] = {" % name]
+    lines += ["    {0x%02x, 0x%02x}," % w for w in writes + [END]]
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def generate(text):
+    tables = parse_tables(text)
+    modes = parse_modes(text)
+    if BASE_TABLE not in tables:
+        raise TableError("%s not found" % BASE_TABLE)
+    for name, names in modes:
+        for t in names:
+            if t not in tables:
+                raise TableError("mode %s uses unknown table %s" % (name, t))
+
+    states = {name: mode_state(tables, names) for name, names in modes}
+    out = [
+        "/*",
+        " * OV2640 mode switch tables",
+        " *",
+        " * generated by tools/ov2640_delta.py from ov2640_regs.h, do not edit.",
+        " * OV2640_DELTA[from][to] takes the sensor from one mode to another.",
+        " */",
+        "",
+        "#ifndef _OV2640_DELTA_H_",
+        "#define _OV2640_DELTA_H_",
+        "",
+        "#include \"sccb.h\"",
+        "",
+    ]
+    for i, (name, _) in enumerate(modes):
+        out.append("#define OV2640_DELTA_MODE_%-20s %d" % (name, i))
+    out.append("#define OV2640_DELTA_MODES %d" % len(modes))
+    out.append("")
+
+    matrix = []
+    for src_name, _ in modes:
+        row = []
+        for dst_name, dst_tables in modes:
+            if src_name == dst_name:
+                row.append("NULL")
+                continue
+            src, _ = states[src_name]
+            dst, dst_order = states[dst_name]
+            writes = delta(src, dst, dst_order, dsp_reset_value(tables, dst_tables))
+            verify(src, dst, writes, None)
+            table = "OV2640_DELTA_%s_TO_%s" % (src_name, dst_name)
+            out.append("/* %d register writes */" % sum(1 for r, _ in writes if r != BANK_SEL))
+            out.append(fmt_table(table, writes))
+            out.append("")
+            row.append(table)
+        matrix.append(row)
+
+    out.append("static const sccb_reg * const OV2640_DELTA[OV2640_DELTA_MODES][OV2640_DELTA_MODES] = {")
+    out += ["    {%s}," % ", ".join(row) for row in matrix]
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--check", action="store_true",
+                        help="verify ov2640_delta.h is up to date instead of writing it")
+    args = parser.parse_args()
+
+    with open(REGS_H) as f:
+        text = f.read()
+    try:
+        header = generate(text)
+    except TableError as e:
+        sys.exit("ov2640_delta: %s" % e)
+
+    if args.check:
+        try:
+            with open(DELTA_H) as f:
+                current = f.read()
+        except IOError:
+            current = None
+        if current != header:
+            sys.exit("ov2640_delta: ov2640_delta.h is out of date")
+        return
+
+    with open(DELTA_H, "w") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    main()
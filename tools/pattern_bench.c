@@ -0,0 +1,282 @@
+/*
+ * Host throughput benchmark and check of the test pattern source
+ *
+ *   cc -O2 -Itools/host -I. -o pattern_bench tools/pattern_bench.c test_pattern.c \
+ *      tools/host/usb_pma_host.cpp
+ *   ./pattern_bench [frames]
+ *
+ * Takes captures from test_pattern.c and cuts them into 64-byte packets
+ * through uvc_payload_fill() as the stream's pattern drain loops do,
+ * headers and PTS included, with no sensor or SPI in the way. Each
+ * packet then takes the stream's way out: into a ring of
+ * UVC_STREAM_RING_SIZE word-aligned slots, and from there through
+ * usb_pma_write() (the device kernels, tools/host/usb_pma_host.cpp)
+ * into packet memory, where the simulated host reads it. Checks every
+ * frame that host rebuilds against what the pattern should hold, then
+ * reports the time per packet for the drain alone and with the ring and
+ * refill, and how many frames per second the pattern would give on a
+ * full-speed bulk pipe (19 packets per 1 ms frame). On the device the
+ * same loops run with the XU pattern control set, and the `s` serial
+ * command shows their drain_cycles and the refill cycles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_pattern.h"
+#include "test_pattern_jpeg.h"
+#include "uvc_payload.h"
+#include "usb_pma.h"
+#include "check.h"
+
+#define PACKET_SIZE     64
+#define HEADER_SIZE     2
+#define HEADER_SIZE_TS  12
+#define WIDTH           320
+#define HEIGHT          240
+#define FRAME_MAX       (TEST_PATTERN_JPEG_PAD + 4096)
+#define BULK_BYTES_PER_S (19 * PACKET_SIZE * 1000)
+#define RING_SIZE       8               /* UVC_STREAM_RING_SIZE */
+#define RING_MASK       (RING_SIZE - 1)
+#define PMA_TX_ADDR     0xC0            /* USB_TX_ADDR */
+
+/* the simulated host */
+static uint8 frame[FRAME_MAX > WIDTH * HEIGHT * 2 ? FRAME_MAX : WIDTH * HEIGHT * 2];
+static uint32 frame_len;
+static uint32 host_frames;
+static uint32 host_bytes;
+static uint8 checking;
+static uint8 pattern;
+
+static void checkFrame(uint32 seq) {
+    uint32 i;
+
+    CHECK(frame_len == test_pattern_frame_length(seq));
+    if (frame_len != test_pattern_frame_length(seq)) {
+        return;
+    }
+    switch (pattern) {
+    case TEST_PATTERN_RAMP:
+        for (i = 0; i < frame_len && frame[i] == (uint8)(i + seq); i++)
+            ;
+        CHECK(i == frame_len);
+        break;
+
+    case TEST_PATTERN_BARS: {
+        uint32 line = WIDTH * 2, band = HEIGHT - HEIGHT / 8;
+        uint32 x, y, bad = 0;
+
+        for (y = 0; y < HEIGHT; y++) {
+            for (x = 0; x < line; x++) {
+                uint8 want = (y >= band) ?
+                    ((x & 1) ? 0x80 : (uint8)(x / 2 + seq * 4)) :
+                    test_pattern_bars[x * TEST_PATTERN_BAR_COUNT / line][x & 3];
+                bad += frame[y * line + x] != want;
+            }
+        }
+        CHECK(bad == 0);
+        break;
+    }
+
+    case TEST_PATTERN_JPEG: {
+        const uint8 *jpeg = TEST_PATTERN_JPEG_FRAME[seq % TEST_PATTERN_JPEG_FRAMES];
+        uint32 len = TEST_PATTERN_JPEG_FRAME_LEN[seq % TEST_PATTERN_JPEG_FRAMES];
+        uint32 off = 2;
+
+        /* the COM segments in front are skipped like any other marker
+         * segment, what is left is the canned frame */
+        CHECK(memcmp(frame, jpeg, 2) == 0);
+        while (off < frame_len && frame[off] == 0xFF && frame[off + 1] == 0xFE) {
+            off += 2 + ((frame[off + 2] << 8) | frame[off + 3]);
+        }
+        CHECK(off == 2 + TEST_PATTERN_JPEG_PAD);
+        CHECK(memcmp(frame + off, jpeg + 2, len - 2) == 0);
+        break;
+    }
+    }
+}
+
+static void hostPacket(const uint8 *pkt, uint16 len, uint32 first_seq) {
+    uint16 n = len - pkt[0];
+
+    host_bytes += n;
+    if (!checking) {
+        return;
+    }
+    if (frame_len + n <= sizeof(frame)) {
+        memcpy(frame + frame_len, pkt + pkt[0], n);
+    }
+    frame_len += n;
+    if (pkt[1] & UVC_STREAM_EOF) {
+        checkFrame(first_seq + host_frames);
+        host_frames++;
+        frame_len = 0;
+    }
+}
+
+static uint8 packet[PACKET_SIZE];
+
+/* the stream's ring and endpoint, uvc_packet and streamSend() */
+typedef struct ring_slot {
+    uint8 data[PACKET_SIZE];
+    uint16 len;
+} __attribute__((aligned(4))) ring_slot;
+
+extern volatile uint32 usb_pma_host[];
+
+static ring_slot ring[RING_SIZE];
+static uint32 ring_head;
+static uint32 ring_tail;
+static uint8 tx_busy;
+static uint16 tx_len;
+
+static void ringSend(void) {
+    ring_slot *slot;
+
+    if (ring_head == ring_tail) {
+        tx_busy = 0;
+        return;
+    }
+    slot = &ring[ring_tail & RING_MASK];
+    usb_pma_write(slot->data, slot->len, PMA_TX_ADDR);
+    tx_len = slot->len;
+    ring_tail++;
+    tx_busy = 1;
+}
+
+/* the host takes the packet in packet memory, the refill follows */
+static void hostTake(uint32 first_seq) {
+    const volatile uint32 *src = usb_pma_host + PMA_TX_ADDR / 2;
+    uint16 i;
+
+    for (i = 0; i < tx_len; i += 2) {
+        packet[i] = (uint8)src[i / 2];
+        packet[i + 1] = (uint8)(src[i / 2] >> 8);
+    }
+    hostPacket(packet, tx_len, first_seq);
+    ringSend();
+}
+
+/* one capture of burst frames, as the stream's pattern drain loop does
+ * it; with the ring, every packet goes out through packet memory */
+static uint32 capture(uint8 burst, uint8 via_ring) {
+    uvc_payload p;
+    uint32 packets = 0;
+    uint32 first;
+    uint8 framing = (pattern == TEST_PATTERN_JPEG) ? UVC_FRAMING_EOI : UVC_FRAMING_FIXED;
+    uint8 *out = packet;
+
+    test_pattern_capture(pattern, WIDTH, HEIGHT, burst);
+    first = test_pattern_first_seq();
+    host_frames = 0;
+    frame_len = 0;
+    uvc_payload_begin(&p, test_pattern_length(),
+                      (framing == UVC_FRAMING_FIXED) ? WIDTH * HEIGHT * 2 : 0, burst);
+    ring_head = ring_tail = 0;
+    tx_busy = 0;
+    while (!uvc_payload_done(&p)) {
+        uint8 flags = UVC_STREAM_EOH;
+        uint8 hlen = HEADER_SIZE;
+        uint16 len;
+
+        if (via_ring) {
+            if (ring_head - ring_tail == RING_SIZE) {
+                hostTake(first);
+            }
+            out = ring[ring_head & RING_MASK].data;
+        }
+        if (uvc_payload_frame_start(&p)) {
+            memset(out + 2, 0, HEADER_SIZE_TS - 2);
+            hlen = HEADER_SIZE_TS;
+            flags |= UVC_STREAM_PTS | UVC_STREAM_SCR;
+        }
+        if (framing == UVC_FRAMING_EOI) {
+            len = uvc_payload_fill(&p, out, PACKET_SIZE, hlen, flags,
+                                   UVC_FRAMING_EOI, test_pattern_read);
+        } else {
+            len = uvc_payload_fill(&p, out, PACKET_SIZE, hlen, flags,
+                                   UVC_FRAMING_FIXED, test_pattern_read);
+        }
+        if (len == 0) {
+            continue;
+        }
+        packets++;
+        if (!via_ring) {
+            hostPacket(out, len, first);
+            continue;
+        }
+        ring[ring_head & RING_MASK].len = len;
+        ring_head++;
+        if (!tx_busy) {
+            ringSend();
+        }
+    }
+    while (tx_busy) {
+        hostTake(first);
+    }
+    if (checking) {
+        CHECK(host_frames == burst);
+    }
+    return packets;
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double timeCaptures(int frames, uint8 via_ring, uint32 *packets) {
+    double t;
+    int i;
+
+    *packets = 0;
+    host_bytes = 0;
+    t = now();
+    for (i = 0; i < frames; i++) {
+        *packets += capture(1, via_ring);
+    }
+    return now() - t;
+}
+
+static void bench(const char *name, uint8 p, int frames) {
+    uint32 packets;
+    uint8 burst;
+    double t, t_ring;
+
+    pattern = p;
+
+    /* every burst length, every frame checked, straight and through
+     * the ring and packet memory */
+    checking = 1;
+    for (burst = 1; burst <= 7; burst++) {
+        capture(burst, 0);
+        capture(burst, 1);
+    }
+
+    checking = 0;
+    t = timeCaptures(frames, 0, &packets);
+    t_ring = timeCaptures(frames, 1, &packets);
+    printf("%-5s %6u bytes/frame %5u packets/frame %6.1f ns/packet, %6.1f with ring "
+           "and refill, %7.1f MB/s, full-speed bulk limit %5.1f frames/s\n",
+           name, host_bytes / frames, packets / frames, t * 1e9 / packets,
+           t_ring * 1e9 / packets, host_bytes / t_ring / 1e6,
+           (double)BULK_BYTES_PER_S * frames / packets / PACKET_SIZE);
+}
+
+int main(int argc, char **argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 200;
+
+    if (frames <= 0) {
+        frames = 1;
+    }
+    bench("BARS", TEST_PATTERN_BARS, frames);
+    bench("RAMP", TEST_PATTERN_RAMP, frames);
+    bench("JPEG", TEST_PATTERN_JPEG, frames);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
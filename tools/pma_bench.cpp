@@ -0,0 +1,167 @@
+/*
+ * Host benchmark and cycle model of the PMA copy kernels (usb_pma_copy.h)
+ *
+ *   c++ -std=c++11 -O2 -Itools/host -I. -o pma_bench tools/pma_bench.cpp
+ *   ./pma_bench [packets] [pma_store_cycles]
+ *
+ * Runs the kernels of usb_pma_write() against an array laid out like the
+ * F103 packet memory, one 32-bit slot per halfword, next to a copy of
+ * the per-halfword loop of libmaple's usb_copy_to_pma(). Checks that all
+ * paths leave the same packet memory for every source alignment and a
+ * range of lengths, then reports the host time per packet.
+ *
+ * Host time says little about the F103, where every PMA store crosses
+ * the APB1 bridge. The model below counts what each path does per
+ * 64-byte packet, as the kernels are written, and prices it with
+ * Cortex-M3 costs: 2 cycles per SRAM load, 1 per data operation, 3 per
+ * loop iteration (counter and taken branch), 8 per call, and
+ * pma_store_cycles (default 2) per PMA store. The store cost is the
+ * one the totals hang on; the DWT figures setup() prints from
+ * usb_pma_measure() are the measured counterpart.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "usb_pma_copy.h"
+#include "check.h"
+
+#define PACKET_SIZE     64
+#define PMA_SLOTS       (PACKET_SIZE / 2 + 1)
+
+static volatile uint32 pma[PMA_SLOTS];
+static volatile uint32 pma_ref[PMA_SLOTS];
+
+/* usb_copy_to_pma() as libmaple has it, a call per packet */
+__attribute__((noinline))
+static void genericCopy(const uint8 *buf, uint16 len, volatile uint32 *dst) {
+    uint16 n = len >> 1;
+    uint16 i;
+
+    for (i = 0; i < n; i++) {
+        *dst++ = buf[0] | (buf[1] << 8);
+        buf += 2;
+    }
+    if (len & 1) {
+        *dst = *buf;
+    }
+}
+
+/* usb_pma_write() is a call on the device too, out of line in SRAM */
+__attribute__((noinline))
+static void pmaWrite(const uint8 *buf, uint16 len, volatile uint32 *dst) {
+    pmaCopy<PACKET_SIZE>(buf, len, dst);
+}
+
+static void clearPma(void) {
+    uint16 i;
+
+    for (i = 0; i < PMA_SLOTS; i++) {
+        pma[i] = 0xDEAD;
+        pma_ref[i] = 0xDEAD;
+    }
+}
+
+static void checkPaths(void) {
+    static uint32 words[PACKET_SIZE / 4 + 1];
+    uint8 *src = (uint8*)words;
+    static const uint16 lens[] = {PACKET_SIZE, PACKET_SIZE - 1, 17, 2, 1, 0};
+    uint16 i, k, bad;
+    uint8 align;
+
+    for (i = 0; i < sizeof(words); i++) {
+        src[i] = (uint8)(i * 7 + 3);
+    }
+    for (align = 0; align < 4; align++) {
+        for (k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+            clearPma();
+            genericCopy(src + align, lens[k], pma_ref);
+            pmaWrite(src + align, lens[k], pma);
+            bad = 0;
+            for (i = 0; i < PMA_SLOTS; i++) {
+                bad += pma[i] != pma_ref[i];
+            }
+            CHECK(bad == 0);
+        }
+    }
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef void (*copy_fn)(const uint8 *buf, uint16 len, volatile uint32 *dst);
+
+static double timePath(copy_fn fn, const uint8 *src, uint16 len, long packets) {
+    double t = now();
+    long i;
+
+    for (i = 0; i < packets; i++) {
+        fn(src, len, pma);
+    }
+    return (now() - t) * 1e9 / packets;
+}
+
+/* per 64-byte packet, as the kernels are written */
+struct path_model {
+    const char *name;
+    uint16 loads;               /* from the ring slot in SRAM */
+    uint16 stores;              /* to the PMA */
+    uint16 ops;                 /* mask, shift or merge per halfword */
+    uint16 loops;               /* loop iterations */
+    uint16 calls;
+};
+
+static const path_model models[] = {
+    /* LDRB, LDRB, ORR with shift, STR per halfword, in a loop */
+    {"generic", PACKET_SIZE, PACKET_SIZE / 2, PACKET_SIZE / 2, PACKET_SIZE / 2, 1},
+    /* LDR per word, UXTH and LSR for its two halves, straight line; the
+     * alignment test and the length compare count as two ops */
+    {"aligned", PACKET_SIZE / 4, PACKET_SIZE / 2, PACKET_SIZE / 2 + 2, 0, 1},
+    /* as generic without the loop */
+    {"unaligned", PACKET_SIZE, PACKET_SIZE / 2, PACKET_SIZE / 2 + 2, 0, 1},
+};
+
+static uint32 modelCycles(const path_model *m, uint32 store_cycles) {
+    return m->loads * 2 + m->stores * store_cycles + m->ops + m->loops * 3 + m->calls * 8;
+}
+
+int main(int argc, char **argv) {
+    static uint32 words[PACKET_SIZE / 4 + 1];
+    const uint8 *src = (const uint8*)words;
+    long packets = (argc > 1) ? atol(argv[1]) : 2000000;
+    uint32 store_cycles = (argc > 2) ? (uint32)atoi(argv[2]) : 2;
+    double ns[3];
+    uint32 base;
+    uint8 i;
+
+    if (packets <= 0) {
+        packets = 1;
+    }
+    checkPaths();
+
+    ns[0] = timePath(genericCopy, src, PACKET_SIZE, packets);
+    ns[1] = timePath(pmaWrite, src, PACKET_SIZE, packets);
+    ns[2] = timePath(pmaWrite, src + 1, PACKET_SIZE, packets);
+
+    printf("%-9s %7s %6s %6s %5s %6s %14s %8s\n", "path", "host ns", "loads", "stores",
+           "ops", "loops", "model cycles", "vs gen");
+    base = modelCycles(&models[0], store_cycles);
+    for (i = 0; i < 3; i++) {
+        uint32 c = modelCycles(&models[i], store_cycles);
+
+        printf("%-9s %7.1f %6u %6u %5u %6u %14u %7.2fx\n", models[i].name, ns[i],
+               models[i].loads, models[i].stores, models[i].ops, models[i].loops, c,
+               (double)base / c);
+    }
+    printf("model: %u cycles per PMA store; compare the DWT line setup() prints\n",
+           store_cycles);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+"""Report the SRAM used by RAMFUNC() functions, from a GNU ld map file.
+
+    tools/ramfunc_report.py build/usb_uvc_sketch.ino.map
+"""
+
+import re
+import sys
+
+SECTION = re.compile(r"^ (\.data\.ramfunc\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)",
+                     re.M)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__.strip())
+    with open(sys.argv[1]) as f:
+        # ld wraps long section names onto the next line
+        text = re.sub(r"^( \.data\.ramfunc\.\S+)\n\s+", r"\1 ", f.read(), flags=re.M)
+
+    total = 0
+    for name, addr, size, obj in SECTION.findall(text):
+        size = int(size, 16)
+        if size == 0:
+            continue
+        total += size
+        print("%-40s 0x%s %5d  %s" % (name[len(".data.ramfunc."):], addr, size, obj.split("/")[-1]))
+    print("%-40s %16d bytes" % ("total", total))
+
+
+if __name__ == "__main__":
+    main()
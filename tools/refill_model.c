@@ -0,0 +1,204 @@
+/*
+ * Cycle model of the two endpoint refill paths of uvc_stream.c
+ *
+ *   cc -O2 -o refill_model tools/refill_model.c
+ *   ./refill_model [refill_cycles irq_cycles poll_cycles other_us]
+ *
+ * Plays the stream task, the EP1 interrupt and a full-speed bulk pipe on
+ * a virtual clock in core cycles (72 per us) for one second of
+ * streaming, for a range of drain costs per packet, and reports the
+ * packets per 1 ms USB frame each refill path gets:
+ *
+ *   interrupt  a drain pass fills the ring until it is full or it has
+ *              queued a ring's worth of packets; every
+ *              packet the host reads costs an exception entry and exit
+ *              plus the usb_lib dispatch to ep_int_in (irq_cycles) on
+ *              top of the refill (refill_cycles)
+ *   polled     the pass masks the interrupt, drains and, while the ring
+ *              is full, spins on CTR_TX (poll_cycles per refill) until
+ *              the slice of UVC_STREAM_POLL_SLICE_US is used up; the
+ *              interrupt handles what completes between passes
+ *
+ * A pass also ends with the frame, 2478 packets of 320x240 YUY2 from a
+ * pattern that is ready at once. Between passes the main loop runs
+ * other_us of other tasks. The pipe reads one packet every 1/19 ms while
+ * one is waiting in packet memory.
+ *
+ * The defaults: refill 200 cycles, about the aligned PMA kernel of
+ * tools/pma_bench.cpp plus the ring and endpoint register updates;
+ * interrupt 110, 12 entry and 10 exit cycles of the Cortex-M3 and about
+ * 90 for the libmaple handler from flash; polled 30 for the ISTR and
+ * endpoint register reads, the CTR clear and the call. On the device,
+ * `s` prints the measured refill cycles (send_cycles) and drain cycles,
+ * and the per-path packets per USB frame of pattern streams to hold
+ * against this table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CYCLES_PER_US   72
+#define FRAME_CYCLES    (1000 * CYCLES_PER_US)
+#define PACKET_CYCLES   (FRAME_CYCLES / 19)
+#define RING_SIZE       8               /* UVC_STREAM_RING_SIZE */
+#define SLICE_US        450             /* UVC_STREAM_POLL_SLICE_US */
+#define RUN_FRAMES      1000
+#define FRAME_PACKETS   2478            /* 320x240 YUY2 */
+
+typedef unsigned long long cycles;
+
+typedef struct model {
+    /* costs */
+    cycles drain;               /* one packet into the ring */
+    cycles refill;              /* ring slot into packet memory */
+    cycles irq;                 /* interrupt entry, exit and dispatch */
+    cycles poll;                /* one polled refill on top of it */
+    cycles other;               /* other tasks per main loop pass */
+
+    /* state */
+    cycles now;
+    cycles bus_done;            /* when the host has read the packet in PMA */
+    unsigned ring;              /* packets queued behind it */
+    unsigned left;              /* of the frame being drained */
+    int tx_busy;                /* the endpoint holds or awaits a packet */
+    int ctr;                    /* read by the host, not refilled yet */
+    int masked;
+    unsigned long packets;
+} model;
+
+/* the host reads what is in packet memory */
+static void bus(model *m, cycles t) {
+    if (m->tx_busy && !m->ctr && m->bus_done <= t) {
+        m->ctr = 1;
+        m->packets++;
+    }
+}
+
+/* streamSend() at time t */
+static void send(model *m, cycles t) {
+    m->ctr = 0;
+    if (m->ring == 0) {
+        m->tx_busy = 0;
+        return;
+    }
+    m->ring--;
+    m->tx_busy = 1;
+    m->bus_done = t + PACKET_CYCLES;
+}
+
+/* n cycles of main loop work, stretched by the interrupts that come in */
+static void run(model *m, cycles n) {
+    cycles end = m->now + n;
+
+    for (;;) {
+        bus(m, end);
+        if (!m->ctr || m->masked) {
+            break;
+        }
+        /* the handler preempts at the completion, or at once if the
+         * interrupt was masked when it came */
+        {
+            cycles at = (m->bus_done > m->now) ? m->bus_done : m->now;
+
+            end += m->irq + m->refill;
+            send(m, at + m->irq + m->refill);
+        }
+    }
+    m->now = end;
+}
+
+static void queue(model *m) {
+    run(m, m->drain);
+    m->ring++;
+    if (--m->left == 0) {
+        m->left = FRAME_PACKETS;
+    }
+    if (!m->tx_busy) {
+        /* streamKick() */
+        run(m, m->refill);
+        send(m, m->now);
+    }
+}
+
+static void passIrq(model *m) {
+    unsigned queued = 0;
+
+    while (m->ring < RING_SIZE && queued++ < RING_SIZE) {
+        queue(m);
+        if (m->left == FRAME_PACKETS) {
+            break;
+        }
+    }
+}
+
+static void passPolled(model *m) {
+    cycles slice_end = m->now + SLICE_US * CYCLES_PER_US;
+
+    m->masked = 1;
+    for (;;) {
+        if (m->now >= slice_end) {
+            break;
+        }
+        if (m->ring < RING_SIZE) {
+            queue(m);
+            if (m->left == FRAME_PACKETS) {
+                break;
+            }
+            continue;
+        }
+        /* streamPollWait(), the ring is full so a packet is out */
+        bus(m, m->now);
+        if (!m->ctr) {
+            if (m->bus_done >= slice_end) {
+                m->now = slice_end;
+                break;
+            }
+            m->now = m->bus_done;
+            bus(m, m->now);
+        }
+        m->now += m->poll + m->refill;
+        send(m, m->now);
+    }
+    m->masked = 0;
+}
+
+static double packetsPerFrame(model m, int polled) {
+    m.now = 0;
+    m.ring = 0;
+    m.left = FRAME_PACKETS;
+    m.tx_busy = 0;
+    m.ctr = 0;
+    m.masked = 0;
+    m.packets = 0;
+    while (m.now < (cycles)RUN_FRAMES * FRAME_CYCLES) {
+        if (polled) {
+            passPolled(&m);
+        } else {
+            passIrq(&m);
+        }
+        run(&m, m.other);
+    }
+    return (double)m.packets * FRAME_CYCLES / m.now;
+}
+
+int main(int argc, char **argv) {
+    /* pattern drains in SRAM up to the ArduCAM at 4.5 MHz SPI */
+    static const unsigned drains[] = {400, 800, 1600, 2400, 3200, 4000, 7900};
+    model m = {0};
+    unsigned i;
+
+    m.refill = (argc > 1) ? atoi(argv[1]) : 200;
+    m.irq = (argc > 2) ? atoi(argv[2]) : 110;
+    m.poll = (argc > 3) ? atoi(argv[3]) : 30;
+    m.other = (cycles)((argc > 4) ? atoi(argv[4]) : 100) * CYCLES_PER_US;
+
+    printf("refill %llu, interrupt %llu, polled %llu cycles, other tasks %llu us per pass\n",
+           m.refill, m.irq, m.poll, m.other / CYCLES_PER_US);
+    printf("%12s %14s %14s\n", "drain cycles", "irq pkts/fr", "polled pkts/fr");
+    for (i = 0; i < sizeof(drains) / sizeof(drains[0]); i++) {
+        m.drain = drains[i];
+        printf("%12u %14.2f %14.2f\n", drains[i], packetsPerFrame(m, 0),
+               packetsPerFrame(m, 1));
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Sensor register scripts over the vendor bulk interface (see reg_script.h).
+
+    tools/reg_script.py upload OV2640_320x240 [...]  write tables from ov2640_regs.h
+    tools/reg_script.py read [--bank N] REG [...]    read registers
+    tools/reg_script.py simulate                     bulk scripts vs per-register
+                                                     control requests, no device
+
+upload and read need pyusb and access to the device.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ov2640_delta  # noqa: E402
+
+VID, PID = 0x1EAF, 0x0027
+VENDOR_IF = 2
+EP_OUT, EP_IN = 0x03, 0x84
+PACKET = 64
+
+OP_WRITE, OP_READ, OP_DELAY = 0x00, 0x01, 0x02
+OP_SIZE = 4
+OPS_PER_PACKET = PACKET // OP_SIZE
+STATUS = {0: "ok", 1: "SCCB transfer failed", 2: "bad operation", 3: "too many reads"}
+
+# simulation model, full-speed USB and a 400 kHz SCCB bus
+SCCB_WRITE_US = 75.0        # start, 3 bytes with ACK, stop
+PACKET_BUS_US = 50.0        # 64-byte bulk packet with token and handshake
+FRAME_US = 1000.0
+
+
+def encode(ops):
+    return b"".join(struct.pack("BBBB", op, reg, val, arg) for op, reg, val, arg in ops)
+
+
+def table_ops(writes):
+    return [(OP_WRITE, reg, val, 0) for reg, val in writes]
+
+
+class Device:
+    def __init__(self):
+        import usb.core
+        import usb.util
+        self.dev = usb.core.find(idVendor=VID, idProduct=PID)
+        if self.dev is None:
+            sys.exit("reg_script: device %04x:%04x not found" % (VID, PID))
+        usb.util.claim_interface(self.dev, VENDOR_IF)
+
+    def run(self, ops):
+        data = encode(ops)
+        self.dev.write(EP_OUT, data)
+        if len(data) % PACKET == 0:
+            # the script ends with a short packet
+            self.dev.write(EP_OUT, b"")
+        reply = bytes(self.dev.read(EP_IN, PACKET, timeout=5000))
+        status, nread, executed = struct.unpack_from("<BBH", reply)
+        return status, executed, list(reply[4:4 + nread])
+
+
+def check(status, executed, total):
+    if status != 0:
+        sys.exit("reg_script: %s after %d of %d operations" %
+                 (STATUS.get(status, "status 0x%02x" % status), executed, total))
+
+
+def cmd_upload(args):
+    with open(ov2640_delta.REGS_H) as f:
+        tables = ov2640_delta.parse_tables(f.read())
+    ops = []
+    for name in args.tables:
+        if name not in tables:
+            sys.exit("reg_script: no table %s in ov2640_regs.h" % name)
+        ops += table_ops(tables[name])
+    status, executed, _ = Device().run(ops)
+    check(status, executed, len(ops))
+    print("%d writes" % executed)
+
+
+def cmd_read(args):
+    ops = [(OP_WRITE, 0xFF, args.bank, 0)]
+    ops += [(OP_READ, int(r, 0), 0, 0) for r in args.regs]
+    status, executed, values = Device().run(ops)
+    check(status, executed, len(ops))
+    for reg, val in zip(args.regs, values):
+        print("0x%02x = 0x%02x" % (int(reg, 0), val))
+
+
+def control_us(n, control_rtt):
+    # one synchronous control transfer per register; the write itself
+    # overlaps the host's turnaround for the next request
+    return n * max(control_rtt, SCCB_WRITE_US)
+
+
+def bulk_us(n):
+    # the OUT endpoint NAKs while a packet executes, so packets do not
+    # overlap with the register writes; the reply comes in the next frame
+    t = 0.0
+    for i in range(int(math.ceil(n / float(OPS_PER_PACKET)))):
+        k = min(OPS_PER_PACKET, n - i * OPS_PER_PACKET)
+        t += PACKET_BUS_US + k * SCCB_WRITE_US
+    return t + FRAME_US
+
+
+def cmd_simulate(args):
+    with open(ov2640_delta.REGS_H) as f:
+        tables = ov2640_delta.parse_tables(f.read())
+    print("control transfer round trip %.0f us, SCCB write %.0f us" %
+          (args.control_us, SCCB_WRITE_US))
+    print("%-20s %6s %12s %12s %8s" % ("table", "writes", "control ms", "bulk ms", "speedup"))
+    for name, writes in tables.items():
+        n = len(writes)
+        c = control_us(n, args.control_us)
+        b = bulk_us(n)
+        print("%-20s %6d %12.1f %12.1f %7.1fx" % (name, n, c / 1e3, b / 1e3, c / b))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="cmd")
+    p = sub.add_parser("upload", help="write register tables from ov2640_regs.h")
+    p.add_argument("tables", nargs="+")
+    p = sub.add_parser("read", help="read registers")
+    p.add_argument("--bank", type=lambda v: int(v, 0), default=1)
+    p.add_argument("regs", nargs="+")
+    p = sub.add_parser("simulate", help="model bulk scripts against control requests")
+    p.add_argument("--control-us", type=float, default=1000.0,
+                   help="host round trip of one control transfer (default 1000)")
+    args = parser.parse_args()
+
+    if args.cmd == "upload":
+        cmd_upload(args)
+    elif args.cmd == "read":
+        cmd_read(args)
+    elif args.cmd == "simulate":
+        cmd_simulate(args)
+    else:
+        parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
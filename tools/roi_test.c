@@ -0,0 +1,218 @@
+/*
+ * Region of interest checks for ov2640.c against a mock sensor
+ *
+ *   cc -O2 -Itools/host -I. -o roi_test tools/roi_test.c ov2640.c \
+ *      sccb.c tools/host/i2c_host.c
+ *   ./roi_test
+ *
+ * Brings the sensor up on the mock I2C bus of tools/host, sets regions
+ * of interest through ov2640_set_roi() and reads back what landed in
+ * the DSP window and zoom registers. The split fields (VHYX, TEST,
+ * ZMHH) and the dividers in CTRLI are decoded here from the register
+ * map, independently of roiTable(), and compared with windows worked
+ * out by hand: the full frame, the smallest windows, unaligned and far
+ * offsets, and both sides of the divider thresholds. Also checks the
+ * regions that keep the 320x240 output the YUY2 frame descriptor
+ * announces. Exits non-zero when a check fails.
+ */
+
+#include <stdio.h>
+
+#include "ov2640.h"
+#include "i2c_host.h"
+#include "check.h"
+
+/* DSP bank, from the OV2640 register map */
+#define DSP_CTRLI               0x50
+#define DSP_HSIZE               0x51
+#define DSP_VSIZE               0x52
+#define DSP_XOFFL               0x53
+#define DSP_YOFFL               0x54
+#define DSP_VHYX                0x55
+#define DSP_TEST                0x57
+#define DSP_ZMOW                0x5a
+#define DSP_ZMOH                0x5b
+#define DSP_ZMHH                0x5c
+
+typedef struct roi_case {
+    const char *name;
+    uint8 mode;
+    ov2640_window roi;          /* UXGA pixels */
+    int ret;
+    ov2640_window win;          /* DSP input window */
+    uint16 out_w, out_h;        /* zoom output */
+    uint8 hdiv, vdiv;
+} roi_case;
+
+#define YUY2    OV2640_MODE_YUY2_320x240
+#define MJPEG   OV2640_MODE_MJPEG_1600x1200
+
+static const roi_case cases[] = {
+    /* the YUY2 modes read out 800x600 and send at most 320x240 */
+    {"yuy2 full height less 4", YUY2, {0, 0, 1600, 1196}, 0,
+     {0, 0, 800, 596}, 320, 236, 1, 1},
+    {"yuy2 control minimum", YUY2, {0, 0, 64, 64}, 0, {0, 0, 32, 32}, 32, 32, 0, 0},
+    {"yuy2 smallest window", YUY2, {0, 0, 8, 8}, 0, {0, 0, 4, 4}, 4, 4, 0, 0},
+    {"yuy2 too narrow", YUY2, {0, 0, 7, 8}, -1, {0, 0, 0, 0}, 0, 0, 0, 0},
+    {"yuy2 too low", YUY2, {0, 0, 8, 7}, -1, {0, 0, 0, 0}, 0, 0, 0, 0},
+    {"yuy2 empty", YUY2, {0, 0, 0, 64}, -1, {0, 0, 0, 0}, 0, 0, 0, 0},
+    {"yuy2 past the edge", YUY2, {1500, 0, 200, 100}, -1, {0, 0, 0, 0}, 0, 0, 0, 0},
+    {"yuy2 unaligned offset", YUY2, {13, 7, 400, 300}, 0,
+     {4, 0, 200, 148}, 200, 148, 0, 0},
+    {"yuy2 bottom right", YUY2, {1536, 1136, 64, 64}, 0,
+     {768, 568, 32, 32}, 32, 32, 0, 0},
+    /* twice the output on both axes: both dividers on */
+    {"yuy2 divide both", YUY2, {0, 0, 1280, 960}, 0, {0, 0, 640, 480}, 320, 240, 1, 1},
+    /* 636 / 2 = 318 is short of the 320 output, 476 / 2 = 238 is not
+     * short of 236 */
+    {"yuy2 divide rows only", YUY2, {0, 0, 1272, 952}, 0,
+     {0, 0, 636, 476}, 320, 236, 0, 1},
+    /* the MJPEG mode reads out the whole array and sends the window */
+    {"mjpeg wide window", MJPEG, {0, 0, 1600, 1196}, 0,
+     {0, 0, 1600, 1196}, 1600, 1196, 0, 0},
+    {"mjpeg far offset", MJPEG, {1203, 1001, 200, 100}, 0,
+     {1200, 1000, 200, 100}, 200, 100, 0, 0},
+    /* a region has to fit every mode, it stays set across switches */
+    {"mjpeg smallest window", MJPEG, {0, 0, 8, 8}, 0, {0, 0, 8, 8}, 8, 8, 0, 0},
+    {"mjpeg too small for yuy2", MJPEG, {0, 0, 4, 4}, -1, {0, 0, 0, 0}, 0, 0, 0, 0},
+};
+
+static uint8 dsp(uint8 reg) {
+    return i2c_host_regs[0][reg];
+}
+
+/* every window register written once by the last ov2640_set_roi() */
+static int windowWritten(void) {
+    static const uint8 regs[] = {
+        DSP_CTRLI, DSP_HSIZE, DSP_VSIZE, DSP_XOFFL, DSP_YOFFL,
+        DSP_VHYX, DSP_TEST, DSP_ZMOW, DSP_ZMOH, DSP_ZMHH,
+    };
+    uint8 i;
+
+    for (i = 0; i < sizeof(regs); i++) {
+        if (i2c_host_writes_to(0, regs[i]) != 1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void checkCase(const roi_case *c) {
+    uint16 hsize, vsize, xoff, yoff, zmow, zmoh;
+    uint8 ctrli, hdiv, vdiv;
+    ov2640_window out;
+    int ret;
+
+    CHECK(ov2640_set_mode(c->mode) == 0);
+    i2c_host_log_len = 0;
+    ret = ov2640_set_roi(&c->roi);
+    if (ret != c->ret) {
+        printf("  %s: returned %d\n", c->name, ret);
+    }
+    CHECK(ret == c->ret);
+    if (c->ret != 0) {
+        /* a rejected region writes nothing */
+        CHECK(i2c_host_log_len == 0);
+        return;
+    }
+    CHECK(windowWritten());
+
+    hsize = dsp(DSP_HSIZE) | ((dsp(DSP_VHYX) & 0x08) << 5) | ((dsp(DSP_TEST) & 0x80) << 2);
+    vsize = dsp(DSP_VSIZE) | ((dsp(DSP_VHYX) & 0x80) << 1);
+    xoff = dsp(DSP_XOFFL) | ((dsp(DSP_VHYX) & 0x07) << 8);
+    yoff = dsp(DSP_YOFFL) | ((dsp(DSP_VHYX) & 0x70) << 4);
+    zmow = dsp(DSP_ZMOW) | ((dsp(DSP_ZMHH) & 0x03) << 8);
+    zmoh = dsp(DSP_ZMOH) | ((dsp(DSP_ZMHH) & 0x04) << 6);
+    ctrli = dsp(DSP_CTRLI);
+    hdiv = ctrli & 0x07;
+    vdiv = (ctrli >> 3) & 0x07;
+
+    printf("  %-24s win %4u,%4u %4ux%-4u out %4ux%-4u div %u/%u\n", c->name,
+           xoff, yoff, hsize * 4, vsize * 4, zmow * 4, zmoh * 4, hdiv, vdiv);
+    CHECK(xoff == c->win.x && yoff == c->win.y);
+    CHECK(hsize * 4 == c->win.w && vsize * 4 == c->win.h);
+    CHECK(zmow * 4 == c->out_w && zmoh * 4 == c->out_h);
+    CHECK(hdiv == c->hdiv && vdiv == c->vdiv);
+    /* the low-power data path goes with any divider */
+    CHECK(!(ctrli & 0x80) == !(hdiv | vdiv));
+    /* the bits of VHYX and ZMHH that hold nothing stay clear */
+    CHECK((dsp(DSP_ZMHH) & ~0x07) == 0 && (dsp(DSP_TEST) & 0x7F) == 0);
+
+    CHECK(ov2640_output_size(c->mode, &out) == 0);
+    CHECK(out.w == c->out_w && out.h == c->out_h);
+}
+
+/* the full array is the stock window: no window writes while none is
+ * set, the full mode tables once one was */
+static void checkFullFrame(void) {
+    static const ov2640_window full = {0, 0, OV2640_UXGA_WIDTH, OV2640_UXGA_HEIGHT};
+    static const ov2640_window part = {0, 0, 800, 600};
+    ov2640_window out;
+
+    CHECK(ov2640_set_mode(YUY2) == 0);
+    i2c_host_log_len = 0;
+    CHECK(ov2640_set_roi(&full) == 0);
+    CHECK(i2c_host_log_len == 0);
+    CHECK(ov2640_output_size(YUY2, &out) == 0 && out.w == 320 && out.h == 240);
+    CHECK(ov2640_output_size(MJPEG, &out) == 0 && out.w == 1600 && out.h == 1200);
+
+    CHECK(ov2640_set_roi(&part) == 0);
+    i2c_host_log_len = 0;
+    CHECK(ov2640_set_roi(&full) == 0);
+    CHECK(i2c_host_log_len > 20);
+    CHECK(ov2640_get_mode() == YUY2);
+    CHECK(ov2640_output_size(YUY2, &out) == 0 && out.w == 320 && out.h == 240);
+}
+
+/* a region stays set across a mode switch, mapped onto the new mode */
+static void checkModeSwitch(void) {
+    static const ov2640_window roi = {400, 300, 800, 600};
+    ov2640_window out;
+
+    CHECK(ov2640_set_mode(YUY2) == 0);
+    CHECK(ov2640_set_roi(&roi) == 0);
+    i2c_host_log_len = 0;
+    CHECK(ov2640_set_mode(MJPEG) == 0);
+    /* the full mode tables first, the window last */
+    CHECK(i2c_host_log_len > 20);
+    CHECK(dsp(DSP_HSIZE) == 800 / 4 && dsp(DSP_VSIZE) == 600 / 4);
+    CHECK(dsp(DSP_XOFFL) == (400 & 0xFF) && dsp(DSP_YOFFL) == (300 & 0xFF));
+    CHECK(dsp(DSP_ZMOW) == 800 / 4 && dsp(DSP_ZMOH) == 600 / 4);
+    CHECK(ov2640_output_size(MJPEG, &out) == 0 && out.w == 800 && out.h == 600);
+}
+
+/* 4:3 regions in steps of 64x48 from 640x480 up come out at 320x240 */
+static void checkDescriptorSize(void) {
+    uint16 k, bad = 0;
+
+    CHECK(ov2640_set_mode(YUY2) == 0);
+    for (k = 10; k <= 25; k++) {
+        ov2640_window roi = {0, 0, (uint16)(64 * k), (uint16)(48 * k)};
+        ov2640_window out;
+
+        roi.x = (OV2640_UXGA_WIDTH - roi.w) / 2;
+        roi.y = (OV2640_UXGA_HEIGHT - roi.h) / 2;
+        if (ov2640_set_roi(&roi) != 0 || ov2640_output_size(YUY2, &out) != 0 ||
+            out.w != 320 || out.h != 240) {
+            bad++;
+        }
+    }
+    CHECK(bad == 0);
+}
+
+int main(void) {
+    uint8 i;
+
+    i2c_host_reset();
+    CHECK(ov2640_init() == 0);
+
+    checkFullFrame();
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        checkCase(&cases[i]);
+    }
+    checkModeSwitch();
+    checkDescriptorSize();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
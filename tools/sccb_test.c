@@ -0,0 +1,182 @@
+/*
+ * Bring-up checks for sccb.c and ov2640.c against a mock sensor
+ *
+ *   cc -O2 -Itools/host -I. -o sccb_test tools/sccb_test.c ov2640.c \
+ *      sccb.c tools/host/i2c_host.c
+ *   ./sccb_test
+ *
+ * Runs ov2640_init() on the mock I2C bus of tools/host and checks what
+ * reached the sensor against the register tables of ov2640_regs.h,
+ * replayed here without sccb.c:
+ *
+ *   - one soft reset, and every register of the init and YUY2 mode
+ *     tables at its table value afterwards
+ *   - no transfer over SCCB_BATCH writes, bank selects that change
+ *     nothing dropped
+ *   - a switch through ov2640_delta.h ends with the registers the full
+ *     tables of the new mode set
+ *   - a reset that is not acknowledged fails ov2640_init_begin() and
+ *     ov2640_init(); a sensor that acknowledges nothing fails the probe
+ *     and gets no writes; both come up once the bus recovers
+ *
+ * Exits non-zero when a check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ov2640.h"
+#include "ov2640_regs.h"
+#include "sccb.h"
+#include "i2c_host.h"
+#include "check.h"
+
+#define SENSOR_COM7             0x12
+
+/* the tables as the sensor should end up, and which registers they set */
+static uint8 want[2][256];
+static uint8 set[2][256];
+static uint8 want_bank;
+
+static void replayReset(void) {
+    memset(want, 0, sizeof(want));
+    memset(set, 0, sizeof(set));
+    want_bank = 0;
+}
+
+static void replay(const sccb_reg *table) {
+    for (; table->reg != SCCB_REG_END || table->val != SCCB_REG_END; table++) {
+        if (table->reg == SCCB_BANK_SEL) {
+            want_bank = table->val & 1;
+            continue;
+        }
+        want[want_bank][table->reg] = table->val;
+        set[want_bank][table->reg] = 1;
+    }
+}
+
+/* registers the replayed tables set that the sensor does not hold */
+static uint16 mismatches(void) {
+    uint16 bank, reg, n = 0;
+
+    for (bank = 0; bank < 2; bank++) {
+        for (reg = 0; reg < 256; reg++) {
+            if (set[bank][reg] && i2c_host_regs[bank][reg] != want[bank][reg]) {
+                printf("  bank %u reg 0x%02x: 0x%02x, table 0x%02x\n", bank, reg,
+                       i2c_host_regs[bank][reg], want[bank][reg]);
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+static void checkInit(void) {
+    sccb_stats before;
+    uint16 i, redundant = 0;
+    uint8 bank = 0;
+
+    i2c_host_reset();
+    before = *sccb_get_stats();
+    CHECK(ov2640_init() == 0);
+    CHECK(i2c_host_resets == 1);
+    CHECK(ov2640_get_mode() == OV2640_MODE_YUY2_320x240);
+
+    replayReset();
+    replay(OV2640_JPEG_INIT);
+    replay(OV2640_YUV422);
+    replay(OV2640_320x240);
+    CHECK(mismatches() == 0);
+
+    /* bank selects on the bus after the reset all change the bank */
+    for (i = 0; i < i2c_host_log_len; i++) {
+        const i2c_host_write *w = &i2c_host_log[i];
+
+        if (w->bank == 1 && w->reg == SENSOR_COM7) {
+            bank = 0;
+            redundant = 0;
+        } else if (w->reg == SCCB_BANK_SEL) {
+            redundant += (w->val & 1) == bank;
+            bank = w->val & 1;
+        }
+    }
+    printf("  init: %u writes in %u transfers, at most %u messages, %u bank selects dropped\n",
+           sccb_get_stats()->writes - before.writes, i2c_host_xfers, i2c_host_xfer_max,
+           sccb_get_stats()->bank_skips - before.bank_skips);
+    /* the one after the reset, which sccb.c cannot know is redundant */
+    CHECK(redundant <= 1);
+    CHECK(sccb_get_stats()->bank_skips != before.bank_skips);
+    CHECK(i2c_host_xfer_max <= SCCB_BATCH);
+    CHECK(sccb_get_stats()->bus_errors == before.bus_errors);
+}
+
+/* the deltas land on what the full tables of the new mode set */
+static void checkDelta(void) {
+    uint16 start = i2c_host_log_len;
+    uint16 log_len;
+
+    CHECK(ov2640_set_mode(OV2640_MODE_MJPEG_1600x1200) == 0);
+    log_len = i2c_host_log_len;
+    replayReset();
+    replay(OV2640_YUV422);
+    replay(OV2640_JPEG);
+    replay(OV2640_1600x1200);
+    CHECK(mismatches() == 0);
+
+    CHECK(ov2640_set_mode(OV2640_MODE_RAW8_320x240) == 0);
+    replayReset();
+    replay(OV2640_YUV422);
+    replay(OV2640_RAW8);
+    replay(OV2640_320x240);
+    CHECK(mismatches() == 0);
+    printf("  YUY2 to MJPEG to Bayer: %u writes\n", i2c_host_log_len - start);
+    CHECK(log_len < i2c_host_log_len);
+
+    /* the same mode again writes nothing */
+    log_len = i2c_host_log_len;
+    CHECK(ov2640_set_mode(OV2640_MODE_RAW8_320x240) == 0);
+    CHECK(i2c_host_log_len == log_len);
+}
+
+static void checkFailedReset(void) {
+    uint16 errors;
+
+    i2c_host_reset();
+    i2c_host_fail_bank = 1;
+    i2c_host_fail_reg = SENSOR_COM7;
+    errors = sccb_get_stats()->bus_errors;
+    CHECK(ov2640_init_begin() != 0);
+    CHECK(i2c_host_resets == 0);
+    CHECK(sccb_get_stats()->bus_errors == errors + 1);
+    CHECK(ov2640_init() != 0);
+    CHECK(ov2640_get_mode() == OV2640_MODE_UNKNOWN);
+
+    /* the next try goes through */
+    i2c_host_fail_reg = -1;
+    i2c_host_resets = 0;
+    CHECK(ov2640_init() == 0);
+    CHECK(i2c_host_resets == 1);
+}
+
+static void checkAbsent(void) {
+    i2c_host_reset();
+    i2c_host_nak_all = 1;
+    CHECK(ov2640_init_begin() == -1);
+    CHECK(ov2640_init() != 0);
+    CHECK(i2c_host_log_len == 0);
+    CHECK(i2c_host_resets == 0);
+
+    i2c_host_nak_all = 0;
+    CHECK(ov2640_init() == 0);
+    CHECK(i2c_host_resets == 1);
+}
+
+int main(void) {
+    checkInit();
+    checkDelta();
+    checkFailedReset();
+    checkAbsent();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
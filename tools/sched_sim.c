@@ -0,0 +1,155 @@
+/*
+ * Deterministic timing checks for sched.c on a virtual clock
+ *
+ *   cc -O2 -Itools/host -I. -o sched_sim tools/sched_sim.c sched.c
+ *   ./sched_sim
+ *
+ * Tasks advance the virtual clock by the time they pretend to take, so
+ * every run is reproducible. Exits non-zero when a check fails.
+ */
+
+#include <stdio.h>
+
+#include "sched.h"
+#include "check.h"
+
+static uint32 now_us;
+
+/* per-task cost in virtual microseconds, changed by the scenarios */
+static uint32 stream_cost, control_cost, script_cost, tick_cost;
+
+static uint32 virtualClock(void) {
+    return now_us;
+}
+
+static int control_exempt;
+
+static void streamRun(void)  { now_us += stream_cost; }
+static void controlRun(void) {
+    now_us += control_cost;
+    if (control_exempt) {
+        sched_exempt();
+    }
+}
+static void scriptRun(void)  { now_us += script_cost; }
+static void tickRun(void)    { now_us += tick_cost; }
+
+/* the layout of usb_datachannel.cpp, budgets rounded */
+static sched_task stream_task = {
+    .name = "stream", .run = streamRun, .priority = 0, .budget_us = 500, .deadline_us = 1000,
+};
+static sched_task control_task = {
+    .name = "control", .run = controlRun, .priority = 1, .budget_us = 200,
+};
+static sched_task script_task = {
+    .name = "script", .run = scriptRun, .priority = 2, .budget_us = 300,
+};
+static sched_task tick_task = {
+    .name = "tick", .run = tickRun, .priority = 3, .period_us = 10000, .budget_us = 10,
+};
+
+static void setup(uint32 start) {
+    now_us = start;
+    stream_cost = 400;
+    control_cost = 20;
+    script_cost = 300;
+    tick_cost = 5;
+    sched_init(virtualClock);
+    CHECK(sched_add(&script_task) == 0);
+    CHECK(sched_add(&stream_task) == 0);
+    CHECK(sched_add(&control_task) == 0);
+}
+
+static void rounds(int n) {
+    while (n--) {
+        sched_run();
+    }
+}
+
+static void report(const char *scenario) {
+    uint8 i;
+
+    printf("%s\n", scenario);
+    for (i = 0; i < sched_num_tasks(); i++) {
+        const sched_task *t = sched_get_task(i);
+        printf("  %-8s runs %6u overruns %4u misses %4u max run %5u us max gap %5u us\n",
+               t->name, t->runs, t->overruns, t->misses, t->max_run_us, t->max_gap_us);
+    }
+}
+
+int main(void) {
+    /* tasks come out in priority order whatever order they were added in */
+    setup(0);
+    CHECK(sched_get_task(0) == &stream_task);
+    CHECK(sched_get_task(1) == &control_task);
+    CHECK(sched_get_task(2) == &script_task);
+
+    /* all within budget: the stream never waits longer than a frame */
+    rounds(10000);
+    report("within budget");
+    CHECK(stream_task.misses == 0);
+    CHECK(stream_task.max_gap_us <= 1000);
+    CHECK(stream_task.overruns == 0 && script_task.overruns == 0);
+
+    /* one long script run delays the stream by exactly one round */
+    setup(0);
+    rounds(10);
+    script_cost = 1500;
+    rounds(1);
+    script_cost = 300;
+    rounds(10);
+    report("one script overrun");
+    CHECK(script_task.overruns == 1);
+    CHECK(stream_task.misses == 1);
+    CHECK(stream_task.max_gap_us == 400 + 20 + 1500);
+
+    /* a mode switch with the stream stopped is neither an overrun nor
+     * a miss, and the gaps after it start over */
+    setup(0);
+    rounds(10);
+    control_cost = 5000;
+    control_exempt = 1;
+    rounds(1);
+    control_cost = 20;
+    control_exempt = 0;
+    rounds(10);
+    report("exempt mode switch");
+    CHECK(control_task.exempt == 1);
+    CHECK(control_task.overruns == 0);
+    CHECK(stream_task.misses == 0);
+    CHECK(stream_task.max_gap_us == 400 + 20 + 300);
+
+    /* a task that would break the stream deadline is refused */
+    setup(0);
+    {
+        sched_task greedy = {.name = "greedy", .run = tickRun, .priority = 4, .budget_us = 200};
+        CHECK(sched_add(&greedy) != 0);
+        CHECK(sched_num_tasks() == 3);
+    }
+
+    /* a periodic task keeps its period; its budget has to come out of
+     * somebody else's to fit the round */
+    script_task.budget_us = 290;
+    setup(0);
+    stream_cost = 300;
+    script_cost = 190;
+    CHECK(sched_add(&tick_task) == 0);
+    rounds(20000);
+    report("periodic task");
+    /* due tasks start at the next round, so a period stretches by less
+     * than one round */
+    CHECK(tick_task.max_gap_us >= 10000 && tick_task.max_gap_us < 10000 + 1000);
+    CHECK(tick_task.runs > now_us / (10000 + 1000));
+    CHECK(stream_task.misses == 0);
+    script_task.budget_us = 300;
+
+    /* timing holds across the 32-bit microsecond wrap */
+    setup(0xFFFFFFFF - 50000);
+    rounds(1000);
+    report("clock wrap");
+    CHECK(stream_task.misses == 0);
+    CHECK(stream_task.max_gap_us <= 1000);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""Generate test_pattern_jpeg.h, the canned JPEG frames of the test pattern source.
+
+Each frame is a baseline JPEG of 320x240 colour bars, 4:4:4, built from
+flat 8x8 blocks so that only DC coefficients are coded: with the small
+Huffman tables written here a block takes two bits and a frame well
+under 2 KB of flash. The second frame has the bars in reverse order so
+that a viewer shows the frames changing. Every frame is decoded again
+and compared with the bars before the header is written.
+
+    tools/test_pattern_jpeg.py            regenerate test_pattern_jpeg.h
+    tools/test_pattern_jpeg.py --check    fail if test_pattern_jpeg.h is stale
+"""
+
+import argparse
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+JPEG_H = os.path.join(ROOT, "test_pattern_jpeg.h")
+
+WIDTH = 320
+HEIGHT = 240
+BLOCK = 8
+
+# 100% colour bars, left to right
+BARS = [
+    (255, 255, 255),    # white
+    (255, 255, 0),      # yellow
+    (0, 255, 255),      # cyan
+    (0, 255, 0),        # green
+    (255, 0, 255),      # magenta
+    (255, 0, 0),        # red
+    (0, 0, 255),        # blue
+    (0, 0, 0),          # black
+]
+
+# DC quantiser 8: a flat block of value v has the coefficient v - 128
+QUANT_DC = 8
+
+# DC: category 0 (no change from the block to the left) takes one bit,
+# categories 1 to 11 five bits. AC: EOB only, one bit.
+DC_BITS = [1, 0, 0, 0, 11] + [0] * 11
+DC_VALS = list(range(12))
+AC_BITS = [1] + [0] * 15
+AC_VALS = [0x00]
+
+
+class JpegError(Exception):
+    pass
+
+
+def ycbcr(rgb):
+    r, g, b = rgb
+    y = 0.299 * r + 0.587 * g + 0.114 * b
+    cb = 128 - 0.168736 * r - 0.331264 * g + 0.5 * b
+    cr = 128 + 0.5 * r - 0.418688 * g - 0.081312 * b
+    return tuple(min(255, max(0, int(round(c)))) for c in (y, cb, cr))
+
+
+def bar_blocks(bars):
+    """Component values of every block, [component][row][col]."""
+    cols = WIDTH // BLOCK
+    colours = [ycbcr(bars[col * len(bars) // cols]) for col in range(cols)]
+    return [[[colours[col][c] for col in range(cols)] for _ in range(HEIGHT // BLOCK)]
+            for c in range(3)]
+
+
+def huffman_codes(bits, vals):
+    """Canonical codes, {symbol: (code, length)}."""
+    codes = {}
+    code = 0
+    k = 0
+    for length in range(1, 17):
+        for _ in range(bits[length - 1]):
+            codes[vals[k]] = (code, length)
+            code += 1
+            k += 1
+        if code >= (1 << length):
+            raise JpegError("Huffman table overflows at length %d" % length)
+        code <<= 1
+    return codes
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.n = 0
+
+    def put(self, value, length):
+        for i in range(length - 1, -1, -1):
+            self.acc = (self.acc << 1) | ((value >> i) & 1)
+            self.n += 1
+            if self.n == 8:
+                self.out.append(self.acc)
+                if self.acc == 0xFF:
+                    self.out.append(0x00)
+                self.acc = 0
+                self.n = 0
+
+    def flush(self):
+        while self.n:
+            self.put(1, 1)
+        return bytes(self.out)
+
+
+def category(v):
+    return abs(v).bit_length()
+
+
+def segment(marker, body):
+    return bytes([0xFF, marker, (len(body) + 2) >> 8, (len(body) + 2) & 0xFF]) + bytes(body)
+
+
+def encode(blocks):
+    dc = huffman_codes(DC_BITS, DC_VALS)
+    ac = huffman_codes(AC_BITS, AC_VALS)
+    bits = BitWriter()
+    pred = [0, 0, 0]
+
+    for row in range(HEIGHT // BLOCK):
+        for col in range(WIDTH // BLOCK):
+            for c in range(3):
+                coef = blocks[c][row][col] - 128
+                diff = coef - pred[c]
+                pred[c] = coef
+                cat = category(diff)
+                bits.put(*dc[cat])
+                if cat:
+                    bits.put(diff if diff > 0 else diff + (1 << cat) - 1, cat)
+                bits.put(*ac[0x00])
+
+    quant = [QUANT_DC] + [1] * 63
+    out = bytes([0xFF, 0xD8])
+    out += segment(0xE0, b"JFIF\0" + bytes([1, 1, 0, 0, 1, 0, 1, 0, 0]))
+    out += segment(0xDB, bytes([0x00] + quant))
+    out += segment(0xC0, bytes([8, HEIGHT >> 8, HEIGHT & 0xFF, WIDTH >> 8, WIDTH & 0xFF, 3,
+                                1, 0x11, 0, 2, 0x11, 0, 3, 0x11, 0]))
+    out += segment(0xC4, bytes([0x00] + DC_BITS + DC_VALS + [0x10] + AC_BITS + AC_VALS))
+    out += segment(0xDA, bytes([3, 1, 0x00, 2, 0x00, 3, 0x00, 0, 63, 0]))
+    out += bits.flush()
+    out += bytes([0xFF, 0xD9])
+    return out
+
+
+def decode(jpeg):
+    """DC-only baseline decoder for what encode() writes, returns the blocks."""
+    if jpeg[:2] != b"\xff\xd8" or jpeg[-2:] != b"\xff\xd9":
+        raise JpegError("no SOI/EOI")
+    pos = 2
+    tables = {}
+    quant = None
+    size = None
+    while True:
+        if jpeg[pos] != 0xFF:
+            raise JpegError("no marker at %d" % pos)
+        marker = jpeg[pos + 1]
+        length = (jpeg[pos + 2] << 8) | jpeg[pos + 3]
+        body = jpeg[pos + 4:pos + 2 + length]
+        pos += 2 + length
+        if marker == 0xDB:
+            quant = body[1]
+        elif marker == 0xC0:
+            size = ((body[3] << 8) | body[4], (body[1] << 8) | body[2])
+        elif marker == 0xC4:
+            k = 0
+            while k < len(body):
+                bits = list(body[k + 1:k + 17])
+                vals = list(body[k + 17:k + 17 + sum(bits)])
+                codes = huffman_codes(bits, vals)
+                tables[body[k] >> 4] = {(code, n): sym for sym, (code, n) in codes.items()}
+                k += 17 + sum(bits)
+        elif marker == 0xDA:
+            break
+    if size != (WIDTH, HEIGHT):
+        raise JpegError("SOF says %dx%d" % size)
+
+    data = bytearray()
+    while pos < len(jpeg) - 2:
+        data.append(jpeg[pos])
+        if jpeg[pos] == 0xFF:
+            if jpeg[pos + 1] != 0x00:
+                raise JpegError("marker inside the entropy data")
+            pos += 1
+        pos += 1
+    bitpos = [0]
+
+    def bit():
+        b = (data[bitpos[0] >> 3] >> (7 - (bitpos[0] & 7))) & 1
+        bitpos[0] += 1
+        return b
+
+    def symbol(table):
+        code = 0
+        for n in range(1, 17):
+            code = (code << 1) | bit()
+            if (code, n) in table:
+                return table[(code, n)]
+        raise JpegError("bad Huffman code")
+
+    blocks = [[[0] * (WIDTH // BLOCK) for _ in range(HEIGHT // BLOCK)] for _ in range(3)]
+    pred = [0, 0, 0]
+    for row in range(HEIGHT // BLOCK):
+        for col in range(WIDTH // BLOCK):
+            for c in range(3):
+                cat = symbol(tables[0])
+                diff = 0
+                for _ in range(cat):
+                    diff = (diff << 1) | bit()
+                if cat and diff < (1 << (cat - 1)):
+                    diff -= (1 << cat) - 1
+                pred[c] += diff
+                if symbol(tables[1]) != 0x00:
+                    raise JpegError("AC coefficients in a flat block")
+                blocks[c][row][col] = pred[c] * quant // 8 + 128
+    return blocks
+
+
+def fmt_array(name, data):
+    lines = ["static const uint8 %s[%d] = {" % (name, len(data))]
+    for i in range(0, len(data), 12):
+        lines.append("    " + " ".join("0x%02x," % b for b in data[i:i + 12]))
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def generate():
+    frames = []
+    for bars in (BARS, BARS[::-1]):
+        blocks = bar_blocks(bars)
+        jpeg = encode(blocks)
+        if decode(jpeg) != blocks:
+            raise JpegError("frame does not decode to the bars")
+        frames.append(jpeg)
+
+    out = [
+        "/*",
+        " * Canned JPEG frames of the test pattern source",
+        " *",
+        " * generated by tools/test_pattern_jpeg.py, do not edit.",
+        " * %dx%d colour bars, the second frame mirrored." % (WIDTH, HEIGHT),
+        " */",
+        "",
+        "#ifndef _TEST_PATTERN_JPEG_H_",
+        "#define _TEST_PATTERN_JPEG_H_",
+        "",
+        "#include <libmaple/libmaple_types.h>",
+        "",
+        "#define TEST_PATTERN_JPEG_FRAMES %d" % len(frames),
+        "",
+    ]
+    for i, jpeg in enumerate(frames):
+        out.append(fmt_array("TEST_PATTERN_JPEG_FRAME_%d" % i, jpeg))
+        out.append("")
+    out.append("static const uint8 * const TEST_PATTERN_JPEG_FRAME[TEST_PATTERN_JPEG_FRAMES] = {")
+    out.append("    %s," % ", ".join("TEST_PATTERN_JPEG_FRAME_%d" % i for i in range(len(frames))))
+    out.append("};")
+    out.append("")
+    out.append("static const uint16 TEST_PATTERN_JPEG_FRAME_LEN[TEST_PATTERN_JPEG_FRAMES] = {")
+    out.append("    %s," % ", ".join("%d" % len(jpeg) for jpeg in frames))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--check", action="store_true",
+                        help="verify test_pattern_jpeg.h is up to date instead of writing it")
+    args = parser.parse_args()
+
+    try:
+        header = generate()
+    except JpegError as e:
+        sys.exit("test_pattern_jpeg: %s" % e)
+
+    if args.check:
+        try:
+            with open(JPEG_H) as f:
+                current = f.read()
+        except IOError:
+            current = None
+        if current != header:
+            sys.exit("test_pattern_jpeg: test_pattern_jpeg.h is out of date")
+        return
+
+    with open(JPEG_H, "w") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Event trace of trace.h over the vendor bulk interface, as a Perfetto trace.
+
+    tools/trace_dump.py dump trace.bin              drain the ring into a file
+    tools/trace_dump.py convert trace.bin out.json  Chrome JSON for ui.perfetto.dev
+    tools/trace_dump.py mask setup fifo frame       choose the classes recorded
+
+dump and mask need pyusb and access to the device. The raw file holds the
+8-byte events as the device sent them, convert runs without the device.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import reg_script  # noqa: E402
+
+OP_TRACE, OP_TRACE_MASK = 0x03, 0x04
+ENTRY = struct.Struct("<IBBH")
+EVENTS_PER_OP = 60 // ENTRY.size
+CYCLES_PER_US = 72.0
+
+CLASSES = {"ep": 0x01, "setup": 0x02, "fifo": 0x04, "frame": 0x08}
+
+EP_IN, EP_OUT, RING_EMPTY = 0x10, 0x11, 0x12
+SETUP, SETUP_NODATA = 0x20, 0x21
+CAPTURE, CAPTURE_DONE, DRAIN_BEGIN, DRAIN_END, SCAN, CACHE, TRIGGER = \
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46
+FRAME_START, FRAME_END, DROP, FAULT, SPI_FALLBACK = 0x80, 0x81, 0x82, 0x83, 0x84
+LOST = 0xF0
+
+DROP_REASON = {1: "unchanged", 2: "recover"}
+CACHE_DONE = 2
+TRIGGER_SOURCE = {1: "GPIO", 2: "SOF"}
+REQUEST = {0x01: "SET_CUR", 0x81: "GET_CUR", 0x82: "GET_MIN", 0x83: "GET_MAX",
+           0x84: "GET_RES", 0x85: "GET_LEN", 0x86: "GET_INFO", 0x87: "GET_DEF"}
+
+# tracks, one per context on the device
+PID = 1
+TID_USB, TID_STREAM, TID_FRAMES = 1, 2, 3
+TRACKS = {TID_USB: "USB interrupt", TID_STREAM: "stream task", TID_FRAMES: "frames"}
+
+
+def parse(raw):
+    """(us, id, a, b) of every event, the 32-bit cycle count unwrapped."""
+    if len(raw) % ENTRY.size:
+        sys.exit("trace_dump: %d bytes is not a whole number of events" % len(raw))
+    events = []
+    last = None
+    base = 0
+    for cycles, eid, a, b in ENTRY.iter_unpack(raw):
+        if last is not None:
+            # events arrive close to cycle order, the counter wraps every
+            # 59 s; a step back is either a wrap or a span begin stamped
+            # before the events recorded while it ran
+            delta = (cycles - last) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            base += delta
+        else:
+            base = cycles
+        last = cycles
+        events.append((base / CYCLES_PER_US, eid, a, b))
+    return events
+
+
+def convert(events):
+    out = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "arducam_uvc"}}]
+    for tid, name in TRACKS.items():
+        out.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name",
+                    "args": {"name": name}})
+    if not events:
+        return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+    t0 = min(e[0] for e in events)
+    capture = None
+    frame = None
+
+    def ev(ph, tid, name, ts, **kw):
+        e = {"ph": ph, "pid": PID, "tid": tid, "name": name, "ts": round(ts - t0, 3)}
+        if ph == "i":
+            e["s"] = "t"
+        e.update(kw)
+        out.append(e)
+
+    for ts, eid, a, b in sorted(events, key=lambda e: e[0]):
+        if eid == EP_IN:
+            ev("i", TID_USB, "EP%d IN" % a, ts)
+        elif eid == EP_OUT:
+            ev("i", TID_USB, "EP%d OUT" % a, ts)
+        elif eid == RING_EMPTY:
+            ev("i", TID_USB, "ring empty", ts)
+        elif eid in (SETUP, SETUP_NODATA):
+            ev("i", TID_USB, REQUEST.get(a, "request 0x%02x" % a), ts,
+               args={"entity": b >> 8, "selector": b & 0xFF, "data": eid == SETUP})
+        elif eid == CAPTURE:
+            capture = (ts, a, b)
+        elif eid == CAPTURE_DONE:
+            length = (a << 16) | b
+            if capture is not None:
+                ev("X", TID_STREAM, "capture", capture[0], dur=round(ts - capture[0], 3),
+                   args={"frames": capture[1], "pattern": capture[2], "length": length})
+                capture = None
+            ev("C", TID_STREAM, "FIFO length", ts, args={"bytes": length})
+        elif eid == DRAIN_BEGIN:
+            ev("B", TID_STREAM, "drain", ts)
+        elif eid == DRAIN_END:
+            ev("E", TID_STREAM, "drain", ts, args={"packets": b})
+        elif eid == SCAN:
+            ev("i", TID_STREAM, "scan", ts, args={"change": a})
+        elif eid == CACHE:
+            capture = (ts, a, 0)
+            ev("i", TID_STREAM, "cached capture", ts,
+               args={"frames": a, "complete": b == CACHE_DONE})
+        elif eid == TRIGGER:
+            ev("X", TID_STREAM, "trigger " + TRIGGER_SOURCE.get(a, str(a)), ts - b,
+               dur=b, args={"delay_us": b})
+        elif eid == FRAME_START:
+            if frame is not None:
+                ev("X", TID_FRAMES, "frame (cut)", frame[0], dur=round(ts - frame[0], 3),
+                   args={"fid": frame[1]})
+            frame = (ts, a)
+        elif eid == FRAME_END:
+            if frame is not None:
+                ev("X", TID_FRAMES, "frame", frame[0], dur=round(ts - frame[0], 3),
+                   args={"fid": frame[1]})
+                frame = None
+        elif eid == DROP:
+            ev("i", TID_FRAMES, "drop " + DROP_REASON.get(a, str(a)), ts)
+        elif eid == FAULT:
+            ev("i", TID_FRAMES, "fault", ts, args={"error": a})
+        elif eid == SPI_FALLBACK:
+            ev("i", TID_FRAMES, "SPI clock down", ts, args={"step": a})
+        elif eid == LOST:
+            ev("i", TID_USB, "lost %d events" % b, ts, s="g")
+        else:
+            ev("i", TID_USB, "event 0x%02x" % eid, ts, args={"a": a, "b": b})
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def cmd_dump(args):
+    dev = reg_script.Device()
+    raw = bytearray()
+    while True:
+        status, executed, values = dev.run([(OP_TRACE, 0, 0, 0)])
+        reg_script.check(status, executed, 1)
+        raw += bytes(values)
+        if len(values) < EVENTS_PER_OP * ENTRY.size:
+            break
+    with open(args.out, "wb") as f:
+        f.write(raw)
+    print("%d events" % (len(raw) // ENTRY.size))
+
+
+def cmd_convert(args):
+    with open(args.raw, "rb") as f:
+        events = parse(f.read())
+    with open(args.out, "w") as f:
+        json.dump(convert(events), f)
+    span = max(e[0] for e in events) - min(e[0] for e in events) if events else 0.0
+    print("%d events, %.1f ms" % (len(events), span / 1e3))
+
+
+def cmd_mask(args):
+    mask = 0
+    for name in args.classes:
+        if name not in CLASSES and name != "none":
+            sys.exit("trace_dump: no class %s, one of %s" % (name, " ".join(CLASSES)))
+        mask |= CLASSES.get(name, 0)
+    status, executed, _ = reg_script.Device().run([(OP_TRACE_MASK, 0, mask, 0)])
+    reg_script.check(status, executed, 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="cmd")
+    p = sub.add_parser("dump", help="drain the trace ring into a raw file")
+    p.add_argument("out")
+    p = sub.add_parser("convert", help="write Chrome JSON trace events")
+    p.add_argument("raw")
+    p.add_argument("out")
+    p = sub.add_parser("mask", help="choose the event classes recorded")
+    p.add_argument("classes", nargs="+", help="ep setup fifo frame, or none")
+    args = parser.parse_args()
+
+    if args.cmd == "dump":
+        cmd_dump(args)
+    elif args.cmd == "convert":
+        cmd_convert(args)
+    elif args.cmd == "mask":
+        cmd_mask(args)
+    else:
+        parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+/*
+ * Host checks for the UVCCamera buffer API (uvc_camera.h)
+ *
+ *   c++ -std=c++11 -O2 -Itools/host -I. -o uvc_camera_sim tools/uvc_camera_sim.cpp
+ *   ./uvc_camera_sim
+ *
+ * A simulated endpoint stands in for uvc_stream.c: a ring of packet
+ * slots with the same one-slot-lent-out rule, drained by a fake host
+ * that rebuilds frames from the payloads and checks FID/EOF. Exits
+ * non-zero when a check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+
+#include "uvc_camera.h"
+#include "check.h"
+
+#define RING_SIZE       8
+#define PACKET_SIZE     64
+#define HEADER_SIZE     2
+#define EOF_BIT         0x02
+#define FID_BIT         0x01
+
+struct SimPacket {
+    uint8 data[PACKET_SIZE];
+    uint16 len;
+};
+
+struct SimEndpoint {
+    typedef SimPacket Slot;
+
+    SimPacket ring[RING_SIZE];
+    uint32 head, tail;
+    bool lent, running;
+    uint8 fid;
+    uint32 done;
+
+    /* what the fake host received */
+    uint8 frame[4096];
+    uint32 frame_len, frames, fid_errors;
+    int last_fid;
+
+    SimEndpoint(void) : head(0), tail(0), lent(false), running(true), fid(0), done(0),
+                        frame_len(0), frames(0), fid_errors(0), last_fid(-1) {}
+
+    Slot* acquire(void) {
+        if (!running || lent || head - tail == RING_SIZE) {
+            return 0;
+        }
+        lent = true;
+        return &ring[head % RING_SIZE];
+    }
+
+    void release(Slot *slot) {
+        if (lent && slot == &ring[head % RING_SIZE]) {
+            lent = false;
+        }
+    }
+
+    bool submit(Slot *slot, uint16 len, bool eof) {
+        if (!lent || slot != &ring[head % RING_SIZE]) {
+            return false;
+        }
+        lent = false;
+        if (!running) {
+            return false;
+        }
+        slot->data[0] = HEADER_SIZE;
+        slot->data[1] = fid | (eof ? EOF_BIT : 0);
+        slot->len = HEADER_SIZE + len;
+        head++;
+        if (eof) {
+            fid ^= FID_BIT;
+        }
+        return true;
+    }
+
+    uint32 completedFrames(void) {
+        return done;
+    }
+
+    static uint8* payload(Slot *slot) {
+        return slot->data + HEADER_SIZE;
+    }
+
+    static uint16 capacity(void) {
+        return PACKET_SIZE - HEADER_SIZE;
+    }
+
+    /* the host reads up to n packets */
+    void hostRead(uint32 n) {
+        while (n-- && tail != head) {
+            SimPacket *pkt = &ring[tail % RING_SIZE];
+            uint8 bits = pkt->data[1];
+
+            if (last_fid >= 0 && frame_len == 0 && (bits & FID_BIT) == last_fid) {
+                fid_errors++;
+            }
+            memcpy(frame + frame_len, pkt->data + HEADER_SIZE, pkt->len - HEADER_SIZE);
+            frame_len += pkt->len - HEADER_SIZE;
+            tail++;
+            if (bits & EOF_BIT) {
+                last_fid = bits & FID_BIT;
+                frames++;
+                done++;
+                frame_len = 0;
+            }
+        }
+    }
+};
+
+typedef BasicUVCCamera<SimEndpoint> SimCamera;
+
+static uint32 completed[16];
+static uint32 num_completed;
+
+static void frameComplete(uint32 frame, void *arg) {
+    (void)arg;
+    if (num_completed < 16) {
+        completed[num_completed] = frame;
+    }
+    num_completed++;
+}
+
+/* queue a frame of len bytes of value, one packet at a time */
+static uint32 sendFrame(SimCamera &cam, uint16 len, uint8 value) {
+    while (1) {
+        SimCamera::Buffer buf = cam.acquireBuffer();
+        uint16 n;
+
+        if (!buf) {
+            cam.endpoint().hostRead(1);
+            continue;
+        }
+        n = (len > buf.capacity()) ? buf.capacity() : len;
+        memset(buf.data(), value, n);
+        buf.setLength(n);
+        len -= n;
+        if (len == 0) {
+            return cam.submitFrame(std::move(buf));
+        }
+        cam.submit(std::move(buf));
+    }
+}
+
+int main(void) {
+    SimCamera cam;
+    SimEndpoint &ep = cam.endpoint();
+
+    cam.onFrameComplete(frameComplete, 0);
+
+    /* a buffer is the ring slot itself, written in place */
+    {
+        SimCamera::Buffer buf = cam.acquireBuffer();
+        CHECK(buf);
+        CHECK(buf.data() == ep.ring[0].data + HEADER_SIZE);
+        CHECK(buf.capacity() == PACKET_SIZE - HEADER_SIZE);
+
+        /* only one slot is lent out at a time */
+        CHECK(!cam.acquireBuffer());
+
+        /* moving hands the slot over and empties the source */
+        SimCamera::Buffer other(std::move(buf));
+        CHECK(!buf);
+        CHECK(buf.data() == 0);
+        CHECK(other);
+
+        buf = std::move(other);
+        CHECK(buf && !other);
+
+        buf.setLength(1000);
+        CHECK(buf.length() == buf.capacity());
+    }
+    /* dropped unsent, the slot is back */
+    CHECK(!ep.lent);
+    CHECK(ep.head == 0);
+
+    /* a moved-from buffer cannot be submitted */
+    {
+        SimCamera::Buffer buf = cam.acquireBuffer();
+        SimCamera::Buffer taken = std::move(buf);
+        CHECK(!cam.submit(std::move(buf)));
+        taken.reset();
+        CHECK(!ep.lent);
+    }
+
+    /* a frame larger than the ring waits for the host between packets */
+    CHECK(sendFrame(cam, 1000, 0xA5) == 1);
+    CHECK(cam.framesInFlight() == 1);
+    cam.poll();
+    CHECK(num_completed == 0);
+    ep.hostRead(RING_SIZE);
+    CHECK(ep.frames == 1);
+    cam.poll();
+    CHECK(num_completed == 1 && completed[0] == 1);
+    CHECK(cam.framesInFlight() == 0);
+
+    /* several frames queued before the host reads any */
+    CHECK(sendFrame(cam, 10, 1) == 2);
+    CHECK(sendFrame(cam, 10, 2) == 3);
+    CHECK(sendFrame(cam, 10, 3) == 4);
+    ep.hostRead(RING_SIZE);
+    cam.poll();
+    CHECK(num_completed == 4 && completed[1] == 2 && completed[3] == 4);
+    CHECK(ep.frames == 4);
+    CHECK(ep.fid_errors == 0);
+
+    /* frames finished by another source are not reported */
+    ep.done += 3;
+    cam.poll();
+    CHECK(num_completed == 4);
+
+    /* no buffers while the stream is stopped, a held one is refused */
+    {
+        SimCamera::Buffer buf = cam.acquireBuffer();
+        ep.running = false;
+        CHECK(!cam.acquireBuffer());
+        CHECK(cam.submitFrame(std::move(buf)) == 0);
+        CHECK(!ep.lent);
+        ep.running = true;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
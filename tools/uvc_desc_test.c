@@ -0,0 +1,71 @@
+/*
+ * Layout checks of the video streaming descriptors (usb_uvc_desc.h)
+ *
+ *   cc -O2 -Itools/host -I. -o uvc_desc_test tools/uvc_desc_test.c
+ *   ./uvc_desc_test
+ *
+ * Including usb_uvc_desc.h compiles its size checks on the host, so a
+ * descriptor added without its size in USB_UVC_VS_TOTAL_SIZE, or a
+ * format without its bmaControls entry, fails this build as it fails
+ * the device build. The run then walks the descriptors in the order the
+ * host parses them and checks each one against its UVC_DT_* size, to
+ * name the one that is off, and counts one format descriptor per
+ * USB_UVC_FORMAT_*. Exits non-zero when a check fails.
+ */
+
+#include <stdio.h>
+
+#include "usb_uvc_desc.h"
+#include "check.h"
+
+typedef struct desc_case {
+    const char *name;
+    size_t offset;
+    size_t size;                /* of the structure */
+    size_t length;              /* bLength the class specification gives */
+    int format;                 /* a format descriptor */
+} desc_case;
+
+#define DESC(member, length, format)                                    \
+    {#member, offsetof(usb_uvc_vs_descriptors, member),                 \
+     sizeof(((usb_uvc_vs_descriptors*)0)->member), length, format}
+
+static const desc_case descs[] = {
+    DESC(UVC_VS_Interface_Header, UVC_DT_INPUT_HEADER_SIZE(USB_UVC_FORMAT_COUNT, 1), 0),
+    DESC(UVC_YUY2_format, UVC_DT_FORMAT_UNCOMPRESSED_SIZE, 1),
+    DESC(UVC_YUY2_320_240_Frame, UVC_DT_FRAME_UNCOMPRESSED_SIZE(1), 0),
+    DESC(UVC_MJPEG_Format, UVC_DT_FORMAT_MJPEG_SIZE, 1),
+    DESC(UVC_MJPEG_1600_1200_Frame, UVC_DT_FRAME_MJPEG_SIZE(1), 0),
+    DESC(UVC_Color_Matching, UVC_DT_COLOR_MATCHING_SIZE, 0),
+    DESC(UVC_Rice_Format, UVC_DT_FORMAT_FRAME_BASED_SIZE, 1),
+    DESC(UVC_Rice_320_240_Frame, UVC_DT_FRAME_FRAME_BASED_SIZE(1), 0),
+    DESC(UVC_M420_Format, UVC_DT_FORMAT_UNCOMPRESSED_SIZE, 1),
+    DESC(UVC_M420_320_240_Frame, UVC_DT_FRAME_UNCOMPRESSED_SIZE(1), 0),
+    DESC(UVC_Bayer_Format, UVC_DT_FORMAT_UNCOMPRESSED_SIZE, 1),
+    DESC(UVC_Bayer_320_240_Frame, UVC_DT_FRAME_UNCOMPRESSED_SIZE(1), 0),
+};
+
+int main(void) {
+    size_t at = 0;
+    int formats = 0;
+    unsigned i;
+
+    for (i = 0; i < sizeof(descs) / sizeof(descs[0]); i++) {
+        const desc_case *d = &descs[i];
+
+        printf("  %-26s at %3u, %2u bytes\n", d->name, (unsigned)d->offset,
+               (unsigned)d->size);
+        CHECK(d->offset == at);
+        CHECK(d->size == d->length);
+        at += d->length;
+        formats += d->format;
+    }
+    CHECK(at == USB_UVC_VS_TOTAL_SIZE);
+    CHECK(at == sizeof(usb_uvc_vs_descriptors));
+    CHECK(formats == USB_UVC_FORMAT_COUNT);
+    CHECK(sizeof(((uvc_input_header_descriptor*)0)->bmaControls) == USB_UVC_FORMAT_COUNT);
+    printf("  wTotalLength %u, %d formats\n", (unsigned)at, formats);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Capture-to-host latency from the UVC payload timestamps
+ *
+ *   cc -O2 -o uvc_latency tools/uvc_latency.c
+ *   sudo modprobe -r uvcvideo && sudo modprobe uvcvideo hwtimestamps=1
+ *   ./uvc_latency [/dev/videoN] [frames]
+ *
+ * With hwtimestamps=1 uvcvideo turns each frame's PTS and SCR into a
+ * CLOCK_MONOTONIC buffer timestamp for the moment the capture was
+ * triggered on the device. The difference to the dequeue time is the
+ * latency through sensor, FIFO, USB and driver. Without hwtimestamps the
+ * driver stamps the first packet instead and only the tail of the
+ * transfer is measured. Prints a histogram and
+ * percentiles; use the format the device is already set to (v4l2-ctl
+ * --set-fmt-video) to measure YUY2 or MJPEG.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#define NUM_BUFFERS     4
+#define HIST_BUCKET_MS  10
+#define HIST_BUCKETS    50
+
+static int xioctl(int fd, unsigned long req, void *arg) {
+    int ret;
+
+    do {
+        ret = ioctl(fd, req, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+static int cmpDouble(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p) {
+    int i = (int)(p / 100.0 * (n - 1) + 0.5);
+
+    return sorted[i];
+}
+
+int main(int argc, char **argv) {
+    const char *dev = (argc > 1) ? argv[1] : "/dev/video0";
+    int frames = (argc > 2) ? atoi(argv[2]) : 200;
+    struct v4l2_requestbuffers req;
+    struct v4l2_buffer buf;
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    unsigned hist[HIST_BUCKETS + 1] = {0};
+    double *lat;
+    int fd, i, n = 0;
+
+    fd = open(dev, O_RDWR);
+    if (fd < 0) {
+        perror(dev);
+        return 1;
+    }
+    lat = calloc(frames, sizeof(*lat));
+
+    memset(&req, 0, sizeof(req));
+    req.count = NUM_BUFFERS;
+    req.type = type;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
+        perror("VIDIOC_REQBUFS");
+        return 1;
+    }
+    for (i = 0; i < (int)req.count; i++) {
+        memset(&buf, 0, sizeof(buf));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0 ||
+            mmap(NULL, buf.length, PROT_READ, MAP_SHARED, fd, buf.m.offset) == MAP_FAILED ||
+            xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+            perror("buffer setup");
+            return 1;
+        }
+    }
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        perror("VIDIOC_STREAMON");
+        return 1;
+    }
+
+    while (n < frames) {
+        struct timespec now;
+        double ms;
+
+        memset(&buf, 0, sizeof(buf));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
+            perror("VIDIOC_DQBUF");
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (!(buf.flags & V4L2_BUF_FLAG_ERROR) && buf.bytesused > 0) {
+            ms = (now.tv_sec - buf.timestamp.tv_sec) * 1e3 +
+                (now.tv_nsec / 1e6 - buf.timestamp.tv_usec / 1e3);
+            lat[n++] = ms;
+            i = (int)(ms / HIST_BUCKET_MS);
+            hist[(i < 0) ? 0 : (i > HIST_BUCKETS ? HIST_BUCKETS : i)]++;
+        }
+        xioctl(fd, VIDIOC_QBUF, &buf);
+    }
+    xioctl(fd, VIDIOC_STREAMOFF, &type);
+    if (n == 0) {
+        return 1;
+    }
+
+    qsort(lat, n, sizeof(*lat), cmpDouble);
+    printf("%d frames, latency ms: min %.1f p50 %.1f p90 %.1f p99 %.1f max %.1f\n", n,
+           lat[0], percentile(lat, n, 50), percentile(lat, n, 90),
+           percentile(lat, n, 99), lat[n - 1]);
+    for (i = 0; i <= HIST_BUCKETS; i++) {
+        if (hist[i] == 0) {
+            continue;
+        }
+        printf("%s%4d ms %6u ", i == HIST_BUCKETS ? ">=" : "  ", i * HIST_BUCKET_MS, hist[i]);
+        for (unsigned j = 0; j < hist[i] * 60 / n; j++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Host benchmark for the payload framing policies (uvc_payload.h)
+ *
+ *   cc -O2 -Itools/host -I. -o uvc_payload_bench tools/uvc_payload_bench.c
+ *   ./uvc_payload_bench [frames]
+ *
+ * Cuts a 320x240 YUY2 frame and a synthetic JPEG with FIFO padding into
+ * 64-byte packets three ways: with the loops specialised per framing,
+ * as uvc_stream.c builds them, and with one loop that takes the framing
+ * and the read function at run time. Reports the time per packet and
+ * checks that all loops produce the same packets. The host numbers only
+ * show the difference between the loops; on the device the `s` serial
+ * command prints drain_cycles, the cost of one specialised packet with
+ * the SPI read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "uvc_payload.h"
+
+#define PACKET_SIZE     64
+#define HEADER_SIZE     2
+#define YUY2_LEN        (320 * 240 * 2)
+#define JPEG_LEN        24000
+#define JPEG_PAD        4096
+
+static uint8 yuy2[YUY2_LEN];
+static uint8 jpeg[JPEG_LEN + JPEG_PAD];
+static const uint8 *src;
+static uint8 packet[PACKET_SIZE];
+
+static void srcRead(uint8 *buf, uint16 len) {
+    memcpy(buf, src, len);
+    src += len;
+}
+
+static void makeFrames(void) {
+    uint32 i;
+
+    for (i = 0; i < YUY2_LEN; i++) {
+        yuy2[i] = (i & 1) ? 0x80 : (uint8)(64 + (i >> 10));
+    }
+    /* entropy coded data stuffs every 0xFF with a 0x00 */
+    jpeg[0] = 0xFF;
+    jpeg[1] = 0xD8;
+    for (i = 2; i < JPEG_LEN - 2; i++) {
+        jpeg[i] = (jpeg[i - 1] == 0xFF) ? 0x00 : (uint8)rand();
+    }
+    if (jpeg[JPEG_LEN - 3] == 0xFF) {
+        jpeg[JPEG_LEN - 3] = 0x12;
+    }
+    jpeg[JPEG_LEN - 2] = 0xFF;
+    jpeg[JPEG_LEN - 1] = 0xD9;
+    for (i = JPEG_LEN; i < JPEG_LEN + JPEG_PAD; i++) {
+        jpeg[i] = 0x55;
+    }
+}
+
+/* a sum over the packets, to compare the loops */
+static uint32 checksum;
+static uint32 bytes;
+
+static inline void account(uint16 len) {
+    uint16 i;
+
+    if (len == 0) {
+        return;
+    }
+    for (i = 0; i < len; i += 8) {
+        checksum = checksum * 31 + packet[i] + packet[1];
+    }
+    bytes += len - HEADER_SIZE;
+}
+
+static __attribute__((noinline)) uint32 frameFixed(uint32 len) {
+    uvc_payload p;
+    uint32 packets = 0;
+
+    uvc_payload_begin(&p, len, len, 1);
+    while (!uvc_payload_done(&p)) {
+        account(uvc_payload_fill(&p, packet, PACKET_SIZE, HEADER_SIZE,
+                                 UVC_STREAM_EOH, UVC_FRAMING_FIXED, srcRead));
+        packets++;
+    }
+    return packets;
+}
+
+static __attribute__((noinline)) uint32 frameEoi(uint32 len) {
+    uvc_payload p;
+    uint32 packets = 0;
+
+    uvc_payload_begin(&p, len, 0, 1);
+    while (!uvc_payload_done(&p)) {
+        account(uvc_payload_fill(&p, packet, PACKET_SIZE, HEADER_SIZE,
+                                 UVC_STREAM_EOH, UVC_FRAMING_EOI, srcRead));
+        packets++;
+    }
+    return packets;
+}
+
+/* the framing and the read function are only known at run time */
+static volatile uint8 generic_framing;
+static uvc_payload_read volatile generic_read = srcRead;
+
+static __attribute__((noinline)) uint32 frameGeneric(uint32 len) {
+    uvc_payload p;
+    uint32 packets = 0;
+    uint8 framing = generic_framing;
+    uvc_payload_read read = generic_read;
+
+    uvc_payload_begin(&p, len, (framing == UVC_FRAMING_FIXED) ? len : 0, 1);
+    while (!uvc_payload_done(&p)) {
+        account(uvc_payload_fill(&p, packet, PACKET_SIZE, HEADER_SIZE,
+                                 UVC_STREAM_EOH, framing, read));
+        packets++;
+    }
+    return packets;
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct result {
+    double ns_per_packet;
+    uint32 packets;
+    uint32 bytes;
+    uint32 checksum;
+} result;
+
+static result run(uint32 (*frame)(uint32), const uint8 *data, uint32 len, int frames) {
+    result r;
+    double t;
+    int i;
+
+    checksum = 0;
+    bytes = 0;
+    r.packets = 0;
+    t = now();
+    for (i = 0; i < frames; i++) {
+        src = data;
+        r.packets += frame(len);
+    }
+    t = now() - t;
+    r.ns_per_packet = t * 1e9 / r.packets;
+    r.packets /= frames;
+    r.bytes = bytes / frames;
+    r.checksum = checksum;
+    return r;
+}
+
+static int failures;
+
+static void report(const char *name, result spec, result gen) {
+    printf("%-6s %5u packets %6u bytes  specialised %6.1f ns/packet  generic %6.1f ns/packet\n",
+           name, spec.packets, spec.bytes, spec.ns_per_packet, gen.ns_per_packet);
+    if (spec.packets != gen.packets || spec.checksum != gen.checksum) {
+        printf("  FAIL: the loops disagree\n");
+        failures++;
+    }
+}
+
+int main(int argc, char **argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 200;
+    result spec, gen;
+
+    if (frames <= 0) {
+        frames = 1;
+    }
+    makeFrames();
+
+    generic_framing = UVC_FRAMING_FIXED;
+    spec = run(frameFixed, yuy2, YUY2_LEN, frames);
+    gen = run(frameGeneric, yuy2, YUY2_LEN, frames);
+    report("YUY2", spec, gen);
+    if (spec.bytes != YUY2_LEN) {
+        printf("  FAIL: %u bytes sent\n", spec.bytes);
+        failures++;
+    }
+
+    generic_framing = UVC_FRAMING_EOI;
+    spec = run(frameEoi, jpeg, JPEG_LEN + JPEG_PAD, frames);
+    gen = run(frameGeneric, jpeg, JPEG_LEN + JPEG_PAD, frames);
+    report("MJPEG", spec, gen);
+    /* the padding after the EOI is not sent */
+    if (spec.bytes != JPEG_LEN) {
+        printf("  FAIL: %u bytes sent, the frame has %u\n", spec.bytes, JPEG_LEN);
+        failures++;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
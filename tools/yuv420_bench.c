@@ -0,0 +1,303 @@
+/*
+ * Host benchmark and reference check of the 4:2:0 line pair kernel
+ *
+ *   cc -O2 -Itools/host -I. -o yuv420_bench tools/yuv420_bench.c test_pattern.c
+ *   ./yuv420_bench [capture.yuy2 ...]
+ *   ./yuv420_bench -n stream.m420 out.nv12
+ *
+ * Converts 320x240 YUY2 frames with yuv420.h the way the stream does,
+ * one line at a time through a line of Y and UV, handed out in 62-byte
+ * payloads, and checks every frame against a per-pixel conversion of
+ * the whole frame: Y as is, U and V the rounded mean of each line pair.
+ * Reports the kernel time per line and the frame rate a full-speed bulk
+ * pipe (19 packets of 62 payload bytes per 1 ms frame) would carry
+ * compared with plain YUY2, and the time to repack M420 into NV12 on
+ * the host, a copy of the planes with no arithmetic.
+ *
+ * Captures are raw YUY2 frames back to back, for example from
+ *
+ *   ffmpeg -f v4l2 -input_format yuyv422 -video_size 320x240 -i /dev/video0 \
+ *          -frames:v 50 -f rawvideo capture.yuy2
+ *
+ * Without captures it runs on the colour bars of test_pattern.c and on
+ * random bytes. -n repacks M420 frames saved back to back from the
+ * stream into NV12 for a viewer:
+ *
+ *   ffplay -f rawvideo -pixel_format nv12 -video_size 320x240 out.nv12
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "yuv420.h"
+#include "test_pattern.h"
+#include "check.h"
+
+#define WIDTH           320
+#define HEIGHT          240
+#define LINE_BYTES      (WIDTH * 2)
+#define FRAME_LEN       (LINE_BYTES * HEIGHT)
+#define M420_LEN        YUV420_FRAME_SIZE(WIDTH, HEIGHT)
+#define SYNTH_FRAMES    20
+#define PAYLOAD_SIZE    62
+#define BULK_PAYLOAD_PER_S (19 * PAYLOAD_SIZE * 1000)
+
+/* the device side: a capture source, a line and a pair buffer */
+static const uint8 *src;
+static uint8 line_buf[LINE_BYTES];
+static uint8 pair_buf[LINE_BYTES];
+static const uint8 *pos;
+static uint16 left;
+static uint8 odd;
+
+static void streamLine(void) {
+    memcpy(line_buf, src, LINE_BYTES);
+    src += LINE_BYTES;
+    if (odd) {
+        yuv420_split(line_buf, LINE_BYTES, pair_buf, pair_buf + LINE_BYTES / 2, 1);
+        left = LINE_BYTES;
+    } else {
+        yuv420_split(line_buf, LINE_BYTES, pair_buf, pair_buf + LINE_BYTES / 2, 0);
+        left = LINE_BYTES / 2;
+    }
+    pos = pair_buf;
+    odd ^= 1;
+}
+
+static void streamRead(uint8 *buf, uint16 len) {
+    while (len > 0) {
+        uint16 n;
+
+        if (left == 0) {
+            streamLine();
+        }
+        n = (left < len) ? left : len;
+        memcpy(buf, pos, n);
+        pos += n;
+        left -= n;
+        buf += n;
+        len -= n;
+    }
+}
+
+/* frames back to back, as one burst capture, in payload sized reads */
+static void convert(const uint8 *frames, uint32 count, uint8 *out) {
+    uint32 total = count * M420_LEN, done = 0;
+
+    src = frames;
+    left = 0;
+    odd = 0;
+    while (done < total) {
+        uint16 n = (total - done < PAYLOAD_SIZE) ? (uint16)(total - done) : PAYLOAD_SIZE;
+
+        streamRead(out + done, n);
+        done += n;
+    }
+}
+
+/* per pixel, from the whole frame */
+static void reference(const uint8 *frame, uint8 *out) {
+    int x, y;
+
+    for (y = 0; y < HEIGHT; y += 2) {
+        const uint8 *a = frame + y * LINE_BYTES;
+        const uint8 *b = a + LINE_BYTES;
+        uint8 *y0 = out + y / 2 * 3 * WIDTH;
+        uint8 *y1 = y0 + WIDTH;
+        uint8 *uv = y1 + WIDTH;
+
+        for (x = 0; x < WIDTH; x++) {
+            y0[x] = a[2 * x];
+            y1[x] = b[2 * x];
+            uv[x] = (uint8)((a[2 * x + 1] + b[2 * x + 1] + 1) / 2);
+        }
+    }
+}
+
+/* M420 -> NV12: the Y lines of every pair to the Y plane, the UV lines
+ * to the UV plane */
+static void repackNv12(const uint8 *m420, uint8 *nv12, int width, int height) {
+    uint8 *y = nv12;
+    uint8 *uv = nv12 + width * height;
+    int i;
+
+    for (i = 0; i < height / 2; i++) {
+        memcpy(y, m420, 2 * width);
+        memcpy(uv, m420 + 2 * width, width);
+        y += 2 * width;
+        uv += width;
+        m420 += 3 * width;
+    }
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* USB time of a frame in payloads, the first one carries PTS/SCR */
+static double bulkFps(uint32 len) {
+    uint32 packets = (len + 10 + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE;
+
+    return (double)BULK_PAYLOAD_PER_S / PAYLOAD_SIZE / packets;
+}
+
+static void bench(const char *name, const uint8 *frames, uint32 count) {
+    uint8 *out = (uint8*)malloc((size_t)count * M420_LEN);
+    uint8 *nv12 = (uint8*)malloc(M420_LEN);
+    uint8 ref[M420_LEN];
+    double conv, repack, t;
+    uint32 i;
+
+    t = now();
+    convert(frames, count, out);
+    conv = now() - t;
+
+    t = now();
+    for (i = 0; i < count; i++) {
+        repackNv12(out + (uint64)i * M420_LEN, nv12, WIDTH, HEIGHT);
+    }
+    repack = now() - t;
+
+    for (i = 0; i < count; i++) {
+        reference(frames + (uint64)i * FRAME_LEN, ref);
+        CHECK(memcmp(out + (uint64)i * M420_LEN, ref, M420_LEN) == 0);
+    }
+
+    /* the NV12 planes of the last frame hold the reference samples */
+    reference(frames + (uint64)(count - 1) * FRAME_LEN, ref);
+    CHECK(nv12[0] == ref[0] && nv12[WIDTH] == ref[WIDTH]);
+    CHECK(nv12[WIDTH * HEIGHT] == ref[2 * WIDTH]);
+    CHECK(memcmp(nv12 + WIDTH * HEIGHT + WIDTH * (HEIGHT / 2 - 1),
+                 ref + M420_LEN - WIDTH, WIDTH) == 0);
+
+    printf("%-10s %3u frames %6u bytes/frame, kernel %6.1f ns/line, "
+           "NV12 repack %5.1f us/frame, bulk %5.1f vs %4.1f frames/s\n",
+           name, count, (uint32)M420_LEN, conv * 1e9 / count / HEIGHT,
+           repack * 1e6 / count, bulkFps(M420_LEN), bulkFps(FRAME_LEN));
+    free(nv12);
+    free(out);
+}
+
+/* the rounding and the U/V order on samples picked to show them */
+static void checkCorners(void) {
+    uint8 frame[2 * LINE_BYTES], out[3 * WIDTH];
+    int x;
+
+    memset(frame, 0, sizeof(frame));
+    for (x = 0; x < WIDTH / 2; x++) {
+        /* Y0 U Y1 V over Y0 U Y1 V */
+        uint8 *a = frame + 4 * x;
+        uint8 *b = a + LINE_BYTES;
+
+        a[0] = 10; a[1] = 1; a[2] = 11; a[3] = 255;
+        b[0] = 20; b[1] = 2; b[2] = 21; b[3] = 254;
+    }
+    src = frame;
+    left = 0;
+    odd = 0;
+    streamRead(out, sizeof(out));
+    CHECK(out[0] == 10 && out[1] == 11);
+    CHECK(out[WIDTH] == 20 && out[WIDTH + 1] == 21);
+    /* (1 + 2 + 1) / 2 and (255 + 254 + 1) / 2 */
+    CHECK(out[2 * WIDTH] == 2 && out[2 * WIDTH + 1] == 255);
+    CHECK(YUV420_PAIR_BYTES(LINE_BYTES) == 3 * WIDTH);
+    CHECK(YUV420_FRAME_SIZE(WIDTH, HEIGHT) == FRAME_LEN / 4 * 3);
+    CHECK(YUV420_FRAME_SIZE(321, 241) == YUV420_FRAME_SIZE(320, 240));
+}
+
+static void synthetic(uint8 *frames) {
+    uint32 i;
+
+    test_pattern_capture(TEST_PATTERN_BARS, WIDTH, HEIGHT, SYNTH_FRAMES);
+    for (i = 0; i < SYNTH_FRAMES * HEIGHT; i++) {
+        test_pattern_read(frames + i * LINE_BYTES, LINE_BYTES);
+    }
+    bench("bars", frames, SYNTH_FRAMES);
+
+    for (i = 0; i < SYNTH_FRAMES * FRAME_LEN; i++) {
+        frames[i] = (uint8)(rand() >> 7);
+    }
+    bench("random", frames, SYNTH_FRAMES);
+}
+
+static uint8* readFile(const char *path, uint32 *len) {
+    FILE *f = fopen(path, "rb");
+    uint8 *buf;
+    long n;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = (uint8*)malloc(n ? n : 1);
+    if (buf == NULL || fread(buf, 1, n, f) != (size_t)n) {
+        fprintf(stderr, "%s: read failed\n", path);
+        exit(2);
+    }
+    fclose(f);
+    *len = (uint32)n;
+    return buf;
+}
+
+/* M420 frames back to back -> NV12 */
+static int repackStream(const char *in_path, const char *out_path) {
+    uint32 len, i;
+    uint8 *in = readFile(in_path, &len);
+    FILE *out = fopen(out_path, "wb");
+    static uint8 frame[M420_LEN];
+
+    if (out == NULL) {
+        perror(out_path);
+        return 2;
+    }
+    for (i = 0; i + M420_LEN <= len; i += M420_LEN) {
+        repackNv12(in + i, frame, WIDTH, HEIGHT);
+        fwrite(frame, 1, M420_LEN, out);
+    }
+    fclose(out);
+    free(in);
+    printf("%u frames\n", len / M420_LEN);
+    if (len % M420_LEN) {
+        fprintf(stderr, "%s: %u bytes left over\n", in_path, len % M420_LEN);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint8 *frames;
+    int i;
+
+    if (argc == 4 && strcmp(argv[1], "-n") == 0) {
+        return repackStream(argv[2], argv[3]);
+    }
+
+    checkCorners();
+    if (argc == 1) {
+        frames = (uint8*)malloc(SYNTH_FRAMES * FRAME_LEN);
+        synthetic(frames);
+        free(frames);
+    }
+    for (i = 1; i < argc; i++) {
+        uint32 len;
+
+        frames = readFile(argv[i], &len);
+        if (len < FRAME_LEN) {
+            fprintf(stderr, "%s: not a single %dx%d YUY2 frame\n", argv[i], WIDTH, HEIGHT);
+            return 2;
+        }
+        bench(argv[i], frames, len / FRAME_LEN);
+        free(frames);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * Host benchmark and round trip check of the lossless YUY2 coder
+ *
+ *   cc -O2 -Itools/host -I. -o yuy2_rice_bench tools/yuy2_rice_bench.c test_pattern.c
+ *   ./yuy2_rice_bench [-s spi_hz] [-c code_cycles] [capture.yuy2 ...]
+ *   ./yuy2_rice_bench -d stream.yrc out.yuy2
+ *
+ * Codes 320x240 frames line by line with yuy2_rice.h the way the stream
+ * does, decodes them again and checks that every frame comes back bit
+ * exact and within YUY2_RICE_FRAME_MAX(). Reports the coded size, the
+ * encoder time per line on the host and the decoder time per frame.
+ *
+ * The frame rate it reports, coded against plain YUY2, is the slowest
+ * of two paths. A full-speed bulk pipe carries 19 packets of 62 payload
+ * bytes per 1 ms frame. The device reads every raw line over SPI at
+ * spi_hz (default 18 MHz, the fastest step) and then codes it on the
+ * same core, so those two add up. The coding costs code_cycles per line
+ * at 72 MHz; `s` prints the measured figure. Without -c, a Cortex-M3
+ * estimate stands in: 20 cycles per sample for the prediction, the code
+ * and the bit packing, and 6 per coded byte stored.
+ *
+ * Captures are raw YUY2 frames back to back, for example from
+ *
+ *   ffmpeg -f v4l2 -input_format yuyv422 -video_size 320x240 -i /dev/video0 \
+ *          -frames:v 50 -f rawvideo capture.yuy2
+ *
+ * Without captures it runs on synthetic frames: the colour bars of
+ * test_pattern.c, a smooth scene with sensor-like noise at two levels,
+ * and random bytes for the raw fallback. -d decodes coded frames saved
+ * back to back from the stream into raw YUY2 for a viewer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "yuy2_rice.h"
+#include "test_pattern.h"
+#include "check.h"
+
+#define WIDTH           320
+#define HEIGHT          240
+#define LINE_BYTES      (WIDTH * 2)
+#define FRAME_LEN       (LINE_BYTES * HEIGHT)
+#define CODED_MAX       YUY2_RICE_FRAME_MAX(WIDTH, HEIGHT)
+#define SYNTH_FRAMES    20
+#define PAYLOAD_SIZE    62
+#define BULK_PAYLOAD_PER_S (19 * PAYLOAD_SIZE * 1000)
+#define CORE_HZ         72000000
+#define SAMPLE_CYCLES   20
+#define BYTE_CYCLES     6
+
+static uint32 spi_hz = 18000000;
+static uint32 code_cycles;      /* per line, 0: the estimate */
+
+static uint8 coded[CODED_MAX];
+static uint8 decoded[FRAME_LEN];
+static uint8 line_out[LINE_BYTES];
+
+/* Header and lines, raw where coding does not pay, as the stream sends them */
+static uint32 encodeFrame(const uint8 *frame) {
+    yuy2_rice s;
+    uint32 len = YUY2_RICE_HEADER_SIZE;
+    uint16 y;
+
+    yuy2_rice_begin(&s, WIDTH);
+    yuy2_rice_header(&s, HEIGHT, coded);
+    for (y = 0; y < HEIGHT; y++) {
+        const uint8 *line = frame + y * LINE_BYTES;
+        uint16 n = yuy2_rice_encode_line(&s, line, line_out);
+
+        if (n != 0) {
+            memcpy(coded + len, line_out, n);
+            len += n;
+        } else {
+            coded[len++] = YUY2_RICE_RAW;
+            memcpy(coded + len, line, LINE_BYTES);
+            len += LINE_BYTES;
+        }
+    }
+    return len;
+}
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* USB time of a frame in payloads, the first one carries PTS/SCR */
+static double bulkSeconds(uint32 len) {
+    uint32 packets = (len + 10 + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE;
+
+    return (double)packets * PAYLOAD_SIZE / BULK_PAYLOAD_PER_S;
+}
+
+/* device time to code a frame of len coded bytes */
+static double codeSeconds(uint32 len) {
+    double cycles = code_cycles ? (double)code_cycles * HEIGHT :
+        (double)FRAME_LEN * SAMPLE_CYCLES + (double)len * BYTE_CYCLES;
+
+    return cycles / CORE_HZ;
+}
+
+/* frames per second through the slower of the SPI read plus coding
+ * and the bulk pipe; code_s is 0 for plain YUY2 */
+static double frameFps(uint32 len, double code_s) {
+    double core = (double)FRAME_LEN * 8 / spi_hz + code_s;
+    double usb = bulkSeconds(len);
+
+    return 1 / (core > usb ? core : usb);
+}
+
+static void bench(const char *name, const uint8 *frames, uint32 count) {
+    double enc = 0, dec = 0, t;
+    uint64 total = 0;
+    uint32 i, worst = 0, raw_lines = 0;
+
+    for (i = 0; i < count; i++) {
+        const uint8 *frame = frames + (uint64)i * FRAME_LEN;
+        uint16 w = 0, h = 0;
+        uint32 len, used, k;
+
+        t = now();
+        len = encodeFrame(frame);
+        enc += now() - t;
+
+        t = now();
+        used = yuy2_rice_decode_frame(coded, len, decoded, sizeof(decoded), &w, &h);
+        dec += now() - t;
+
+        CHECK(len <= CODED_MAX);
+        CHECK(used == len);
+        CHECK(w == WIDTH && h == HEIGHT);
+        CHECK(memcmp(decoded, frame, FRAME_LEN) == 0);
+
+        /* a frame cut short must not decode */
+        CHECK(yuy2_rice_decode_frame(coded, len - 1, decoded, sizeof(decoded), &w, &h) == 0);
+
+        for (k = YUY2_RICE_HEADER_SIZE; k < len; ) {
+            yuy2_rice s;
+
+            yuy2_rice_begin(&s, WIDTH);
+            if (coded[k] & YUY2_RICE_RAW) {
+                raw_lines++;
+            }
+            k += yuy2_rice_decode_line(&s, coded + k, len - k, decoded);
+        }
+        total += len;
+        if (len > worst) {
+            worst = len;
+        }
+    }
+
+    printf("%-10s %3u frames %6u bytes/frame (worst %6u) %4.2fx %4u raw lines, "
+           "encode %6.1f ns/line, decode %6.1f us/frame, device code %5.1f ms/frame, "
+           "%5.1f vs %4.1f frames/s\n",
+           name, count, (uint32)(total / count), worst, (double)FRAME_LEN * count / total,
+           raw_lines, enc * 1e9 / count / HEIGHT, dec * 1e6 / count,
+           codeSeconds((uint32)(total / count)) * 1e3,
+           frameFps((uint32)(total / count), codeSeconds((uint32)(total / count))),
+           frameFps(FRAME_LEN, 0));
+}
+
+static uint32 lcg = 12345;
+
+static uint8 noise(int amp) {
+    lcg = lcg * 1103515245 + 12345;
+    return (uint8)((int)((lcg >> 16) % (2 * amp + 1)) - amp);
+}
+
+static uint8 clamp(int v) {
+    return (uint8)(v < 16 ? 16 : v > 235 ? 235 : v);
+}
+
+/* slow gradients and a bright disc that moves, plus per-sample noise */
+static void makeScene(uint8 *frames, int amp) {
+    uint32 f;
+    int x, y;
+
+    for (f = 0; f < SYNTH_FRAMES; f++) {
+        uint8 *p = frames + f * FRAME_LEN;
+        int cx = 80 + f * 8, cy = 120;
+
+        for (y = 0; y < HEIGHT; y++) {
+            for (x = 0; x < WIDTH; x += 2) {
+                int d = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                int base = 40 + x / 4 + y / 3 + (d < 40 * 40 ? 90 : 0);
+
+                p[0] = clamp(base + (int8)noise(amp));
+                p[1] = clamp(128 - y / 8 + (int8)noise(amp / 2));
+                p[2] = clamp(base + 1 + (int8)noise(amp));
+                p[3] = clamp(128 + x / 16 + (int8)noise(amp / 2));
+                p += 4;
+            }
+        }
+    }
+}
+
+static void synthetic(uint8 *frames) {
+    uint32 i;
+
+    test_pattern_capture(TEST_PATTERN_BARS, WIDTH, HEIGHT, SYNTH_FRAMES);
+    for (i = 0; i < SYNTH_FRAMES * HEIGHT; i++) {
+        test_pattern_read(frames + i * LINE_BYTES, LINE_BYTES);
+    }
+    bench("bars", frames, SYNTH_FRAMES);
+
+    makeScene(frames, 2);
+    bench("scene +-2", frames, SYNTH_FRAMES);
+    makeScene(frames, 6);
+    bench("scene +-6", frames, SYNTH_FRAMES);
+
+    for (i = 0; i < SYNTH_FRAMES * FRAME_LEN; i++) {
+        frames[i] = (uint8)(rand() >> 7);
+    }
+    bench("random", frames, SYNTH_FRAMES);
+}
+
+static uint8* readFile(const char *path, uint32 *len) {
+    FILE *f = fopen(path, "rb");
+    uint8 *buf;
+    long n;
+
+    if (f == NULL) {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = (uint8*)malloc(n ? n : 1);
+    if (buf == NULL || fread(buf, 1, n, f) != (size_t)n) {
+        fprintf(stderr, "%s: read failed\n", path);
+        exit(2);
+    }
+    fclose(f);
+    *len = (uint32)n;
+    return buf;
+}
+
+/* coded frames back to back -> raw YUY2 */
+static int decodeStream(const char *in_path, const char *out_path) {
+    uint32 len, pos = 0, frames = 0;
+    uint8 *in = readFile(in_path, &len);
+    FILE *out = fopen(out_path, "wb");
+    static uint8 frame[4096 * 2 * 2048];
+
+    if (out == NULL) {
+        perror(out_path);
+        return 2;
+    }
+    while (pos < len) {
+        uint16 w, h;
+        uint32 n = yuy2_rice_decode_frame(in + pos, len - pos, frame, sizeof(frame), &w, &h);
+
+        if (n == 0) {
+            fprintf(stderr, "%s: broken frame at offset %u\n", in_path, pos);
+            break;
+        }
+        fwrite(frame, 1, (size_t)YUY2_RICE_LINE_BYTES(w) * h, out);
+        pos += n;
+        frames++;
+    }
+    fclose(out);
+    free(in);
+    printf("%u frames\n", frames);
+    return pos != len;
+}
+
+int main(int argc, char **argv) {
+    uint8 *frames;
+    int i;
+
+    if (argc == 4 && strcmp(argv[1], "-d") == 0) {
+        return decodeStream(argv[2], argv[3]);
+    }
+
+    for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-s") == 0) {
+            spi_hz = (uint32)atol(argv[i + 1]);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            code_cycles = (uint32)atol(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+    if (spi_hz == 0) {
+        spi_hz = 18000000;
+    }
+    printf("spi %.1f MHz, coding %s%u cycles/line\n", spi_hz / 1e6,
+           code_cycles ? "" : "estimated, about ",
+           code_cycles ? code_cycles : LINE_BYTES * SAMPLE_CYCLES);
+
+    if (i == argc) {
+        frames = (uint8*)malloc(SYNTH_FRAMES * FRAME_LEN);
+        synthetic(frames);
+        free(frames);
+    }
+    for (; i < argc; i++) {
+        uint32 len;
+
+        frames = readFile(argv[i], &len);
+        if (len < FRAME_LEN) {
+            fprintf(stderr, "%s: not a single %dx%d YUY2 frame\n", argv[i], WIDTH, HEIGHT);
+            return 2;
+        }
+        bench(argv[i], frames, len / FRAME_LEN);
+        free(frames);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Event trace ring, see trace.h
+ */
+
+#include <string.h>
+
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+trace_entry trace_ring[TRACE_SIZE];
+volatile uint32 trace_head;
+volatile uint8 trace_mask = TRACE_MASK_DEFAULT;
+
+static uint32 tail;             /* next event trace_read() hands out */
+
+/* Classes recorded from now on, TRACE_CLASS_* */
+void trace_set_mask(uint8 mask) {
+    trace_mask = mask & TRACE_CLASS_ALL;
+}
+
+/*
+ * Copy up to max_events of the oldest unread events into buf, 8 bytes
+ * each as in trace_entry. Runs from the main loop while events keep
+ * coming in: an event overwritten while it was copied is dropped and
+ * counted in the TRACE_LOST event that leads the next read.
+ */
+uint8 trace_read(uint8 *buf, uint8 max_events) {
+    uint32 lost = 0;
+    uint8 n = 0;
+
+    while (n < max_events && tail != trace_head) {
+        trace_entry e;
+
+        if (trace_head - tail > TRACE_SIZE) {
+            lost += trace_head - TRACE_SIZE - tail;
+            tail = trace_head - TRACE_SIZE;
+        }
+        e = trace_ring[tail & (TRACE_SIZE - 1)];
+        if (trace_head - tail > TRACE_SIZE) {
+            /* overwritten while copying, try again from the new oldest */
+            continue;
+        }
+        if (lost != 0) {
+            trace_entry mark = {e.cycles, TRACE_LOST, 0, (uint16)(lost > 0xFFFF ? 0xFFFF : lost)};
+
+            memcpy(buf + n * TRACE_ENTRY_SIZE, &mark, TRACE_ENTRY_SIZE);
+            lost = 0;
+            if (++n == max_events) {
+                break;
+            }
+        }
+        memcpy(buf + n * TRACE_ENTRY_SIZE, &e, TRACE_ENTRY_SIZE);
+        tail++;
+        n++;
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Event trace ring with DWT cycle stamps
+ *
+ * trace_event() records an 8-byte event into a fixed ring in RAM from
+ * any context: interrupts are masked for the few stores it takes, no
+ * call, no formatting. The ring keeps the newest TRACE_SIZE events;
+ * trace_read() hands them out oldest first, led by a TRACE_LOST event
+ * when the writer overtook the reader. The ring is drained over the
+ * vendor interface (REG_SCRIPT_TRACE in reg_script.h) and
+ * tools/trace_dump.py turns the events into a Chrome/Perfetto trace.
+ *
+ * Events belong to classes that can be switched off at run time, the
+ * per-packet endpoint events fill the ring in a few milliseconds of
+ * streaming. Build with TRACE_ENABLE 0 to compile all of it out.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <libmaple/libmaple_types.h>
+
+#include "dwt.h"
+#include "irq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+
+/* events in the ring, a power of two */
+#ifndef TRACE_SIZE
+#define TRACE_SIZE              256
+#endif
+
+typedef char trace_size_check[(TRACE_SIZE & (TRACE_SIZE - 1)) == 0 ? 1 : -1];
+
+/* event classes, trace_set_mask() */
+#define TRACE_CLASS_EP          0x01    /* CTR interrupts of the data endpoints */
+#define TRACE_CLASS_SETUP       0x02    /* class requests on endpoint 0 */
+#define TRACE_CLASS_FIFO        0x04    /* captures and FIFO reads */
+#define TRACE_CLASS_FRAME       0x08    /* frames, drops and faults */
+#define TRACE_CLASS_ALL         0x0F
+
+#ifndef TRACE_MASK_DEFAULT
+#define TRACE_MASK_DEFAULT      (TRACE_CLASS_SETUP | TRACE_CLASS_FIFO | TRACE_CLASS_FRAME)
+#endif
+
+/* event ids and what a and b hold; the high nibble is the class */
+#define TRACE_EP_IN             0x10    /* a endpoint */
+#define TRACE_EP_OUT            0x11    /* a endpoint */
+#define TRACE_RING_EMPTY        0x12    /* the streaming endpoint went idle */
+#define TRACE_SETUP             0x20    /* a bRequest, b entity << 8 | selector */
+#define TRACE_SETUP_NODATA      0x21    /* same */
+#define TRACE_CAPTURE           0x40    /* a frames, b test pattern */
+#define TRACE_CAPTURE_DONE      0x41    /* a:b FIFO length, 24 bits */
+#define TRACE_DRAIN_BEGIN       0x42
+#define TRACE_DRAIN_END         0x43    /* b packets queued */
+#define TRACE_SCAN              0x44    /* a luma change */
+#define TRACE_CACHE             0x45    /* a frames, b 1 capturing 2 done */
+#define TRACE_TRIGGER           0x46    /* at the capture's VSYNC, a UVC_TRIGGER_*, b delay in us */
+#define TRACE_FRAME_START       0x80    /* a FID */
+#define TRACE_FRAME_END         0x81    /* a FID */
+#define TRACE_DROP              0x82    /* a TRACE_DROP_* */
+#define TRACE_FAULT             0x83    /* a bStreamErrorCode */
+#define TRACE_SPI_FALLBACK      0x84    /* a SPI clock step now in use */
+#define TRACE_LOST              0xF0    /* b events overwritten before read */
+
+/* TRACE_DROP reasons */
+#define TRACE_DROP_UNCHANGED    1       /* replaced by a keepalive */
+#define TRACE_DROP_RECOVER      2       /* cut off by a fault */
+
+typedef struct trace_entry {
+    uint32 cycles;
+    uint8 id;
+    uint8 a;
+    uint16 b;
+} trace_entry;
+
+#define TRACE_ENTRY_SIZE        8
+
+typedef char trace_entry_check[sizeof(trace_entry) == TRACE_ENTRY_SIZE ? 1 : -1];
+
+#if TRACE_ENABLE
+
+extern trace_entry trace_ring[TRACE_SIZE];
+extern volatile uint32 trace_head;
+extern volatile uint8 trace_mask;
+
+/* An event stamped with an earlier DWT reading, for a span that is only
+ * worth recording once it has ended */
+static inline __attribute__((always_inline))
+void trace_event_at(uint32 cycles, uint8 id, uint8 a, uint16 b) {
+    trace_entry *e;
+    uint32 primask;
+
+    if (!(trace_mask & (id >> 4))) {
+        return;
+    }
+    primask = irq_save();
+    e = &trace_ring[trace_head & (TRACE_SIZE - 1)];
+    e->cycles = cycles;
+    e->id = id;
+    e->a = a;
+    e->b = b;
+    trace_head++;
+    irq_restore(primask);
+}
+
+static inline __attribute__((always_inline)) void trace_event(uint8 id, uint8 a, uint16 b) {
+    trace_event_at(dwt_cycles(), id, a, b);
+}
+
+void trace_set_mask(uint8 mask);
+uint8 trace_read(uint8 *buf, uint8 max_events);
+
+#else
+
+static inline void trace_event_at(uint32 cycles, uint8 id, uint8 a, uint16 b) {
+    (void)cycles;
+    (void)id;
+    (void)a;
+    (void)b;
+}
+
+static inline void trace_event(uint8 id, uint8 a, uint16 b) {
+    (void)id;
+    (void)a;
+    (void)b;
+}
+
+static inline void trace_set_mask(uint8 mask) {
+    (void)mask;
+}
+
+static inline uint8 trace_read(uint8 *buf, uint8 max_events) {
+    (void)buf;
+    (void)max_events;
+    return 0;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
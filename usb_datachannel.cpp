@@ -2,8 +2,20 @@
  * @brief USB virtual serial terminal
  */
 
+#include <string.h>
+
 #include "usb_datachannel.h"
 #include "usb_uvc.h"
+#include "ov2640.h"
+#include "sccb.h"
+#include "arducam.h"
+#include "uvc_stream.h"
+#include "uvc_trigger.h"
+#include "reg_script.h"
+#include "mem_pool.h"
+#include "sched.h"
+#include "dwt.h"
+#include "wirish_time.h"
 
 /*
  * USBSerial interface
@@ -11,6 +23,240 @@
 
 #define USB_TIMEOUT 50
 bool USBDataChannel::_hasBegun = false;
+uint8 USBDataChannel::_format = 0;
+
+/*
+ * Main loop tasks, added at the end of the boot from what it measured.
+ * A stream pass queues at most a ring of packets plus the FIFO line the
+ * coder, the 4:2:0 split or a frame scan reads ahead, or spends its
+ * polled slice; its budget is that at the FIFO read rate the SPI
+ * calibration timed. The ring the pass left full lasts RING_US on the
+ * bus, which is what the other tasks get before the stream is due
+ * again. They are sized in register accesses at the SCCB write time of
+ * the sensor init table: the control task makes one AE access, a bank
+ * select or a read, the script task runs up to REG_SCRIPT_OPS_PER_POLL
+ * reads. Mode and ROI switches take milliseconds, with the stream
+ * stopped, and are exempt.
+ */
+static sched_task stream_task;
+static sched_task control_task;
+static sched_task script_task;
+
+/* tasks sched_add() refused, run from poll() outside the scheduler */
+static sched_task *unscheduled[3];
+static uint8 num_unscheduled;
+
+/* a full ring on the bus, 19 bulk packets per USB frame */
+#define RING_US                 (UVC_STREAM_RING_SIZE * 1000 / 19)
+
+/* before anything is measured: 1 KB at the SPI clock, a 2-byte SCCB
+ * write of 29 bit times at 400 kHz */
+#define SPI_KB_US(hz)           (8192000 / ((hz) / 1000))
+#define SCCB_WRITE_US           73
+
+static uint32 schedClock(void) {
+    return micros();
+}
+
+/*
+ * Startup. The USB pull-up goes on first and enumeration runs from the
+ * USB interrupt, while poll() takes the sensor through these steps one
+ * per call. The ArduCAM FIFO test fills the sensor's reset time. A
+ * commit that arrives early stays pending until BOOT_READY; if it is
+ * already there when the default mode is due, its mode is programmed
+ * instead. The SPI clock is calibrated last, on a frame captured for it
+ * in that mode; the first commit waits for that too, a frame and some
+ * 50 ms of FIFO reads.
+ */
+enum {
+    BOOT_SENSOR_RESET,          /* SCCB up, sensor probed and soft reset */
+    BOOT_FIFO,                  /* ArduCAM SPI and FIFO test */
+    BOOT_RESET_WAIT,            /* rest of OV2640_RESET_DELAY_US */
+    BOOT_SENSOR_INIT,           /* sensor init table */
+    BOOT_SENSOR_MODE,           /* default or committed mode */
+    BOOT_SPI_CAPTURE,           /* frame for the SPI clock calibration */
+    BOOT_SPI_CAL,               /* one SPI clock step per call */
+    BOOT_READY,
+};
+
+static uint8 boot_state = BOOT_SENSOR_RESET;
+static uint32 boot_reset_us;
+static uint32 boot_capture_us;
+static uint32 boot_cycles;      /* DWT and micros() at the same moment, */
+static uint32 boot_cycles_us;   /* for stamps taken in the USB interrupt */
+static boot_stats boot;
+
+static uint32 bootMicros(void) {
+    uint32 us = micros();
+
+    /* 0 means not reached */
+    return us ? us : 1;
+}
+
+static void schedAdd(sched_task *task) {
+    if (sched_add(task) != 0) {
+        boot.sched_refused++;
+        unscheduled[num_unscheduled++] = task;
+    }
+}
+
+/*
+ * Add the tasks with budgets from the boot measurements. The stream
+ * deadline stays at a full ring past its budget. A script task that
+ * does not fit is retried with fewer operations per run; a task that
+ * still does not fit runs unscheduled, see poll(), and
+ * boot.sched_refused counts it.
+ */
+static void schedStart(void) {
+    const arducam_spi_stats *spi = arducam_spi_get_stats();
+    uint32 kb_us = spi->kb_us ? spi->kb_us : SPI_KB_US(spi->hz);
+    uint32 line_us = MEM_POOL_LINE_SIZE * kb_us / 1024;
+    uint32 write_us = boot.sccb_write_us ? boot.sccb_write_us : SCCB_WRITE_US;
+    uint32 read_us = write_us * 4 / 3;
+    uint32 fill_us = UVC_STREAM_RING_SIZE * USB_TX_EPSIZE * kb_us / 1024 + line_us;
+    uint8 ops = REG_SCRIPT_OPS_PER_POLL;
+
+    /* either refill path, `p` switches them at run time */
+    stream_task.budget_us = (fill_us > UVC_STREAM_POLL_SLICE_US + line_us) ?
+        fill_us : UVC_STREAM_POLL_SLICE_US + line_us;
+    stream_task.deadline_us = stream_task.budget_us + RING_US;
+    control_task.budget_us = (write_us > read_us) ? write_us : read_us;
+
+    schedAdd(&stream_task);
+    schedAdd(&control_task);
+    do {
+        reg_script_set_ops(ops);
+        script_task.budget_us = ops * read_us;
+    } while (sched_add(&script_task) != 0 && --ops != 0);
+    if (ops == 0) {
+        boot.sched_refused++;
+        unscheduled[num_unscheduled++] = &script_task;
+    }
+}
+
+/* longest wait for the calibration frame, the clock stays safe past it */
+#define SPI_CAL_CAPTURE_US      500000
+
+/* the sensor AEC registers are read at about the MJPEG frame rate */
+#define SENSOR_AE_PERIOD_US     100000
+
+typedef char stats_layout_check[
+    (AE_STATS_BINS == USB_UVC_STATS_BINS && AE_STATS_ZONES == USB_UVC_STATS_ZONES) ? 1 : -1];
+
+static uint32 stats_frame;
+static uint32 sensor_ae_last;
+
+/* a JPEG of a small region still carries its headers and tables */
+#define MJPEG_MIN_FRAME_SIZE    0x4000
+
+static uint8 formatMode(uint8 format) {
+    switch (format) {
+    case USB_UVC_FORMAT_MJPEG:
+        return OV2640_MODE_MJPEG_1600x1200;
+    case USB_UVC_FORMAT_BAYER:
+        return OV2640_MODE_RAW8_320x240;
+    default:
+        return OV2640_MODE_YUY2_320x240;
+    }
+}
+
+/*
+ * Work out dwMaxVideoFrameSize for every format from the sensor output
+ * size. YUY2, 4:2:0 and Bayer are exact, the coded format takes its
+ * worst case, MJPEG scales the worst case with the area.
+ */
+static uint32 updateFrameSizes(uint8 format) {
+    ov2640_window out;
+    uint32 yuy2 = USB_UVC_YUY2_FRAME_SIZE;
+    uint32 mjpeg = USB_UVC_MJPEG_FRAME_SIZE;
+    uint32 rice = USB_UVC_RICE_FRAME_SIZE;
+    uint32 m420 = USB_UVC_M420_FRAME_SIZE;
+    uint32 bayer = USB_UVC_BAYER_FRAME_SIZE;
+
+    if (ov2640_output_size(OV2640_MODE_YUY2_320x240, &out) == 0) {
+        yuy2 = (uint32)out.w * out.h * 2;
+        rice = YUY2_RICE_FRAME_MAX(out.w, out.h);
+        m420 = YUV420_FRAME_SIZE(out.w, out.h);
+    }
+    if (ov2640_output_size(OV2640_MODE_RAW8_320x240, &out) == 0) {
+        bayer = (uint32)out.w * out.h;
+    }
+    if (ov2640_output_size(OV2640_MODE_MJPEG_1600x1200, &out) == 0) {
+        mjpeg = (uint32)((uint64)USB_UVC_MJPEG_FRAME_SIZE * out.w * out.h /
+                         (OV2640_UXGA_WIDTH * OV2640_UXGA_HEIGHT));
+        if (mjpeg < MJPEG_MIN_FRAME_SIZE) {
+            mjpeg = MJPEG_MIN_FRAME_SIZE;
+        }
+    }
+    usb_uvc_set_frame_size(USB_UVC_FORMAT_YUY2, yuy2);
+    usb_uvc_set_frame_size(USB_UVC_FORMAT_MJPEG, mjpeg);
+    usb_uvc_set_frame_size(USB_UVC_FORMAT_RICE, rice);
+    usb_uvc_set_frame_size(USB_UVC_FORMAT_M420, m420);
+    usb_uvc_set_frame_size(USB_UVC_FORMAT_BAYER, bayer);
+    switch (format) {
+    case USB_UVC_FORMAT_MJPEG:
+        return mjpeg;
+    case USB_UVC_FORMAT_RICE:
+        return rice;
+    case USB_UVC_FORMAT_M420:
+        return m420;
+    case USB_UVC_FORMAT_BAYER:
+        return bayer;
+    default:
+        return yuy2;
+    }
+}
+
+/* Tell the stream the output size and start it */
+static void startStream(uint8 format, uint32 frame_size) {
+    ov2640_window out;
+
+    if (ov2640_output_size(formatMode(format), &out) == 0) {
+        uvc_stream_set_geometry(out.w, out.h);
+    }
+    uvc_stream_start(format, frame_size);
+}
+
+/*
+ * Hand the extension unit a new set of exposure statistics: measured on
+ * the payload for YUY2, read from the sensor for MJPEG and the coded,
+ * 4:2:0 and Bayer formats, which the statistics kernel cannot read.
+ * The sensor is read one register per call to stay inside the control
+ * task budget.
+ */
+static void publishStats(uint8 format) {
+    usb_uvc_stats out;
+    ae_stats ae;
+    ov2640_ae sensor;
+
+    memset(&out, 0, sizeof(out));
+    if (format == USB_UVC_FORMAT_YUY2) {
+        if (!uvc_stream_get_ae(&ae)) {
+            return;
+        }
+        out.bSource = USB_UVC_STATS_PIXELS;
+        out.bYMean = ae.y_mean;
+        out.bUMean = ae.u_mean;
+        out.bVMean = ae.v_mean;
+        memcpy(out.bZoneMean, ae.zone_mean, sizeof(out.bZoneMean));
+        memcpy(out.wHistogram, ae.hist, sizeof(out.wHistogram));
+    } else if (format == USB_UVC_FORMAT_MJPEG || format == USB_UVC_FORMAT_RICE ||
+               format == USB_UVC_FORMAT_M420 || format == USB_UVC_FORMAT_BAYER) {
+        if (micros() - sensor_ae_last < SENSOR_AE_PERIOD_US ||
+            ov2640_poll_ae(&sensor) != 1) {
+            return;
+        }
+        sensor_ae_last = micros();
+        out.bSource = USB_UVC_STATS_SENSOR;
+        out.bYMean = sensor.y_avg;
+        out.wExposure = sensor.exposure;
+        out.bGain = sensor.gain;
+    } else {
+        return;
+    }
+    out.dwFrame = ++stats_frame;
+    usb_uvc_set_stats(&out);
+}
 
 
 USBDataChannel::USBDataChannel(void) {
@@ -24,6 +270,193 @@ void USBDataChannel::begin(void) {
         return;
     _hasBegun = true;
 
+    uvc_stream_init();
+    uvc_trigger_init();
+    reg_script_init();
+
+    stream_task.name = "stream";
+    stream_task.run = streamTask;
+    control_task.name = "control";
+    control_task.run = controlTask;
+    control_task.priority = 1;
+    script_task.name = "script";
+    script_task.run = scriptTask;
+    script_task.priority = 2;
+    sched_init(schedClock);
+
+    dwt_enable();
+    boot_cycles = dwt_cycles();
+    boot_cycles_us = micros();
     usb_enable(BOARD_USB_DISC_DEV, (uint8_t)BOARD_USB_DISC_BIT);
+    boot.usb_us = bootMicros();
 }
 
+/*
+ * One startup step per call. A sensor that fails a step is left where
+ * it is; the stream then only runs from a test pattern or the
+ * application.
+ */
+void USBDataChannel::bootStep(void) {
+    switch (boot_state) {
+    case BOOT_SENSOR_RESET:
+        if (ov2640_init_begin() != 0) {
+            boot.sensor_status = -1;
+        }
+        boot_reset_us = micros();
+        boot_state = BOOT_FIFO;
+        break;
+
+    case BOOT_FIFO:
+        boot.fifo_status = (int8)arducam_init();
+        boot.fifo_us = bootMicros();
+        boot_state = BOOT_RESET_WAIT;
+        break;
+
+    case BOOT_RESET_WAIT:
+        if (micros() - boot_reset_us < OV2640_RESET_DELAY_US)
+            break;
+        boot_state = (boot.sensor_status == 0) ? BOOT_SENSOR_INIT : BOOT_READY;
+        break;
+
+    case BOOT_SENSOR_INIT: {
+        uint16 writes = sccb_get_stats()->writes;
+
+        if (ov2640_init_finish() != 0) {
+            boot.sensor_status = -2;
+            boot_state = BOOT_READY;
+            break;
+        }
+        writes = sccb_get_stats()->writes - writes;
+        if (writes != 0) {
+            boot.sccb_write_us = (uint16)(sccb_get_stats()->table_us / writes);
+        }
+        boot_state = BOOT_SENSOR_MODE;
+        break;
+    }
+
+    case BOOT_SENSOR_MODE:
+        if (ov2640_set_mode(formatMode(usb_uvc_commit_format())) != 0) {
+            boot.sensor_status = -3;
+        }
+        boot_state = (boot.fifo_status == 0 && boot.sensor_status == 0) ?
+            BOOT_SPI_CAPTURE : BOOT_READY;
+        break;
+
+    case BOOT_SPI_CAPTURE:
+        if (boot_capture_us == 0) {
+            arducam_set_frames(1);
+            arducam_start_capture();
+            boot_capture_us = bootMicros();
+            break;
+        }
+        if (!arducam_capture_done()) {
+            if (micros() - boot_capture_us > SPI_CAL_CAPTURE_US) {
+                boot_state = BOOT_READY;
+            }
+            break;
+        }
+        boot_state = (arducam_spi_cal_begin(arducam_fifo_length()) == 0) ?
+            BOOT_SPI_CAL : BOOT_READY;
+        break;
+
+    case BOOT_SPI_CAL:
+        if (arducam_spi_cal_step() == 0) {
+            boot.spi_us = bootMicros();
+            boot_state = BOOT_READY;
+        }
+        break;
+    }
+
+    if (boot_state == BOOT_READY) {
+        boot.sensor_us = bootMicros();
+        schedStart();
+    }
+}
+
+void USBDataChannel::poll(void) {
+    uint32 cycles;
+
+    if (!_hasBegun)
+        return;
+
+    if (boot.configured_us == 0 && usb_uvc_configured(&cycles)) {
+        boot.configured_us = boot_cycles_us + dwt_cycles_to_us(cycles - boot_cycles);
+    }
+    if (boot_state != BOOT_READY) {
+        bootStep();
+        return;
+    }
+    if (boot.first_frame_us == 0 && boot.commit_us != 0 && uvc_stream_frames_done() != 0) {
+        boot.first_frame_us = bootMicros();
+    }
+
+    sched_run();
+
+    /*
+     * A refused stream task still runs every pass, the others only while
+     * there is no stream to hold up or a commit is about to stop it.
+     */
+    for (uint8 i = 0; i < num_unscheduled; i++) {
+        if (unscheduled[i] == &stream_task || _format == 0 || usb_uvc_commit_pending())
+            unscheduled[i]->run();
+    }
+    UVCCamera::poll();
+}
+
+const boot_stats* USBDataChannel::bootStats(void) {
+    return &boot;
+}
+
+void USBDataChannel::useAppSource(bool app) {
+    uvc_stream_set_source(app ? UVC_STREAM_SOURCE_APP : UVC_STREAM_SOURCE_SENSOR);
+}
+
+void USBDataChannel::streamTask(void) {
+    uvc_stream_poll();
+}
+
+/*
+ * Apply a streaming format committed by the host or a new region of
+ * interest, and publish exposure statistics. Only the registers that
+ * differ between the old and the new sensor mode are written.
+ */
+void USBDataChannel::controlTask(void) {
+    struct uvc_streaming_control ctrl;
+    usb_uvc_roi roi;
+
+    if (usb_uvc_get_commit(&ctrl)) {
+        uvc_stream_stop();
+        _format = ctrl.bFormatIndex;
+        ov2640_set_mode(formatMode(_format));
+        uvc_stream_set_interval(ctrl.dwFrameInterval);
+        startStream(_format, ctrl.dwMaxVideoFrameSize);
+        if (boot.commit_us == 0)
+            boot.commit_us = bootMicros();
+        sched_exempt();
+    }
+
+    /*
+     * A new region of interest changes the frame size, the host sees it
+     * on its next probe. A running stream restarts on the new size.
+     */
+    if (usb_uvc_get_roi(&roi)) {
+        ov2640_window win = {roi.wX, roi.wY, roi.wWidth, roi.wHeight};
+        uint32 size;
+
+        if (_format)
+            uvc_stream_stop();
+        /* the FIFO holds the old region, even at the same size */
+        uvc_stream_drop_cache();
+        ov2640_set_roi(&win);
+        size = updateFrameSizes(_format);
+        if (_format)
+            startStream(_format, size);
+        sched_exempt();
+    }
+
+    publishStats(_format);
+}
+
+void USBDataChannel::scriptTask(void) {
+    reg_script_poll();
+}
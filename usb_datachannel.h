@@ -2,18 +2,49 @@
 #define _USB_DATACHANNEL_H_
 
 #include "boards.h"
+#include "uvc_camera_stream.h"
+
+/*
+ * Startup milestones in microseconds since power-on, 0 until reached.
+ * The sensor is brought up from poll() while the host enumerates.
+ */
+typedef struct boot_stats {
+    uint32 usb_us;              /* pull-up on, enumeration can start */
+    uint32 fifo_us;             /* ArduCAM FIFO tested */
+    uint32 spi_us;              /* SPI clock calibrated, 0 if it stayed safe */
+    uint32 sensor_us;           /* sensor programmed, commits are applied */
+    uint32 configured_us;       /* SET_CONFIGURATION from the host */
+    uint32 commit_us;           /* first commit applied */
+    uint32 first_frame_us;      /* the host has read the first whole frame */
+    uint16 sccb_write_us;       /* per init table register, 0 if not run */
+    int8 fifo_status;           /* arducam_init() */
+    int8 sensor_status;         /* first failing sensor step, 0 if none */
+    uint8 sched_refused;        /* tasks run unscheduled, see schedStart() */
+} boot_stats;
 
 /**
  * @brief Virtual serial terminal.
  */
-class USBDataChannel {
+class USBDataChannel : public UVCCamera {
 public:
     USBDataChannel(void);
 
     void begin(void);
+    void poll(void);
+
+    /* true: frames come from submitFrame() instead of the sensor */
+    void useAppSource(bool app);
+
+    static const boot_stats* bootStats(void);
 
 protected:
+    static void bootStep(void);
+    static void streamTask(void);
+    static void controlTask(void);
+    static void scriptTask(void);
+
     static bool _hasBegun;
+    static uint8 _format;       /* committed format, 0 while not streaming */
 };
 
 #endif
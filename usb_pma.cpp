@@ -0,0 +1,48 @@
+/*
+ * PMA copy for the streaming endpoint, see usb_pma.h; the kernels are
+ * in usb_pma_copy.h
+ */
+
+#include "usb_pma.h"
+#include "usb_pma_copy.h"
+#include "usb_uvc.h"
+#include "dwt.h"
+#include "irq.h"
+#include "ramfunc.h"
+
+extern "C" {
+#include "usb_reg_map.h"
+}
+
+extern "C" RAMFUNC(RAMFUNC_PMA_WRITE, usb_pma_write)
+void usb_pma_write(const uint8 *buf, uint16 len, uint16 pma_offset) {
+    pmaCopy<USB_TX_EPSIZE>(buf, len, usb_pma_ptr(pma_offset));
+}
+
+/*
+ * Time one full packet through each path with the DWT cycle counter.
+ * Must only be called while the endpoint owning pma_offset is NAKing.
+ */
+extern "C" void usb_pma_measure(uint16 pma_offset, usb_pma_stats *stats) {
+    static uint32 scratch[USB_TX_EPSIZE / 4 + 1];
+    const uint8 *buf = (const uint8*)scratch;
+    uint32 start;
+    uint32 primask;
+
+    dwt_enable();
+    primask = irq_save();
+
+    start = dwt_cycles();
+    usb_copy_to_pma(buf, USB_TX_EPSIZE, pma_offset);
+    stats->generic_cycles = dwt_cycles() - start;
+
+    start = dwt_cycles();
+    usb_pma_write(buf, USB_TX_EPSIZE, pma_offset);
+    stats->aligned_cycles = dwt_cycles() - start;
+
+    start = dwt_cycles();
+    usb_pma_write(buf + 1, USB_TX_EPSIZE, pma_offset);
+    stats->unaligned_cycles = dwt_cycles() - start;
+
+    irq_restore(primask);
+}
@@ -0,0 +1,33 @@
+/*
+ * Packet memory (PMA) copy kernels for the streaming endpoint
+ *
+ * The F103 PMA is 16 bits wide and mapped at a 32-bit stride, so every
+ * halfword of a packet is one 32-bit store. usb_pma_write() unrolls the
+ * copy for full USB_TX_EPSIZE packets and picks a word-aligned or a
+ * byte-wise source path, instead of the per-halfword loop of
+ * usb_copy_to_pma().
+ */
+
+#ifndef _USB_PMA_H_
+#define _USB_PMA_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct usb_pma_stats {
+    uint32 generic_cycles;      /* usb_copy_to_pma(), one full packet */
+    uint32 aligned_cycles;      /* usb_pma_write(), word aligned source */
+    uint32 unaligned_cycles;    /* usb_pma_write(), odd source address */
+} usb_pma_stats;
+
+void usb_pma_write(const uint8 *buf, uint16 len, uint16 pma_offset);
+void usb_pma_measure(uint16 pma_offset, usb_pma_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
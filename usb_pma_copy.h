@@ -0,0 +1,80 @@
+/*
+ * PMA copy kernels, shared by usb_pma.cpp and the host benchmark
+ * tools/pma_bench.cpp
+ *
+ * Only plain stores through a volatile uint32 pointer, one per PMA
+ * halfword: the device passes usb_pma_ptr(), the host an array laid out
+ * the same way. Needs nothing beyond the libmaple integer types.
+ */
+
+#ifndef _USB_PMA_COPY_H_
+#define _USB_PMA_COPY_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <libmaple/libmaple_types.h>
+
+/*
+ * Unrolled copies of N source words, each word fills two PMA slots.
+ * The recursion is resolved at compile time, the aligned 64-byte kernel
+ * is 16 loads and 32 stores with no loop counter. The aligned kernel
+ * loads each word of the byte buffer through memcpy(), which GCC turns
+ * into one LDR without reading a uint8 object through a uint32 lvalue.
+ */
+template <uint16 N>
+struct PmaCopy {
+    static inline __attribute__((always_inline))
+    void aligned(const uint8 *src, volatile uint32 *dst) {
+        uint32 w;
+
+        memcpy(&w, src, sizeof(w));
+        dst[0] = w & 0xFFFF;
+        dst[1] = w >> 16;
+        PmaCopy<N - 1>::aligned(src + 4, dst + 2);
+    }
+
+    static inline __attribute__((always_inline))
+    void unaligned(const uint8 *src, volatile uint32 *dst) {
+        dst[0] = src[0] | (src[1] << 8);
+        dst[1] = src[2] | (src[3] << 8);
+        PmaCopy<N - 1>::unaligned(src + 4, dst + 2);
+    }
+};
+
+template <>
+struct PmaCopy<0> {
+    static inline void aligned(const uint8*, volatile uint32*) {}
+    static inline void unaligned(const uint8*, volatile uint32*) {}
+};
+
+/* tail copy for short packets, len in bytes */
+static inline __attribute__((always_inline))
+void pmaCopyTail(const uint8 *src, uint16 len, volatile uint32 *dst) {
+    uint16 n = len >> 1;
+
+    while (n--) {
+        *dst++ = src[0] | (src[1] << 8);
+        src += 2;
+    }
+    if (len & 1) {
+        *dst = *src;
+    }
+}
+
+/* One packet of up to SIZE bytes, SIZE a multiple of 4 */
+template <uint16 SIZE>
+static inline __attribute__((always_inline))
+void pmaCopy(const uint8 *buf, uint16 len, volatile uint32 *dst) {
+    if (len == SIZE) {
+        if (((uintptr_t)buf & 3) == 0) {
+            PmaCopy<SIZE / 4>::aligned(buf, dst);
+        } else {
+            PmaCopy<SIZE / 4>::unaligned(buf, dst);
+        }
+        return;
+    }
+    pmaCopyTail(buf, len, dst);
+}
+
+#endif
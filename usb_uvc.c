@@ -41,6 +41,13 @@
 
 #include "usb_uvc.h"
 #include "usb_uvcvideo.h"
+#include "uvc_stream.h"
+#include "uvc_trigger.h"
+#include "arducam.h"
+#include "test_pattern.h"
+#include "dwt.h"
+#include "irq.h"
+#include "trace.h"
 
 static void usbInit(void);
 static void usbReset(void);
@@ -52,6 +59,13 @@ static uint8* usbGetConfigDescriptor(uint16 length);
 static uint8* usbGetStringDescriptor(uint16 length);
 static void usbSetConfiguration(void);
 static void usbSetDeviceAddress(void);
+static void usbStatusIn(void);
+static void usbClearFeature(void);
+static void usbVendorRx(void);
+static void usbVendorTx(void);
+static uint8* usbControlData(uint16 length);
+static const struct uvc_control* usbFindControl(void);
+static void usbFixupStreamingControl(struct uvc_streaming_control *ctrl);
 
 /*
  * Descriptors
@@ -74,29 +88,15 @@ typedef struct {
     uvc_output_terminal_descriptor          UVC_Output_Unit;
     usb_descriptor_endpoint                 InterruptEndpoint;
     usb_descriptor_interface                UVC_Streaming_Interface;
-    uvc_input_header_descriptor             UVC_VS_Interface_Header;
-    uvc_format_uncompressed                 UVC_YUY2_format;
-    uvc_frame_uncompressed                  UVC_YUY2_320_240_Frame;
-    uvc_format_mjpeg                        UVC_MJPEG_Format;
-    uvc_frame_mjpeg                         UVC_MJPEG_1600_1200_Frame;
-    uvc_color_matching_descriptor           UVC_Color_Matching;
+    usb_uvc_vs_descriptors                  UVC_VS;
     usb_descriptor_endpoint                 DataInEndpoint;
+    usb_descriptor_interface                Vendor_Interface;
+    usb_descriptor_endpoint                 VendorOutEndpoint;
+    usb_descriptor_endpoint                 VendorInEndpoint;
 } __packed usb_descriptor_config;
 
 #define MAX_POWER (100 >> 1)
 
-#define VS_HEADER_SIZ (unsigned int)(UVC_DT_INPUT_HEADER_SIZE(2, 1) +\
-UVC_DT_FORMAT_UNCOMPRESSED_SIZE + \
-UVC_DT_FRAME_UNCOMPRESSED_SIZE(1)  +  \
-UVC_DT_FRAME_UNCOMPRESSED_SIZE(1)  +  \
-UVC_DT_FRAME_UNCOMPRESSED_SIZE(1)  +  \
-UVC_DT_FORMAT_MJPEG_SIZE +\
-UVC_DT_FRAME_MJPEG_SIZE(1) +\
-UVC_DT_FRAME_MJPEG_SIZE(1) +\
-UVC_DT_FRAME_MJPEG_SIZE(1) +\
-UVC_DT_COLOR_MATCHING_SIZE)
-
-
 #define VC_TERMINAL_SIZ (unsigned int) ( UVC_DT_HEADER_SIZE(1) +\
 UVC_DT_CAMERA_TERMINAL_SIZE(2) +\
 UVC_DT_PROCESSING_UNIT_SIZE(3) +\
@@ -105,13 +105,14 @@ UVC_DT_OUTPUT_TERMINAL_SIZE)
 
 #define USB_UVC_VCIF_NUM 0
 #define USB_UVC_VSIF_NUM 1
+#define USB_VENDOR_IF_NUM 2
 
 static const usb_descriptor_config usbDescriptor_Config = {
   .Config_Header = {
     .bLength                    = sizeof(usb_descriptor_config_header),
     .bDescriptorType            = USB_DESCRIPTOR_TYPE_CONFIGURATION,
     .wTotalLength               = sizeof(usb_descriptor_config),
-    .bNumInterfaces             = 0x02,
+    .bNumInterfaces             = 0x03,
     .bConfigurationValue        = 0x01,
     .iConfiguration             = 0x00,
     .bmAttributes               = (USB_CONFIG_ATTR_BUSPOWERED | USB_CONFIG_ATTR_SELF_POWERED),
@@ -144,7 +145,7 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bDescriptorSubType         = UVC_VC_HEADER,
     .bcdUVC                     = UVC_VERSION,
     .wTotalLength               = VC_TERMINAL_SIZ,
-    .dwClockFrequency           = 0x005B8D80,
+    .dwClockFrequency           = USB_UVC_CLOCK_FREQUENCY,
     .bInCollection              = 1,
     .baInterfaceNr              = 1,
   },
@@ -178,13 +179,13 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bLength                    = UVC_DT_EXTENSION_UNIT_SIZE(1, 3),
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = UVC_VC_EXTENSION_UNIT,
-    .bUnitID                    = 3,
-    .guidExtensionCode          = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
-    .bNumControls               = 0,
+    .bUnitID                    = USB_UVC_XU_ID,
+    .guidExtensionCode          = USB_UVC_XU_GUID,
+    .bNumControls               = 6,
     .bNrInPins                  = 1,
     .baSourceID                 = 1,
     .bControlSize               = 3,
-    .bmControls                 = {0x00, 0x00, 0x00},
+    .bmControls                 = {0x3F, 0x00, 0x00},
     .iExtension                 = 0,
   },
   .UVC_Output_Unit = {
@@ -203,7 +204,7 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bEndpointAddress           = (USB_DESCRIPTOR_ENDPOINT_IN | USB_MANAGEMENT_ENDP),
     .bmAttributes               = USB_EP_TYPE_INTERRUPT,
     .wMaxPacketSize             = USB_MANAGEMENT_EPSIZE,
-    .bInterval                  = 0xFF,
+    .bInterval                  = 0x10,
   },
   .UVC_Streaming_Interface = {
     .bLength                    = sizeof(usb_descriptor_interface),
@@ -216,26 +217,27 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bInterfaceProtocol         = PC_PROTOCOL_UNDEFINED,
     .iInterface                 = 1,
   },
-  .UVC_VS_Interface_Header = {
-    .bLength                    = UVC_DT_INPUT_HEADER_SIZE(2, 1),
+  .UVC_VS.UVC_VS_Interface_Header = {
+    .bLength                    = UVC_DT_INPUT_HEADER_SIZE(USB_UVC_FORMAT_COUNT, 1),
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = VS_INPUT_HEADER,
-    .bNumFormats                = 2,
-    .wTotalLength               = VS_HEADER_SIZ,
+    .bNumFormats                = USB_UVC_FORMAT_COUNT,
+    .wTotalLength               = USB_UVC_VS_TOTAL_SIZE,
     .bEndpointAddress           = (USB_DESCRIPTOR_ENDPOINT_IN | USB_TX_ENDP),
     .bmInfo                     = 0x00,
     .bTerminalLink              = 4,
     .bStillCaptureMethod        = 0x00,
-    .bTriggerSupport            = 0x00,
-    .bTriggerUsage              = 0x00,
+    /* the trigger input is reported as a button, see usb_uvc_button_event() */
+    .bTriggerSupport            = 0x01,
+    .bTriggerUsage              = 0x01,
     .bControlSize               = 1,
-    .bmaControls                = { 0x00, 0x00},
+    .bmaControls                = { 0x00, 0x00, 0x00, 0x00, 0x00},
   },
-  .UVC_YUY2_format = {
+  .UVC_VS.UVC_YUY2_format = {
     .bLength                    = UVC_DT_FORMAT_UNCOMPRESSED_SIZE,
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = VS_FORMAT_UNCOMPRESSED,
-    .bFormatIndex               = 1,
+    .bFormatIndex               = USB_UVC_FORMAT_YUY2,
     .bNumFrameDescriptors       = 1,
     .guidFormat                 = {0x59, 0x55, 0x59, 0x32, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71},
     .bBitsPerPixel              = 16,
@@ -245,7 +247,10 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bmInterfaceFlags           = 0x00,
     .bCopyProtect               = 0x00,
   },
-  .UVC_YUY2_320_240_Frame = {
+  /* The frame descriptors are fixed at enumeration. A region of
+   * interest changes dwMaxVideoFrameSize in the probe but not wWidth
+   * and wHeight here, see the README for the regions that keep them */
+  .UVC_VS.UVC_YUY2_320_240_Frame = {
     .bLength                    = UVC_DT_FRAME_UNCOMPRESSED_SIZE(1),
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = VS_FRAME_UNCOMPRESSED,
@@ -255,16 +260,16 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .wHeight                    = 240,
     .dwMinBitRate               = 0x01194000,
     .dwMaxBitRate               = 0x01194000,
-    .dwMaxVideoFrameBufferSize  = 0x500,
-    .dwDefaultFrameInterval     = 2000000,
+    .dwMaxVideoFrameBufferSize  = USB_UVC_YUY2_FRAME_SIZE,
+    .dwDefaultFrameInterval     = USB_UVC_FRAME_INTERVAL,
     .bFrameIntervalType         = 1,
-    .dwFrameInterval            = 2000000,
+    .dwFrameInterval            = USB_UVC_FRAME_INTERVAL,
   },
-  .UVC_MJPEG_Format = {
+  .UVC_VS.UVC_MJPEG_Format = {
     .bLength                    = UVC_DT_FORMAT_MJPEG_SIZE,
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = VS_FORMAT_MJPEG,
-    .bFormatIndex               = 2,
+    .bFormatIndex               = USB_UVC_FORMAT_MJPEG,
     .bNumFrameDescriptors       = 1,
     .bmFlags                    = 0x00,
     .bDefaultFrameIndex         = 1,
@@ -273,7 +278,7 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bmInterfaceFlags           = 0x00,
     .bCopyProtect               = 0x00,
   },
-  .UVC_MJPEG_1600_1200_Frame = {
+  .UVC_VS.UVC_MJPEG_1600_1200_Frame = {
     .bLength                    = UVC_DT_FRAME_MJPEG_SIZE(1),  
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = VS_FRAME_MJPEG,
@@ -283,12 +288,12 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .wHeight                    = 1200,
     .dwMinBitRate               = 4800000,
     .dwMaxBitRate               = 4800000,
-    .dwMaxVideoFrameBufferSize  = 0x500,
-    .dwDefaultFrameInterval     = 2000000,
+    .dwMaxVideoFrameBufferSize  = USB_UVC_MJPEG_FRAME_SIZE,
+    .dwDefaultFrameInterval     = USB_UVC_FRAME_INTERVAL,
     .bFrameIntervalType         = 1,
-    .dwFrameInterval            = 2000000,
+    .dwFrameInterval            = USB_UVC_FRAME_INTERVAL,
   },
-  .UVC_Color_Matching = {
+  .UVC_VS.UVC_Color_Matching = {
     .bLength                    = UVC_DT_COLOR_MATCHING_SIZE,
     .bDescriptorType            = CS_INTERFACE,
     .bDescriptorSubType         = UVC_VS_COLORFORMAT,
@@ -296,6 +301,94 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .bTransferCharacteristics   = 1,
     .bMatrixCoefficients        = 4,
   },
+  .UVC_VS.UVC_Rice_Format = {
+    .bLength                    = UVC_DT_FORMAT_FRAME_BASED_SIZE,
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = UVC_VS_FORMAT_FRAME_BASED,
+    .bFormatIndex               = USB_UVC_FORMAT_RICE,
+    .bNumFrameDescriptors       = 1,
+    .guidFormat                 = USB_UVC_RICE_GUID,
+    .bBitsPerPixel              = 16,
+    .bDefaultFrameIndex         = 1,
+    .bAspectRatioX              = 0x00,
+    .bAspectRatioY              = 0x00,
+    .bmInterfaceFlags           = 0x00,
+    .bCopyProtect               = 0x00,
+    .bVariableSize              = 1,
+  },
+  .UVC_VS.UVC_Rice_320_240_Frame = {
+    .bLength                    = UVC_DT_FRAME_FRAME_BASED_SIZE(1),
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = UVC_VS_FRAME_FRAME_BASED,
+    .bFrameIndex                = 1,
+    .bmCapabilities             = 0,
+    .wWidth                     = 320,
+    .wHeight                    = 240,
+    .dwMinBitRate               = 0x01194000 / 8,
+    .dwMaxBitRate               = 0x01194000,
+    .dwDefaultFrameInterval     = USB_UVC_FRAME_INTERVAL,
+    .bFrameIntervalType         = 1,
+    .dwBytesPerLine             = 0,
+    .dwFrameInterval            = USB_UVC_FRAME_INTERVAL,
+  },
+  .UVC_VS.UVC_M420_Format = {
+    .bLength                    = UVC_DT_FORMAT_UNCOMPRESSED_SIZE,
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = VS_FORMAT_UNCOMPRESSED,
+    .bFormatIndex               = USB_UVC_FORMAT_M420,
+    .bNumFrameDescriptors       = 1,
+    .guidFormat                 = USB_UVC_M420_GUID,
+    .bBitsPerPixel              = 12,
+    .bDefaultFrameIndex         = 1,
+    .bAspectRatioX              = 0x00,
+    .bAspectRatioY              = 0x00,
+    .bmInterfaceFlags           = 0x00,
+    .bCopyProtect               = 0x00,
+  },
+  .UVC_VS.UVC_M420_320_240_Frame = {
+    .bLength                    = UVC_DT_FRAME_UNCOMPRESSED_SIZE(1),
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = VS_FRAME_UNCOMPRESSED,
+    .bFrameIndex                = 1,
+    .bmCapabilities             = 0,
+    .wWidth                     = 320,
+    .wHeight                    = 240,
+    .dwMinBitRate               = 0x01194000 / 4 * 3,
+    .dwMaxBitRate               = 0x01194000 / 4 * 3,
+    .dwMaxVideoFrameBufferSize  = USB_UVC_M420_FRAME_SIZE,
+    .dwDefaultFrameInterval     = USB_UVC_FRAME_INTERVAL,
+    .bFrameIntervalType         = 1,
+    .dwFrameInterval            = USB_UVC_FRAME_INTERVAL,
+  },
+  .UVC_VS.UVC_Bayer_Format = {
+    .bLength                    = UVC_DT_FORMAT_UNCOMPRESSED_SIZE,
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = VS_FORMAT_UNCOMPRESSED,
+    .bFormatIndex               = USB_UVC_FORMAT_BAYER,
+    .bNumFrameDescriptors       = 1,
+    .guidFormat                 = USB_UVC_BAYER_GUID,
+    .bBitsPerPixel              = 8,
+    .bDefaultFrameIndex         = 1,
+    .bAspectRatioX              = 0x00,
+    .bAspectRatioY              = 0x00,
+    .bmInterfaceFlags           = 0x00,
+    .bCopyProtect               = 0x00,
+  },
+  .UVC_VS.UVC_Bayer_320_240_Frame = {
+    .bLength                    = UVC_DT_FRAME_UNCOMPRESSED_SIZE(1),
+    .bDescriptorType            = CS_INTERFACE,
+    .bDescriptorSubType         = VS_FRAME_UNCOMPRESSED,
+    .bFrameIndex                = 1,
+    .bmCapabilities             = 0,
+    .wWidth                     = 320,
+    .wHeight                    = 240,
+    .dwMinBitRate               = 0x01194000 / 2,
+    .dwMaxBitRate               = 0x01194000 / 2,
+    .dwMaxVideoFrameBufferSize  = USB_UVC_BAYER_FRAME_SIZE,
+    .dwDefaultFrameInterval     = USB_UVC_FRAME_INTERVAL,
+    .bFrameIntervalType         = 1,
+    .dwFrameInterval            = USB_UVC_FRAME_INTERVAL,
+  },
   .DataInEndpoint = {
     .bLength                    = sizeof(usb_descriptor_endpoint),
     .bDescriptorType            = USB_DESCRIPTOR_TYPE_ENDPOINT,
@@ -304,6 +397,33 @@ static const usb_descriptor_config usbDescriptor_Config = {
     .wMaxPacketSize             = USB_TX_EPSIZE,
     .bInterval                  = 0x00,
   },
+  .Vendor_Interface = {
+    .bLength                    = sizeof(usb_descriptor_interface),
+    .bDescriptorType            = USB_DESCRIPTOR_TYPE_INTERFACE,
+    .bInterfaceNumber           = USB_VENDOR_IF_NUM,
+    .bAlternateSetting          = 0,
+    .bNumEndpoints              = 2,
+    .bInterfaceClass            = 0xFF,
+    .bInterfaceSubClass         = 0x00,
+    .bInterfaceProtocol         = 0x00,
+    .iInterface                 = 0,
+  },
+  .VendorOutEndpoint = {
+    .bLength                    = sizeof(usb_descriptor_endpoint),
+    .bDescriptorType            = USB_DESCRIPTOR_TYPE_ENDPOINT,
+    .bEndpointAddress           = (USB_DESCRIPTOR_ENDPOINT_OUT | USB_RX_ENDP),
+    .bmAttributes               = USB_EP_TYPE_BULK,
+    .wMaxPacketSize             = USB_RX_EPSIZE,
+    .bInterval                  = 0x00,
+  },
+  .VendorInEndpoint = {
+    .bLength                    = sizeof(usb_descriptor_endpoint),
+    .bDescriptorType            = USB_DESCRIPTOR_TYPE_ENDPOINT,
+    .bEndpointAddress           = (USB_DESCRIPTOR_ENDPOINT_IN | USB_VENDOR_TX_ENDP),
+    .bmAttributes               = USB_EP_TYPE_BULK,
+    .wMaxPacketSize             = USB_VENDOR_TX_EPSIZE,
+    .bInterval                  = 0x00,
+  },
 };
 
 /*
@@ -365,15 +485,153 @@ static ONE_DESCRIPTOR String_Descriptor[N_STRING_DESCRIPTORS] = {
  * Etc.
  */
 
+/* VideoStreaming probe and commit state (UVC 1.1, 4.3.1.1) */
+static struct uvc_streaming_control probe_ctrl;
+static struct uvc_streaming_control commit_ctrl;
+static volatile uint8 commit_pending = 0;
+
+/* DWT cycles when the host first configured the device */
+static volatile uint32 configured_cycles;
+static volatile uint8 configured = 0;
+
+/* bStreamErrorCode of the last payload sent with UVC_STREAM_ERR */
+static uint8 stream_error = UVC_STREAM_ERROR_NONE;
+
+/* dwMaxVideoFrameSize per format, shrinks with the region of interest */
+static uint32 frame_size[USB_UVC_FORMAT_COUNT] = {
+    USB_UVC_YUY2_FRAME_SIZE,
+    USB_UVC_MJPEG_FRAME_SIZE,
+    USB_UVC_RICE_FRAME_SIZE,
+    USB_UVC_M420_FRAME_SIZE,
+    USB_UVC_BAYER_FRAME_SIZE,
+};
+
+/* extension unit region of interest, in UXGA sensor pixels */
+static usb_uvc_roi roi_cur = {0, 0, USB_UVC_ROI_FULL_WIDTH, USB_UVC_ROI_FULL_HEIGHT};
+static const usb_uvc_roi roi_min = {0, 0, USB_UVC_ROI_MIN_SIZE, USB_UVC_ROI_MIN_SIZE};
+static const usb_uvc_roi roi_max = {
+    USB_UVC_ROI_FULL_WIDTH - USB_UVC_ROI_MIN_SIZE,
+    USB_UVC_ROI_FULL_HEIGHT - USB_UVC_ROI_MIN_SIZE,
+    USB_UVC_ROI_FULL_WIDTH,
+    USB_UVC_ROI_FULL_HEIGHT,
+};
+static const usb_uvc_roi roi_def = {0, 0, USB_UVC_ROI_FULL_WIDTH, USB_UVC_ROI_FULL_HEIGHT};
+static const usb_uvc_roi roi_res = {4, 4, 4, 4};
+static volatile uint8 roi_pending = 0;
+
+/* vendor interface endpoint state */
+static volatile uint8 vendor_rx_ready = 0;
+static volatile uint8 vendor_tx_busy = 0;
+
+/* extension unit change detection threshold, in luma levels */
+static uint8 change_cur = UVC_STREAM_CHANGE_THRESHOLD;
+static const uint8 change_min = 0;
+static const uint8 change_max = 0xFF;
+static const uint8 change_def = UVC_STREAM_CHANGE_THRESHOLD;
+static const uint8 change_res = 1;
+
+/* extension unit statistics, replaced whole by usb_uvc_set_stats() */
+static usb_uvc_stats stats_cur;
+
+/* extension unit burst length, in frames per capture */
+static uint8 burst_cur = 1;
+static const uint8 burst_min = 1;
+static const uint8 burst_max = ARDUCAM_MAX_FRAMES;
+static const uint8 burst_def = 1;
+static const uint8 burst_res = 1;
+
+/* extension unit test pattern */
+static uint8 pattern_cur = UVC_STREAM_TEST_PATTERN;
+static const uint8 pattern_min = TEST_PATTERN_OFF;
+static const uint8 pattern_max = TEST_PATTERN_COUNT - 1;
+static const uint8 pattern_def = UVC_STREAM_TEST_PATTERN;
+static const uint8 pattern_res = 1;
+
+/* extension unit capture trigger */
+static usb_uvc_trigger trigger_cur = {UVC_TRIGGER_FREE, 0, 1};
+static const usb_uvc_trigger trigger_min = {UVC_TRIGGER_FREE, 0, 1};
+static const usb_uvc_trigger trigger_max = {UVC_TRIGGER_MODES - 1, USB_FNR_FN,
+                                            UVC_TRIGGER_PERIOD_MAX};
+static const usb_uvc_trigger trigger_def = {UVC_TRIGGER_FREE, 0, 1};
+static const usb_uvc_trigger trigger_res = {1, 1, 1};
+
+/* status interrupt endpoint, a button event and its release in flight */
+#define STATUS_IDLE             0
+#define STATUS_PRESS            1
+#define STATUS_RELEASE          2
+static volatile uint8 status_busy = STATUS_IDLE;
+
+static void usbProbeSet(void);
+static void usbCommitSet(void);
+static void usbRoiSet(void);
+static void usbChangeSet(void);
+static void usbBurstSet(void);
+static void usbPatternSet(void);
+static void usbTriggerSet(void);
+static void usbStatusTx(void);
+
+/*
+ * Class-specific controls (UVC 1.1, 4.2). GET_MIN, GET_MAX, GET_DEF and
+ * GET_RES answer with the current value where no separate one is given.
+ */
+typedef struct uvc_control {
+    uint8 intf;
+    uint8 entity;               /* unit or terminal ID, 0 for the interface */
+    uint8 cs;
+    uint8 info;                 /* UVC_CONTROL_CAP_* */
+    uint16 len;
+    void *cur;
+    const void *min;
+    const void *max;
+    const void *def;
+    const void *res;
+    void (*set)(void);          /* after SET_CUR, from the status stage */
+} uvc_control;
+
+#define CONTROL_GET_SET         (UVC_CONTROL_CAP_GET | UVC_CONTROL_CAP_SET)
+
+static const uvc_control controls[] = {
+    {USB_UVC_VSIF_NUM, 0, UVC_VS_PROBE_CONTROL, CONTROL_GET_SET,
+     sizeof(probe_ctrl), &probe_ctrl, NULL, NULL, NULL, NULL, usbProbeSet},
+    {USB_UVC_VSIF_NUM, 0, UVC_VS_COMMIT_CONTROL, CONTROL_GET_SET,
+     sizeof(commit_ctrl), &commit_ctrl, NULL, NULL, NULL, NULL, usbCommitSet},
+    {USB_UVC_VSIF_NUM, 0, UVC_VS_STREAM_ERROR_CODE_CONTROL, UVC_CONTROL_CAP_GET,
+     sizeof(stream_error), &stream_error, NULL, NULL, NULL, NULL, NULL},
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_ROI_CONTROL, CONTROL_GET_SET,
+     sizeof(roi_cur), &roi_cur, &roi_min, &roi_max, &roi_def, &roi_res, usbRoiSet},
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_CHANGE_CONTROL, CONTROL_GET_SET,
+     sizeof(change_cur), &change_cur, &change_min, &change_max, &change_def, &change_res,
+     usbChangeSet},
+    /* the value changes on its own, the host must not cache it */
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_STATS_CONTROL,
+     UVC_CONTROL_CAP_GET | UVC_CONTROL_CAP_AUTOUPDATE,
+     sizeof(stats_cur), &stats_cur, NULL, NULL, NULL, NULL, NULL},
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_BURST_CONTROL, CONTROL_GET_SET,
+     sizeof(burst_cur), &burst_cur, &burst_min, &burst_max, &burst_def, &burst_res,
+     usbBurstSet},
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_PATTERN_CONTROL, CONTROL_GET_SET,
+     sizeof(pattern_cur), &pattern_cur, &pattern_min, &pattern_max, &pattern_def,
+     &pattern_res, usbPatternSet},
+    {USB_UVC_VCIF_NUM, USB_UVC_XU_ID, USB_UVC_XU_TRIGGER_CONTROL, CONTROL_GET_SET,
+     sizeof(trigger_cur), &trigger_cur, &trigger_min, &trigger_max, &trigger_def,
+     &trigger_res, usbTriggerSet},
+};
+
+#define N_CONTROLS (sizeof(controls) / sizeof(controls[0]))
+
+/* the control request being handled on endpoint 0 */
+static const uvc_control *cur_control = NULL;
+static uint8 last_request = UVC_RC_UNDEFINED;
+
 /*
  * Endpoint callbacks
  */
 
 static void (*ep_int_in[7])(void) =
-    {NOP_Process,
-     NOP_Process,
-     NOP_Process,
+    {uvc_stream_tx,
+     usbStatusTx,
      NOP_Process,
+     usbVendorTx,
      NOP_Process,
      NOP_Process,
      NOP_Process};
@@ -381,7 +639,7 @@ static void (*ep_int_in[7])(void) =
 static void (*ep_int_out[7])(void) =
     {NOP_Process,
      NOP_Process,
-     NOP_Process,
+     usbVendorRx,
      NOP_Process,
      NOP_Process,
      NOP_Process,
@@ -394,7 +652,7 @@ static void (*ep_int_out[7])(void) =
  * functionality.
  */
 
-#define NUM_ENDPTS                0x04
+#define NUM_ENDPTS                0x05
 __weak DEVICE Device_Table = {
     .Total_Endpoint      = NUM_ENDPTS,
     .Total_Configuration = 1
@@ -404,7 +662,7 @@ __weak DEVICE Device_Table = {
 __weak DEVICE_PROP Device_Property = {
     .Init                        = usbInit,
     .Reset                       = usbReset,
-    .Process_Status_IN           = NOP_Process,
+    .Process_Status_IN           = usbStatusIn,
     .Process_Status_OUT          = NOP_Process,
     .Class_Data_Setup            = usbDataSetup,
     .Class_NoData_Setup          = usbNoDataSetup,
@@ -422,7 +680,7 @@ __weak USER_STANDARD_REQUESTS User_Standard_Requests = {
     .User_GetInterface       = NOP_Process,
     .User_SetInterface       = NOP_Process,
     .User_GetStatus          = NOP_Process,
-    .User_ClearFeature       = NOP_Process,
+    .User_ClearFeature       = usbClearFeature,
     .User_SetEndPointFeature = NOP_Process,
     .User_SetDeviceFeature   = NOP_Process,
     .User_SetDeviceAddress   = usbSetDeviceAddress
@@ -461,6 +719,9 @@ void usb_disable(gpio_dev *disc_dev, uint8 disc_bit) {
 static void usbInit(void) {
     pInformation->Current_Configuration = 0;
 
+    usbFixupStreamingControl(&probe_ctrl);
+    commit_ctrl = probe_ctrl;
+
     USB_BASE->CNTR = USB_CNTR_FRES;
 
     USBLIB->irq_mask = 0;
@@ -512,6 +773,15 @@ static void usbReset(void) {
     usb_set_ep_rx_count(USB_RX_ENDP, USB_RX_EPSIZE);
     usb_set_ep_rx_stat(USB_RX_ENDP, USB_EP_STAT_RX_VALID);
 
+    /* vendor replies go out on their own bulk IN */
+    usb_set_ep_type(USB_VENDOR_TX_ENDP, USB_EP_EP_TYPE_BULK);
+    usb_set_ep_tx_addr(USB_VENDOR_TX_ENDP, USB_VENDOR_TX_ADDR);
+    usb_set_ep_tx_stat(USB_VENDOR_TX_ENDP, USB_EP_STAT_TX_NAK);
+    usb_set_ep_rx_stat(USB_VENDOR_TX_ENDP, USB_EP_STAT_RX_DISABLED);
+    vendor_rx_ready = 0;
+    vendor_tx_busy = 0;
+    status_busy = STATUS_IDLE;
+
     /* set up data endpoint IN (TX)  */
     usb_set_ep_type(USB_TX_ENDP, USB_EP_EP_TYPE_BULK);
     usb_set_ep_tx_addr(USB_TX_ENDP, USB_TX_ADDR);
@@ -525,16 +795,42 @@ static void usbReset(void) {
 static RESULT usbDataSetup(uint8 request) {
     uint8* (*CopyRoutine)(uint16) = 0;
 
+    trace_event(TRACE_SETUP, request,
+                (uint16)((pInformation->USBwIndex1 << 8) | pInformation->USBwValue1));
+
     if (Type_Recipient == (CLASS_REQUEST | INTERFACE_RECIPIENT)) {
-        switch (request) {
-        default:
-            break;
+        cur_control = usbFindControl();
+
+        if (cur_control != NULL) {
+            switch (request) {
+            case UVC_SET_CUR:
+                if (cur_control->info & UVC_CONTROL_CAP_SET) {
+                    CopyRoutine = usbControlData;
+                }
+                break;
+            case UVC_GET_CUR:
+            case UVC_GET_MIN:
+            case UVC_GET_MAX:
+            case UVC_GET_DEF:
+            case UVC_GET_RES:
+                if (cur_control->info & UVC_CONTROL_CAP_GET) {
+                    CopyRoutine = usbControlData;
+                }
+                break;
+            case UVC_GET_INFO:
+            case UVC_GET_LEN:
+                CopyRoutine = usbControlData;
+                break;
+            default:
+                break;
+            }
         }
     }
 
     if (CopyRoutine == NULL) {
         return USB_UNSUPPORT;
     }
+    last_request = request;
 
     pInformation->Ctrl_Info.CopyData = CopyRoutine;
     pInformation->Ctrl_Info.Usb_wOffset = 0;
@@ -545,6 +841,9 @@ static RESULT usbDataSetup(uint8 request) {
 static RESULT usbNoDataSetup(uint8 request) {
     RESULT ret = USB_UNSUPPORT;
 
+    trace_event(TRACE_SETUP_NODATA, request,
+                (uint16)((pInformation->USBwIndex1 << 8) | pInformation->USBwValue1));
+
     if (Type_Recipient == (CLASS_REQUEST | INTERFACE_RECIPIENT)) {
         switch (request) {
             break;
@@ -557,7 +856,7 @@ static RESULT usbNoDataSetup(uint8 request) {
 static RESULT usbGetInterfaceSetting(uint8 interface, uint8 alt_setting) {
     if (alt_setting > 0) {
         return USB_UNSUPPORT;
-    } else if (interface > 1) {
+    } else if (interface > USB_VENDOR_IF_NUM) {
         return USB_UNSUPPORT;
     }
 
@@ -584,6 +883,19 @@ static uint8* usbGetStringDescriptor(uint16 length) {
 static void usbSetConfiguration(void) {
     if (pInformation->Current_Configuration != 0) {
         USBLIB->state = USB_CONFIGURED;
+        if (!configured) {
+            configured_cycles = dwt_cycles();
+            configured = 1;
+        }
+    }
+}
+
+/* The host clears a halt on the streaming endpoint after it lost track
+ * of the stream; whatever was in flight is stale */
+static void usbClearFeature(void) {
+    if (Type_Recipient == (STANDARD_REQUEST | ENDPOINT_RECIPIENT) &&
+        (pInformation->USBwIndex0 & 0x7F) == USB_TX_ENDP) {
+        uvc_stream_fault(UVC_STREAM_ERROR_DISCONTINUITY);
     }
 }
 
@@ -591,3 +903,344 @@ static void usbSetDeviceAddress(void) {
     USBLIB->state = USB_ADDRESSED;
 }
 
+/*
+ * Class-specific controls
+ */
+
+static const uvc_control* usbFindControl(void) {
+    uint8 i;
+
+    for (i = 0; i < N_CONTROLS; i++) {
+        if (controls[i].intf == pInformation->USBwIndex0 &&
+            controls[i].entity == pInformation->USBwIndex1 &&
+            controls[i].cs == pInformation->USBwValue1) {
+            return &controls[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8* usbControlBuffer(uint16 *size) {
+    const void *data;
+
+    *size = cur_control->len;
+    switch (last_request) {
+    case UVC_GET_INFO:
+        *size = sizeof(cur_control->info);
+        return (uint8*)&cur_control->info;
+    case UVC_GET_LEN:
+        *size = sizeof(cur_control->len);
+        return (uint8*)&cur_control->len;
+    case UVC_GET_MIN:
+        data = cur_control->min;
+        break;
+    case UVC_GET_MAX:
+        data = cur_control->max;
+        break;
+    case UVC_GET_DEF:
+        data = cur_control->def;
+        break;
+    case UVC_GET_RES:
+        data = cur_control->res;
+        break;
+    default:
+        data = NULL;
+        break;
+    }
+    return (uint8*)((data != NULL) ? data : cur_control->cur);
+}
+
+static uint8* usbControlData(uint16 length) {
+    uint16 size;
+    uint8 *data = usbControlBuffer(&size);
+
+    if (length == 0) {
+        uint16 wLength = pInformation->USBwLength;
+        pInformation->Ctrl_Info.Usb_wLength = (wLength < size) ? wLength : size;
+        return NULL;
+    }
+    return data + pInformation->Ctrl_Info.Usb_wOffset;
+}
+
+/* called once the status stage of a control write has completed */
+static void usbStatusIn(void) {
+    if (last_request != UVC_SET_CUR) {
+        return;
+    }
+    last_request = UVC_RC_UNDEFINED;
+
+    if (cur_control != NULL && cur_control->set != NULL) {
+        cur_control->set();
+    }
+}
+
+/*
+ * VideoStreaming probe/commit
+ */
+
+static void usbFixupStreamingControl(struct uvc_streaming_control *ctrl) {
+    if (ctrl->bFormatIndex < 1 || ctrl->bFormatIndex > USB_UVC_FORMAT_COUNT) {
+        ctrl->bFormatIndex = USB_UVC_FORMAT_YUY2;
+    }
+    ctrl->bFrameIndex = 1;
+    ctrl->dwFrameInterval = USB_UVC_FRAME_INTERVAL;
+    ctrl->dwMaxVideoFrameSize = frame_size[ctrl->bFormatIndex - 1];
+    /* every packet is a payload of its own, with its own header */
+    ctrl->dwMaxPayloadTransferSize = USB_TX_EPSIZE;
+    ctrl->dwClockFrequency = USB_UVC_CLOCK_FREQUENCY;
+}
+
+static void usbProbeSet(void) {
+    usbFixupStreamingControl(&probe_ctrl);
+}
+
+static void usbCommitSet(void) {
+    usbFixupStreamingControl(&commit_ctrl);
+    commit_pending = 1;
+}
+
+/* Returns 1 and the committed streaming parameters once per commit. The
+ * sensor is reprogrammed from the main loop, not from the USB interrupt. */
+int usb_uvc_get_commit(struct uvc_streaming_control *ctrl) {
+    uint32 primask;
+
+    if (!commit_pending) {
+        return 0;
+    }
+    primask = irq_save();
+    *ctrl = commit_ctrl;
+    commit_pending = 0;
+    irq_restore(primask);
+    return 1;
+}
+
+/* A commit is waiting for usb_uvc_get_commit() */
+int usb_uvc_commit_pending(void) {
+    return commit_pending;
+}
+
+/* bFormatIndex of the commit waiting for usb_uvc_get_commit(), 0 if none */
+uint8 usb_uvc_commit_format(void) {
+    return commit_pending ? commit_ctrl.bFormatIndex : 0;
+}
+
+/* Returns 1 and the DWT cycle count of the first SET_CONFIGURATION once
+ * the host has configured the device */
+int usb_uvc_configured(uint32 *cycles) {
+    if (!configured) {
+        return 0;
+    }
+    *cycles = configured_cycles;
+    return 1;
+}
+
+void usb_uvc_set_stream_error(uint8 error) {
+    stream_error = error;
+}
+
+/* New dwMaxVideoFrameSize for a format, reported from the next probe on
+ * and in the current probe/commit state when it uses that format. */
+void usb_uvc_set_frame_size(uint8 format, uint32 size) {
+    uint32 primask;
+
+    if (format < 1 || format > USB_UVC_FORMAT_COUNT) {
+        return;
+    }
+    primask = irq_save();
+    frame_size[format - 1] = size;
+    if (probe_ctrl.bFormatIndex == format) {
+        probe_ctrl.dwMaxVideoFrameSize = size;
+    }
+    if (commit_ctrl.bFormatIndex == format) {
+        commit_ctrl.dwMaxVideoFrameSize = size;
+    }
+    irq_restore(primask);
+}
+
+/*
+ * Extension unit region of interest
+ */
+
+static void usbRoiSet(void) {
+    usb_uvc_roi *roi = &roi_cur;
+
+    if (roi->wWidth < USB_UVC_ROI_MIN_SIZE) {
+        roi->wWidth = USB_UVC_ROI_MIN_SIZE;
+    }
+    if (roi->wHeight < USB_UVC_ROI_MIN_SIZE) {
+        roi->wHeight = USB_UVC_ROI_MIN_SIZE;
+    }
+    if (roi->wWidth > USB_UVC_ROI_FULL_WIDTH) {
+        roi->wWidth = USB_UVC_ROI_FULL_WIDTH;
+    }
+    if (roi->wHeight > USB_UVC_ROI_FULL_HEIGHT) {
+        roi->wHeight = USB_UVC_ROI_FULL_HEIGHT;
+    }
+    if (roi->wX > USB_UVC_ROI_FULL_WIDTH - roi->wWidth) {
+        roi->wX = USB_UVC_ROI_FULL_WIDTH - roi->wWidth;
+    }
+    if (roi->wY > USB_UVC_ROI_FULL_HEIGHT - roi->wHeight) {
+        roi->wY = USB_UVC_ROI_FULL_HEIGHT - roi->wHeight;
+    }
+    roi_pending = 1;
+}
+
+/* Returns 1 and the region once after the host has changed it */
+int usb_uvc_get_roi(usb_uvc_roi *roi) {
+    uint32 primask;
+
+    if (!roi_pending) {
+        return 0;
+    }
+    primask = irq_save();
+    *roi = roi_cur;
+    roi_pending = 0;
+    irq_restore(primask);
+    return 1;
+}
+
+static void usbChangeSet(void) {
+    uvc_stream_set_threshold(change_cur);
+}
+
+static void usbBurstSet(void) {
+    if (burst_cur < burst_min) {
+        burst_cur = burst_min;
+    }
+    if (burst_cur > burst_max) {
+        burst_cur = burst_max;
+    }
+    uvc_stream_set_burst(burst_cur);
+}
+
+static void usbPatternSet(void) {
+    if (pattern_cur > pattern_max) {
+        pattern_cur = pattern_max;
+    }
+    uvc_stream_set_pattern(pattern_cur);
+}
+
+/* uvc_trigger_set() clamps, GET_CUR reads back what it took */
+static void usbTriggerSet(void) {
+    uint8 mode;
+    uint16 frame;
+    uint16 period;
+
+    uvc_trigger_set(trigger_cur.bMode, trigger_cur.wFrame, trigger_cur.wPeriod);
+    uvc_trigger_get(&mode, &frame, &period);
+    trigger_cur.bMode = mode;
+    trigger_cur.wFrame = frame;
+    trigger_cur.wPeriod = period;
+}
+
+/* The value fits one control packet, a GET_CUR sees either the old or
+ * the new set */
+void usb_uvc_set_stats(const usb_uvc_stats *stats) {
+    uint32 primask;
+
+    primask = irq_save();
+    stats_cur = *stats;
+    irq_restore(primask);
+}
+
+/*
+ * Correct-transfer interrupts of all endpoints off or back on, for the
+ * stream's polled refill. The usb_lib dispatcher checks irq_mask as
+ * well, so an SOF or reset interrupt in between leaves them alone too.
+ * A transfer that completed meanwhile is dispatched once they are on.
+ */
+void usb_uvc_set_ctr_irq(uint8 on) {
+    uint32 primask;
+
+    primask = irq_save();
+    if (on) {
+        USBLIB->irq_mask |= USB_CNTR_CTRM;
+    } else {
+        USBLIB->irq_mask &= ~USB_CNTR_CTRM;
+    }
+    USB_BASE->CNTR = USBLIB->irq_mask;
+    irq_restore(primask);
+}
+
+/*
+ * Vendor interface, bulk OUT requests and bulk IN replies
+ *
+ * The OUT endpoint NAKs from the moment a packet arrives until the main
+ * loop has taken it, so the host is paced by the register writes.
+ */
+
+static void usbVendorRx(void) {
+    trace_event(TRACE_EP_OUT, USB_RX_ENDP, 0);
+    vendor_rx_ready = 1;
+}
+
+static void usbVendorTx(void) {
+    trace_event(TRACE_EP_IN, USB_VENDOR_TX_ENDP, 0);
+    vendor_tx_busy = 0;
+}
+
+/*
+ * Status interrupt endpoint: a VideoStreaming button press and its
+ * release (UVC 1.1 2.4.2.2) for every hardware trigger, which uvcvideo
+ * reports as KEY_CAMERA. One event is in flight at a time, a trigger
+ * that comes before the host has collected both halves goes unreported.
+ */
+static void usbStatusWrite(uint8 value) {
+    uint8 pkt[4] = {UVC_STATUS_TYPE_STREAMING, USB_UVC_VSIF_NUM, 0x00, value};
+
+    usb_copy_to_pma(pkt, sizeof(pkt), USB_MANAGEMENT_ADDR);
+    usb_set_ep_tx_count(USB_MANAGEMENT_ENDP, sizeof(pkt));
+    usb_set_ep_tx_stat(USB_MANAGEMENT_ENDP, USB_EP_STAT_TX_VALID);
+}
+
+static void usbStatusTx(void) {
+    trace_event(TRACE_EP_IN, USB_MANAGEMENT_ENDP, 0);
+    if (status_busy == STATUS_PRESS) {
+        status_busy = STATUS_RELEASE;
+        usbStatusWrite(0);
+    } else {
+        status_busy = STATUS_IDLE;
+    }
+}
+
+/* Queues a button press, returns -1 while the last one is in flight */
+int usb_uvc_button_event(void) {
+    int ret = -1;
+    uint32 primask;
+
+    primask = irq_save();
+    if (configured && status_busy == STATUS_IDLE) {
+        status_busy = STATUS_PRESS;
+        usbStatusWrite(1);
+        ret = 0;
+    }
+    irq_restore(primask);
+    return ret;
+}
+
+/* Copies the next OUT packet into buf, returns its length or -1 when
+ * none has arrived. buf must hold USB_RX_EPSIZE bytes. */
+int usb_uvc_vendor_read(uint8 *buf) {
+    uint16 len;
+
+    if (!vendor_rx_ready) {
+        return -1;
+    }
+    len = usb_get_ep_rx_count(USB_RX_ENDP);
+    usb_copy_from_pma(buf, len, USB_RX_ADDR);
+    vendor_rx_ready = 0;
+    usb_set_ep_rx_stat(USB_RX_ENDP, USB_EP_STAT_RX_VALID);
+    return len;
+}
+
+/* Queues one IN packet, returns -1 while the previous one is pending */
+int usb_uvc_vendor_write(const uint8 *buf, uint16 len) {
+    if (vendor_tx_busy || len > USB_VENDOR_TX_EPSIZE) {
+        return -1;
+    }
+    vendor_tx_busy = 1;
+    usb_copy_to_pma(buf, len, USB_VENDOR_TX_ADDR);
+    usb_set_ep_tx_count(USB_VENDOR_TX_ENDP, len);
+    usb_set_ep_tx_stat(USB_VENDOR_TX_ENDP, USB_EP_STAT_TX_VALID);
+    return 0;
+}
@@ -34,6 +34,10 @@
 #include <libmaple/usb.h>
 
 #include "uvc.h"
+#include "usb_uvcvideo.h"
+#include "usb_uvc_desc.h"
+#include "yuy2_rice.h"
+#include "yuv420.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +81,108 @@ typedef struct usb_descriptor_interface_association {
 #define USB_RX_ADDR              0x110
 #define USB_RX_EPSIZE            0x40
 
+/* vendor interface replies, USB_RX_ENDP carries the requests */
+#define USB_VENDOR_TX_ENDP       4
+#define USB_VENDOR_TX_ADDR       0x150
+#define USB_VENDOR_TX_EPSIZE     0x40
+
+/*
+ * Frame sizes and GUIDs of the streaming formats, the USB_UVC_FORMAT_*
+ * indexes are in usb_uvc_desc.h
+ */
+
+#define USB_UVC_YUY2_FRAME_SIZE  (320 * 240 * 2)
+/* the ArduCAM 2MP FIFO is 384 kB, a JPEG frame never exceeds it */
+#define USB_UVC_MJPEG_FRAME_SIZE 0x60000
+#define USB_UVC_RICE_FRAME_SIZE  YUY2_RICE_FRAME_MAX(320, 240)
+#define USB_UVC_M420_FRAME_SIZE  YUV420_FRAME_SIZE(320, 240)
+#define USB_UVC_BAYER_FRAME_SIZE (320 * 240)
+
+/* {31435259-0000-0010-8000-00aa00389b71}, FourCC YRC1 */
+#define USB_UVC_RICE_GUID                                       \
+    { 'Y', 'R', 'C', '1', 0x00, 0x00, 0x10, 0x00,               \
+      0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 }
+
+/* {3032344d-0000-0010-8000-00aa00389b71}, FourCC M420 */
+#define USB_UVC_M420_GUID                                       \
+    { 'M', '4', '2', '0', 0x00, 0x00, 0x10, 0x00,               \
+      0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 }
+
+/* {31384142-0000-0010-8000-00aa00389b71}, FourCC BA81 (BGGR 8 bit) */
+#define USB_UVC_BAYER_GUID                                      \
+    { 'B', 'A', '8', '1', 0x00, 0x00, 0x10, 0x00,               \
+      0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 }
+
+#define USB_UVC_FRAME_INTERVAL   2000000
+#define USB_UVC_CLOCK_FREQUENCY  6000000
+
+/*
+ * Extension unit
+ */
+
+#define USB_UVC_XU_ID            3
+/* {6a1e3c52-2f0d-4b7e-9d31-a8c0f2b4e617} */
+#define USB_UVC_XU_GUID                                         \
+    { 0x52, 0x3c, 0x1e, 0x6a, 0x0d, 0x2f, 0x7e, 0x4b,           \
+      0x9d, 0x31, 0xa8, 0xc0, 0xf2, 0xb4, 0xe6, 0x17 }
+
+/* region of interest, in pixels of the full 1600x1200 sensor array */
+#define USB_UVC_XU_ROI_CONTROL   1
+
+#define USB_UVC_ROI_FULL_WIDTH   1600
+#define USB_UVC_ROI_FULL_HEIGHT  1200
+#define USB_UVC_ROI_MIN_SIZE     64
+
+/* skip frames whose luma changed by no more than this, 0 sends all */
+#define USB_UVC_XU_CHANGE_CONTROL 2
+
+/* exposure and white balance statistics of the latest frame, GET only */
+#define USB_UVC_XU_STATS_CONTROL 3
+
+/* frames taken back to back by every capture, 1 to ARDUCAM_MAX_FRAMES */
+#define USB_UVC_XU_BURST_CONTROL 4
+
+/* TEST_PATTERN_* streamed in place of the sensor, 0 for the sensor */
+#define USB_UVC_XU_PATTERN_CONTROL 5
+
+/* capture trigger, usb_uvc_trigger, see uvc_trigger.h */
+#define USB_UVC_XU_TRIGGER_CONTROL 6
+
+/* usb_uvc_stats.bSource */
+#define USB_UVC_STATS_NONE       0
+#define USB_UVC_STATS_PIXELS     1      /* measured on the YUY2 payload */
+#define USB_UVC_STATS_SENSOR     2      /* read from the sensor AEC registers */
+
+#define USB_UVC_STATS_BINS       16
+#define USB_UVC_STATS_ZONES      16
+
+typedef struct usb_uvc_roi {
+    uint16 wX;
+    uint16 wY;
+    uint16 wWidth;
+    uint16 wHeight;
+} __packed usb_uvc_roi;
+
+typedef struct usb_uvc_trigger {
+    uint8 bMode;                /* UVC_TRIGGER_* */
+    uint16 wFrame;              /* SOF: first USB frame number to capture on */
+    uint16 wPeriod;             /* SOF: USB frames from one capture to the next */
+} __packed usb_uvc_trigger;
+
+/* fields marked pixels or sensor are 0 for the other source */
+typedef struct usb_uvc_stats {
+    uint32 dwFrame;             /* counts up with every new set */
+    uint8 bSource;
+    uint8 bYMean;
+    uint8 bUMean;               /* pixels, 128 is neutral */
+    uint8 bVMean;               /* pixels */
+    uint16 wExposure;           /* sensor, AEC in lines */
+    uint8 bGain;                /* sensor, raw GAIN register */
+    uint8 bZoneMean[USB_UVC_STATS_ZONES];       /* pixels, 4x4 luma row by row */
+    uint16 wHistogram[USB_UVC_STATS_BINS];      /* pixels, luma bins of 16 levels,
+                                                 * share of 65535 */
+} __packed usb_uvc_stats;
+
 #ifndef __cplusplus
 #define USB_DECLARE_DEV_DESC(vid, pid)                          \
   {                                                             \
@@ -105,6 +211,20 @@ typedef struct usb_descriptor_interface_association {
 void usb_enable(gpio_dev*, uint8);
 void usb_disable(gpio_dev*, uint8);
 
+int usb_uvc_get_commit(struct uvc_streaming_control *ctrl);
+int usb_uvc_commit_pending(void);
+uint8 usb_uvc_commit_format(void);
+int usb_uvc_configured(uint32 *cycles);
+void usb_uvc_set_frame_size(uint8 format, uint32 size);
+void usb_uvc_set_stream_error(uint8 error);
+int usb_uvc_get_roi(usb_uvc_roi *roi);
+void usb_uvc_set_stats(const usb_uvc_stats *stats);
+
+int usb_uvc_vendor_read(uint8 *buf);
+int usb_uvc_vendor_write(const uint8 *buf, uint16 len);
+int usb_uvc_button_event(void);
+void usb_uvc_set_ctr_irq(uint8 on);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,79 @@
+/*
+ * Streaming formats and the class-specific video streaming descriptors
+ *
+ * The input header announces bNumFormats and wTotalLength, one
+ * bmaControls entry per format, then the format, frame and colour
+ * matching descriptors follow. The checks below tie the structures to
+ * the sizes the header announces. This file needs nothing of libmaple
+ * beyond its integer types, so tools/uvc_desc_test.c compiles the same
+ * checks on the host.
+ */
+
+#ifndef _USB_UVC_DESC_H_
+#define _USB_UVC_DESC_H_
+
+#include <libmaple/libmaple_types.h>
+
+#include "usb_uvcvideo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming formats, bFormatIndex in the probe/commit controls
+ */
+
+#define USB_UVC_FORMAT_YUY2      1
+#define USB_UVC_FORMAT_MJPEG     2
+/* YUY2 through the lossless line coder of yuy2_rice.h, frame based */
+#define USB_UVC_FORMAT_RICE      3
+/* YUY2 line pairs repacked to M420 by yuv420.h, 12 bits per pixel */
+#define USB_UVC_FORMAT_M420      4
+/* the sensor's raw Bayer samples, 8 bits per pixel, BGGR */
+#define USB_UVC_FORMAT_BAYER     5
+#define USB_UVC_FORMAT_COUNT     5
+
+/* what follows the streaming interface descriptor, in the order sent */
+typedef struct usb_uvc_vs_descriptors {
+    uvc_input_header_descriptor             UVC_VS_Interface_Header;
+    uvc_format_uncompressed                 UVC_YUY2_format;
+    uvc_frame_uncompressed                  UVC_YUY2_320_240_Frame;
+    uvc_format_mjpeg                        UVC_MJPEG_Format;
+    uvc_frame_mjpeg                         UVC_MJPEG_1600_1200_Frame;
+    uvc_color_matching_descriptor           UVC_Color_Matching;
+    uvc_format_frame_based                  UVC_Rice_Format;
+    uvc_frame_frame_based                   UVC_Rice_320_240_Frame;
+    uvc_format_uncompressed                 UVC_M420_Format;
+    uvc_frame_uncompressed                  UVC_M420_320_240_Frame;
+    uvc_format_uncompressed                 UVC_Bayer_Format;
+    uvc_frame_uncompressed                  UVC_Bayer_320_240_Frame;
+} __packed usb_uvc_vs_descriptors;
+
+/* wTotalLength of the input header */
+#define USB_UVC_VS_TOTAL_SIZE (unsigned int)(UVC_DT_INPUT_HEADER_SIZE(USB_UVC_FORMAT_COUNT, 1) +\
+UVC_DT_FORMAT_UNCOMPRESSED_SIZE + \
+UVC_DT_FRAME_UNCOMPRESSED_SIZE(1)  +  \
+UVC_DT_FORMAT_MJPEG_SIZE +\
+UVC_DT_FRAME_MJPEG_SIZE(1) +\
+UVC_DT_COLOR_MATCHING_SIZE +\
+UVC_DT_FORMAT_FRAME_BASED_SIZE +\
+UVC_DT_FRAME_FRAME_BASED_SIZE(1) +\
+UVC_DT_FORMAT_UNCOMPRESSED_SIZE + \
+UVC_DT_FRAME_UNCOMPRESSED_SIZE(1) +\
+UVC_DT_FORMAT_UNCOMPRESSED_SIZE + \
+UVC_DT_FRAME_UNCOMPRESSED_SIZE(1))
+
+/* the structures are what wTotalLength says, with one bmaControls entry
+ * per format; a negative array size stops any compiler that includes
+ * this file */
+typedef char usb_uvc_vs_size_check[
+    (sizeof(usb_uvc_vs_descriptors) == USB_UVC_VS_TOTAL_SIZE &&
+     sizeof(uvc_input_header_descriptor) ==
+     UVC_DT_INPUT_HEADER_SIZE(USB_UVC_FORMAT_COUNT, 1)) ? 1 : -1];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
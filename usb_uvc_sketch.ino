@@ -1,17 +1,222 @@
 #include "usb_datachannel.h"
+#include "ov2640.h"
+#include "arducam.h"
+#include "sccb.h"
+#include "usb_uvc.h"
+#include "usb_pma.h"
+#include "mem_pool.h"
+#include "uvc_stream.h"
+#include "uvc_trigger.h"
+#include "sched.h"
+
+USBDataChannel usbdevice;
+bool txPolled = UVC_STREAM_TX_POLLED;
 
 void setup() {
   // put your setup code here, to run once:
-  delay(100);
   Serial.begin(115200);
-  delay(100);
   Serial.println("setup");
 
-  USBDataChannel usbdevice;
+  // the sensor comes up from loop() while the host enumerates, see 'b'
   usbdevice.begin();
+
+  // the streaming endpoint is NAKing until the host commits a format
+  usb_pma_stats pma;
+  usb_pma_measure(USB_TX_ADDR, &pma);
+  Serial.print("pma cycles/packet generic: ");
+  Serial.print(pma.generic_cycles);
+  Serial.print(" aligned: ");
+  Serial.print(pma.aligned_cycles);
+  Serial.print(" unaligned: ");
+  Serial.println(pma.unaligned_cycles);
+
+  // everything the pipeline needs is allocated by now
+  if (mem_seal() != 0)
+    Serial.println("less than MEM_STACK_SIZE left for the stack");
 }
 
 void loop() {
   // put your main code here, to run repeatedly:
+  usbdevice.poll();
+
+  if (Serial.available()) {
+    switch (Serial.read()) {
+    case 'b':
+      printBootReport();
+      break;
+    case 'm':
+      printMemReport();
+      break;
+    case 's':
+      printStreamStats();
+      break;
+    case 't':
+      printTaskStats();
+      break;
+    case 'f':
+      // same path as a halt cleared by the host
+      uvc_stream_fault(UVC_STREAM_ERROR_DISCONTINUITY);
+      break;
+    case 'p':
+      txPolled = !txPolled;
+      uvc_stream_set_polled(txPolled);
+      Serial.println(txPolled ? "polled refill" : "interrupt refill");
+      break;
+    }
+  }
+}
+
+void printBootReport() {
+  const boot_stats *boot = USBDataChannel::bootStats();
+  const sccb_stats *sccb = sccb_get_stats();
+  const arducam_spi_stats *spi = arducam_spi_get_stats();
+  Serial.print("usb on us: ");
+  Serial.print(boot->usb_us);
+  Serial.print(" configured: ");
+  Serial.println(boot->configured_us);
+  Serial.print("fifo us: ");
+  Serial.print(boot->fifo_us);
+  Serial.print(" status: ");
+  Serial.println(boot->fifo_status);
+  Serial.print("sensor ready us: ");
+  Serial.print(boot->sensor_us);
+  Serial.print(" status: ");
+  Serial.print(boot->sensor_status);
+  Serial.print(" init us: ");
+  Serial.println(ov2640_init_us());
+  Serial.print("spi calibrated us: ");
+  Serial.print(boot->spi_us);
+  Serial.print(" clock hz: ");
+  Serial.print(spi->hz);
+  Serial.print(" calibrated: ");
+  Serial.print(arducam_spi_hz(spi->calibrated));
+  Serial.print(" first failing: ");
+  Serial.print(spi->failed < ARDUCAM_SPI_STEPS ? arducam_spi_hz(spi->failed) : 0);
+  Serial.print(" fallbacks: ");
+  Serial.print(spi->fallbacks);
+  Serial.print(" us per kb: ");
+  Serial.println(spi->kb_us);
+  Serial.print("first commit us: ");
+  Serial.print(boot->commit_us);
+  Serial.print(" first frame us: ");
+  Serial.println(boot->first_frame_us);
+  Serial.print("sccb writes: ");
+  Serial.print(sccb->writes);
+  Serial.print(" bank skips: ");
+  Serial.print(sccb->bank_skips);
+  Serial.print(" us per init write: ");
+  Serial.println(boot->sccb_write_us);
+  Serial.print("tasks refused: ");
+  Serial.println(boot->sched_refused);
+}
+
+void printStreamStats() {
+  const uvc_stream_stats *stats = uvc_stream_get_stats();
+  Serial.print("frames: ");
+  Serial.print(stats->frames);
+  Serial.print(" packets: ");
+  Serial.print(stats->packets);
+  Serial.print(" ring empty: ");
+  Serial.println(stats->ring_empty);
+  Serial.print("skipped: ");
+  Serial.print(stats->skipped);
+  Serial.print(" last change: ");
+  Serial.print(stats->change);
+  Serial.print(" scan us: ");
+  Serial.println(stats->scan_us);
+  Serial.print("faults: ");
+  Serial.print(stats->faults);
+  Serial.print(" recovery us: ");
+  Serial.print(stats->recovery_us);
+  Serial.print(" max: ");
+  Serial.println(stats->recovery_us_max);
+  Serial.print("refill cycles: ");
+  Serial.print(stats->send_cycles);
+  Serial.print(" max: ");
+  Serial.println(stats->send_cycles_max);
+  Serial.print("drain cycles: ");
+  Serial.print(stats->drain_cycles);
+  Serial.print(" lossless code cycles/line: ");
+  Serial.println(stats->code_cycles);
+  Serial.print("jpeg marker errors: ");
+  Serial.print(stats->jpeg_errors);
+  Serial.print(" spi clock hz: ");
+  Serial.print(arducam_spi_get_stats()->hz);
+  Serial.print(" fallbacks: ");
+  Serial.println(arducam_spi_get_stats()->fallbacks);
+  Serial.print("cached first frames: ");
+  Serial.print(stats->cache_hits);
+  Serial.print(" first frame us: ");
+  Serial.print(stats->first_frame_us);
+  Serial.print(" without vsync stamp: ");
+  Serial.println(stats->vsync_missed);
+  Serial.print("triggers: ");
+  Serial.print(uvc_trigger_get_stats()->triggers);
+  Serial.print(" missed: ");
+  Serial.print(uvc_trigger_get_stats()->missed);
+  Serial.print(" late: ");
+  Serial.print(uvc_trigger_get_stats()->late);
+  Serial.print(" delay us: ");
+  Serial.print(uvc_trigger_get_stats()->delay_us);
+  Serial.print(" max: ");
+  Serial.println(uvc_trigger_get_stats()->delay_us_max);
+  printTxRate("interrupt", stats->tx_packets[UVC_STREAM_TX_IRQ], stats->tx_us[UVC_STREAM_TX_IRQ]);
+  printTxRate("polled", stats->tx_packets[UVC_STREAM_TX_POLL], stats->tx_us[UVC_STREAM_TX_POLL]);
+}
+
+// packets per 1 ms USB frame while whole pattern frames were sent
+void printTxRate(const char *name, uint32 packets, uint32 us) {
+  Serial.print(name);
+  Serial.print(" refill packets: ");
+  Serial.print(packets);
+  Serial.print(" per usb frame: ");
+  Serial.println(us ? packets * 1000.0 / us : 0.0, 2);
+}
+
+void printTaskStats() {
+  for (uint8 i = 0; i < sched_num_tasks(); i++) {
+    const sched_task *task = sched_get_task(i);
+    Serial.print(task->name);
+    Serial.print(": budget us ");
+    Serial.print(task->budget_us);
+    Serial.print(" deadline us ");
+    Serial.print(task->deadline_us);
+    Serial.print(" runs ");
+    Serial.print(task->runs);
+    Serial.print(" overruns ");
+    Serial.print(task->overruns);
+    Serial.print(" misses ");
+    Serial.print(task->misses);
+    Serial.print(" exempt ");
+    Serial.print(task->exempt);
+    Serial.print(" max run us ");
+    Serial.print(task->max_run_us);
+    Serial.print(" max gap us ");
+    Serial.println(task->max_gap_us);
+  }
+}
 
+void printMemReport() {
+  for (uint8 i = 0; i < MEM_NUM_POOLS; i++) {
+    const mem_pool *pool = mem_pool_get(i);
+    Serial.print(pool->name);
+    Serial.print(": ");
+    Serial.print(pool->used);
+    Serial.print("/");
+    Serial.print(pool->count);
+    Serial.print(" x ");
+    Serial.print(pool->block_size);
+    Serial.print(" high water ");
+    Serial.print(pool->high_water);
+    Serial.print(" failures ");
+    Serial.print(pool->failures);
+    Serial.print(" bad frees ");
+    Serial.println(pool->bad_frees);
+  }
+  Serial.print("heap growth since setup: ");
+  Serial.print(mem_heap_growth());
+  Serial.print(" stack depth: ");
+  Serial.print(mem_stack_depth());
+  Serial.print("/");
+  Serial.println(MEM_STACK_SIZE);
 }
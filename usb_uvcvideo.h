@@ -371,7 +371,7 @@ typedef struct uvc_input_header_descriptor {
   __u8  bTriggerSupport;
   __u8  bTriggerUsage;
   __u8  bControlSize;
-  __u8  bmaControls[2];
+  __u8  bmaControls[5];
 } __attribute__((__packed__)) uvc_input_header_descriptor;
 
 #define UVC_DT_INPUT_HEADER_SIZE(n, p)      (13+(n*p))
@@ -572,6 +572,44 @@ struct UVC_FRAME_MJPEG(n) {       \
   __u32 dwFrameInterval[n];     \
 } __attribute__ ((packed))
 
+/* Frame Based Payload - 3.1.1. Frame Based Video Format Descriptor */
+typedef struct uvc_format_frame_based {
+  __u8  bLength;
+  __u8  bDescriptorType;
+  __u8  bDescriptorSubType;
+  __u8  bFormatIndex;
+  __u8  bNumFrameDescriptors;
+  __u8  guidFormat[16];
+  __u8  bBitsPerPixel;
+  __u8  bDefaultFrameIndex;
+  __u8  bAspectRatioX;
+  __u8  bAspectRatioY;
+  __u8  bmInterfaceFlags;
+  __u8  bCopyProtect;
+  __u8  bVariableSize;
+} __attribute__((__packed__)) uvc_format_frame_based;
+
+#define UVC_DT_FORMAT_FRAME_BASED_SIZE      28
+
+/* Frame Based Payload - 3.1.2. Frame Based Video Frame Descriptor */
+typedef struct uvc_frame_frame_based {
+  __u8  bLength;
+  __u8  bDescriptorType;
+  __u8  bDescriptorSubType;
+  __u8  bFrameIndex;
+  __u8  bmCapabilities;
+  __u16 wWidth;
+  __u16 wHeight;
+  __u32 dwMinBitRate;
+  __u32 dwMaxBitRate;
+  __u32 dwDefaultFrameInterval;
+  __u8  bFrameIntervalType;
+  __u32 dwBytesPerLine;
+  __u32 dwFrameInterval[1];
+} __attribute__((__packed__)) uvc_frame_frame_based;
+
+#define UVC_DT_FRAME_FRAME_BASED_SIZE(n)    (26+4*(n))
+
 #endif /* __LINUX_USB_VIDEO_H */
 
 
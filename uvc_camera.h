@@ -0,0 +1,191 @@
+/*
+ * Camera-facing C++ API over a packet endpoint
+ *
+ * acquireBuffer() lends out the next free packet slot of the endpoint as
+ * a move-only Buffer. The producer writes its payload straight into it
+ * and hands it back with submit() or, for the last packet of a frame,
+ * submitFrame(); the endpoint sends from the same memory, nothing is
+ * copied on the way. A Buffer dropped without being submitted returns
+ * its slot. Nothing blocks and nothing allocates: when no slot is free
+ * acquireBuffer() returns an empty Buffer.
+ *
+ * poll() calls the completion callback once for every frame the host
+ * has read to the end, from the main loop, never from the interrupt.
+ *
+ * The endpoint is a template parameter so the same code runs against
+ * the UVC stream on the device (uvc_camera_stream.h) and against a
+ * simulated endpoint on the host (tools/uvc_camera_sim.cpp). It needs:
+ *
+ *   typedef ... Slot;
+ *   Slot* acquire();
+ *   void release(Slot*);
+ *   bool submit(Slot*, uint16 len, bool eof);
+ *   uint32 completedFrames();
+ *   static uint8* payload(Slot*);
+ *   static uint16 capacity();
+ */
+
+#ifndef _UVC_CAMERA_H_
+#define _UVC_CAMERA_H_
+
+#include <libmaple/libmaple_types.h>
+
+template <class Endpoint>
+class BasicUVCCamera {
+public:
+    typedef typename Endpoint::Slot Slot;
+    typedef void (*FrameCallback)(uint32 frame, void *arg);
+
+    class Buffer {
+    public:
+        Buffer(void) : _cam(0), _slot(0), _len(0) {}
+
+        Buffer(Buffer &&other) : _cam(other._cam), _slot(other._slot), _len(other._len) {
+            other._cam = 0;
+            other._slot = 0;
+            other._len = 0;
+        }
+
+        Buffer& operator=(Buffer &&other) {
+            if (this != &other) {
+                reset();
+                _cam = other._cam;
+                _slot = other._slot;
+                _len = other._len;
+                other._cam = 0;
+                other._slot = 0;
+                other._len = 0;
+            }
+            return *this;
+        }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        ~Buffer(void) {
+            reset();
+        }
+
+        explicit operator bool(void) const {
+            return _slot != 0;
+        }
+
+        uint8* data(void) const {
+            return _slot ? Endpoint::payload(_slot) : 0;
+        }
+
+        uint16 capacity(void) const {
+            return _slot ? Endpoint::capacity() : 0;
+        }
+
+        uint16 length(void) const {
+            return _len;
+        }
+
+        /* payload bytes written, clipped to capacity() */
+        void setLength(uint16 len) {
+            _len = (len > capacity()) ? capacity() : len;
+        }
+
+        /* give the slot back unsent */
+        void reset(void) {
+            if (_slot) {
+                _cam->_ep.release(_slot);
+            }
+            _cam = 0;
+            _slot = 0;
+            _len = 0;
+        }
+
+    private:
+        friend class BasicUVCCamera;
+
+        Buffer(BasicUVCCamera *cam, Slot *slot) : _cam(cam), _slot(slot), _len(0) {}
+
+        BasicUVCCamera *_cam;
+        Slot *_slot;
+        uint16 _len;
+    };
+
+    BasicUVCCamera(void)
+        : _callback(0), _arg(0), _submitted(0), _completed(0), _endpointDone(0) {}
+
+    BasicUVCCamera(const BasicUVCCamera&) = delete;
+    BasicUVCCamera& operator=(const BasicUVCCamera&) = delete;
+
+    /* An empty Buffer while not streaming or when every slot is queued */
+    Buffer acquireBuffer(void) {
+        Slot *slot = _ep.acquire();
+
+        return slot ? Buffer(this, slot) : Buffer();
+    }
+
+    /* Queue a packet of the current frame. The Buffer is consumed
+     * either way; false means the stream was not running. */
+    bool submit(Buffer &&buf) {
+        return queue(buf, false);
+    }
+
+    /* Queue the last packet of a frame, returns the frame number passed
+     * to the completion callback, 0 if the stream was not running */
+    uint32 submitFrame(Buffer &&buf) {
+        if (!queue(buf, true)) {
+            return 0;
+        }
+        return ++_submitted;
+    }
+
+    void onFrameComplete(FrameCallback callback, void *arg) {
+        _callback = callback;
+        _arg = arg;
+    }
+
+    /* Dispatch completion callbacks, call from the main loop. Frames
+     * the endpoint finished while none of ours was in flight came from
+     * another source and are not reported. */
+    void poll(void) {
+        uint32 done = _ep.completedFrames();
+
+        for (; _endpointDone != done; _endpointDone++) {
+            if (_completed == _submitted) {
+                continue;
+            }
+            _completed++;
+            if (_callback) {
+                _callback(_completed, _arg);
+            }
+        }
+    }
+
+    uint32 framesInFlight(void) const {
+        return _submitted - _completed;
+    }
+
+    Endpoint& endpoint(void) {
+        return _ep;
+    }
+
+private:
+    bool queue(Buffer &buf, bool eof) {
+        Slot *slot = buf._slot;
+        uint16 len = buf._len;
+
+        if (!slot || buf._cam != this) {
+            return false;
+        }
+        /* the endpoint owns the slot from here on */
+        buf._slot = 0;
+        buf._cam = 0;
+        buf._len = 0;
+        return _ep.submit(slot, len, eof);
+    }
+
+    Endpoint _ep;
+    FrameCallback _callback;
+    void *_arg;
+    uint32 _submitted;
+    uint32 _completed;
+    uint32 _endpointDone;
+};
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * UVCCamera on the bulk streaming endpoint, see uvc_camera.h
+ *
+ * Buffers are slots of the uvc_stream.c packet ring. They are only
+ * handed out while the host is streaming and the stream source is
+ * UVC_STREAM_SOURCE_APP.
+ */
+
+#ifndef _UVC_CAMERA_STREAM_H_
+#define _UVC_CAMERA_STREAM_H_
+
+#include "uvc_camera.h"
+#include "uvc_stream.h"
+
+struct UVCStreamEndpoint {
+    typedef uvc_packet Slot;
+
+    Slot* acquire(void) {
+        return uvc_stream_acquire();
+    }
+
+    void release(Slot *slot) {
+        uvc_stream_release(slot);
+    }
+
+    bool submit(Slot *slot, uint16 len, bool eof) {
+        return uvc_stream_submit(slot, len, eof) == 0;
+    }
+
+    uint32 completedFrames(void) {
+        return uvc_stream_frames_done();
+    }
+
+    static uint8* payload(Slot *slot) {
+        return slot->data + UVC_STREAM_HEADER_SIZE;
+    }
+
+    static uint16 capacity(void) {
+        return UVC_STREAM_PAYLOAD_SIZE;
+    }
+};
+
+typedef BasicUVCCamera<UVCStreamEndpoint> UVCCamera;
+
+#endif
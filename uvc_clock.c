@@ -0,0 +1,42 @@
+/*
+ * UVC device clock, see uvc_clock.h
+ */
+
+#include "usb_reg_map.h"
+
+#include "uvc_clock.h"
+
+/* the 6 MHz clock has to be a whole divisor of the core clock */
+typedef char uvc_clock_div_check[
+    (UVC_CLOCK_DIV * USB_UVC_CLOCK_FREQUENCY == DWT_CYCLES_PER_US * 1000000) ? 1 : -1];
+
+static uint32 last_cycles;
+static uint32 ticks;
+static uint32 rem;
+static uint16 sof_frame = 0xFFFF;
+static uvc_clock_scr scr;
+
+/* main loop only; has to run at least once per DWT wrap, about 59 s */
+uint32 uvc_clock_now(void) {
+    uint32 now = dwt_cycles();
+    uint32 delta = now - last_cycles + rem;
+
+    last_cycles = now;
+    ticks += delta / UVC_CLOCK_DIV;
+    rem = delta % UVC_CLOCK_DIV;
+    return ticks;
+}
+
+void uvc_clock_poll(void) {
+    uint16 frame = (uint16)(USB_BASE->FNR & USB_FNR_FN);
+
+    if (frame != sof_frame) {
+        sof_frame = frame;
+        scr.stc = uvc_clock_now();
+        scr.sof = frame;
+    }
+}
+
+const uvc_clock_scr* uvc_clock_get_scr(void) {
+    return &scr;
+}
@@ -0,0 +1,38 @@
+/*
+ * UVC device clock for payload PTS and SCR
+ *
+ * The clock runs at the dwClockFrequency announced in probe/commit,
+ * derived from the DWT cycle counter. uvc_clock_poll() watches the USB
+ * frame number and latches the clock at the first poll after each SOF;
+ * that pair is what goes into the SCR field. The latch lags the SOF by
+ * the main loop latency, which the host's clock recovery averages out.
+ */
+
+#ifndef _UVC_CLOCK_H_
+#define _UVC_CLOCK_H_
+
+#include <libmaple/libmaple_types.h>
+
+#include "dwt.h"
+#include "usb_uvc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UVC_CLOCK_DIV   (DWT_CYCLES_PER_US * 1000000 / USB_UVC_CLOCK_FREQUENCY)
+
+typedef struct uvc_clock_scr {
+    uint32 stc;                 /* device clock at the latch */
+    uint16 sof;                 /* 11-bit USB frame number */
+} uvc_clock_scr;
+
+uint32 uvc_clock_now(void);
+void uvc_clock_poll(void);
+const uvc_clock_scr* uvc_clock_get_scr(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * UVC payload framing policies
+ *
+ * How a frame is cut into payloads depends on the format: YUY2 frames
+ * have a fixed size, MJPEG frames end at the JPEG EOI marker and the
+ * ArduCAM FIFO holds padding after it. uvc_payload_fill() is the packet
+ * kernel for all of them. It is always inlined and its framing and read
+ * arguments are meant to be constants, so every caller that passes them
+ * as such gets its own copy of the loop with the format branches folded
+ * away. uvc_stream.c instantiates one drain loop per framing and picks
+ * one when the host commits a format; tools/uvc_payload_bench.c compares
+ * them with a runtime-switched loop.
+ *
+ * A source may hold several frames back to back (a burst capture). Fixed
+ * frames are cut by size. JPEG frames end at their EOI; the bytes read
+ * past it are carried over to the next packet, and anything in front of
+ * the next SOI is dropped. The source is left unread once the expected
+ * number of frames has ended. tools/burst_sim.c checks the frame
+ * boundaries against a simulated FIFO.
+ *
+ * A coded format (yuy2_rice.h) does not know how long a frame will be
+ * until its coder has seen the last line: uvc_payload_fill_coded() pulls
+ * coded bytes from the source and ends the frame where the source says.
+ */
+
+#ifndef _UVC_PAYLOAD_H_
+#define _UVC_PAYLOAD_H_
+
+#include <string.h>
+
+#include <libmaple/libmaple_types.h>
+
+#include "usb_uvcvideo.h"
+
+/* the frame is a fixed number of source bytes */
+#define UVC_FRAMING_FIXED       0
+/* the frame runs from an SOI (0xFF 0xD8) to the next EOI (0xFF 0xD9) */
+#define UVC_FRAMING_EOI         1
+/* the source codes the frame and tells where it ends */
+#define UVC_FRAMING_CODED       2
+
+/* largest payload uvc_payload_fill() is asked for */
+#define UVC_PAYLOAD_MAX         64
+
+typedef struct uvc_payload {
+    uint32 remaining;           /* source bytes not read yet */
+    uint32 frame_len;           /* fixed framing: bytes per frame */
+    uint32 frame_left;          /* fixed framing: bytes left in this frame */
+    uint8 frames;               /* frames expected from the source */
+    uint8 frame;                /* frames ended so far */
+    uint8 in_frame;             /* the next packet continues a frame */
+    uint8 last;                 /* previous payload byte, an EOI can
+                                 * straddle two packets */
+    uint8 carry_len;
+    uint8 carry[UVC_PAYLOAD_MAX];       /* read past an EOI, sent next */
+} uvc_payload;
+
+typedef void (*uvc_payload_read)(uint8 *buf, uint16 len);
+/* up to len coded bytes into buf, returns how many; sets *end with the
+ * last byte of a frame */
+typedef uint16 (*uvc_payload_pull)(uint8 *buf, uint16 len, uint8 *end);
+
+/* len source bytes holding up to frames frames, frame_len is only used
+ * by fixed framing */
+static inline void uvc_payload_begin(uvc_payload *p, uint32 len, uint32 frame_len, uint8 frames) {
+    p->remaining = len;
+    p->frame_len = frame_len;
+    if (frame_len != 0 && p->remaining > frame_len * frames) {
+        p->remaining = frame_len * frames;
+    }
+    p->frame_left = (frame_len < p->remaining) ? frame_len : p->remaining;
+    p->frames = frames;
+    p->frame = 0;
+    p->in_frame = 0;
+    p->last = 0;
+    p->carry_len = 0;
+}
+
+/* every frame has been filled */
+static inline int uvc_payload_done(const uvc_payload *p) {
+    return p->remaining == 0 && p->carry_len == 0;
+}
+
+/* the next packet filled is the first of a frame */
+static inline int uvc_payload_frame_start(const uvc_payload *p) {
+    return !p->in_frame;
+}
+
+/* Offset just past the EOI in buf, 0 if it is not there */
+static inline __attribute__((always_inline))
+uint16 uvc_payload_find_eoi(uvc_payload *p, const uint8 *buf, uint16 len) {
+    uint8 prev = p->last;
+    uint16 i;
+
+    for (i = 0; i < len; i++) {
+        if (buf[i] == 0xD9 && prev == 0xFF) {
+            return i + 1;
+        }
+        prev = buf[i];
+    }
+    p->last = prev;
+    return 0;
+}
+
+/* Offset of the SOI in buf, len if it is not there */
+static inline uint16 uvc_payload_find_soi(const uint8 *buf, uint16 len) {
+    uint16 i;
+
+    for (i = 1; i < len; i++) {
+        if (buf[i] == 0xD8 && buf[i - 1] == 0xFF) {
+            return i - 1;
+        }
+    }
+    return len;
+}
+
+/* Put bytes read past a frame end back in front of the source */
+static inline void uvc_payload_carry(uvc_payload *p, const uint8 *data, uint16 len) {
+    memmove(p->carry + len, p->carry, p->carry_len);
+    memcpy(p->carry, data, len);
+    p->carry_len += (uint8)len;
+}
+
+static inline void uvc_payload_frame_end(uvc_payload *p) {
+    p->in_frame = 0;
+    p->last = 0;
+    if (++p->frame == p->frames) {
+        /* whatever follows the last frame stays in the source */
+        p->remaining = 0;
+        p->carry_len = 0;
+    }
+}
+
+/*
+ * Fill one packet of at most size bytes. The caller has written any
+ * header bytes past the first two, hlen is the header length and flags
+ * its second byte without EOF. Returns the packet length, or 0 when the
+ * bytes read were all dropped in front of an SOI and the packet is not
+ * to be sent. Must not be called once uvc_payload_done().
+ */
+static inline __attribute__((always_inline))
+uint16 uvc_payload_fill(uvc_payload *p, uint8 *pkt, uint16 size, uint8 hlen,
+                        uint8 flags, const uint8 framing, const uvc_payload_read read) {
+    uint8 *buf = pkt + hlen;
+    uint16 cap = size - hlen;
+    uint16 n, end;
+    uint8 eof;
+
+    if (framing == UVC_FRAMING_EOI) {
+        n = 0;
+        if (p->carry_len != 0) {
+            n = (p->carry_len < cap) ? p->carry_len : cap;
+            memcpy(buf, p->carry, n);
+            p->carry_len -= n;
+            memmove(p->carry, p->carry + n, p->carry_len);
+        }
+        if (p->carry_len == 0) {
+            uint16 m = (p->remaining > (uint32)(cap - n)) ? cap - n : (uint16)p->remaining;
+
+            read(buf + n, m);
+            p->remaining -= m;
+            n += m;
+        }
+
+        if (!p->in_frame) {
+            end = uvc_payload_find_soi(buf, n);
+            if (end == n) {
+                /* keep a 0xFF that may start the SOI */
+                if (n != 0 && buf[n - 1] == 0xFF && !uvc_payload_done(p)) {
+                    uvc_payload_carry(p, buf + n - 1, 1);
+                }
+                return 0;
+            }
+            n -= end;
+            memmove(buf, buf + end, n);
+        }
+
+        end = uvc_payload_find_eoi(p, buf, n);
+        if (end != 0) {
+            uvc_payload_carry(p, buf + end, n - end);
+            n = end;
+        }
+        /* a frame cut short by the end of the source ends there */
+        eof = (end != 0) || uvc_payload_done(p);
+    } else {
+        n = (p->frame_left > cap) ? cap : (uint16)p->frame_left;
+        read(buf, n);
+        p->remaining -= n;
+        p->frame_left -= n;
+        eof = (p->frame_left == 0);
+        if (eof) {
+            p->frame_left = (p->frame_len < p->remaining) ? p->frame_len : p->remaining;
+        }
+    }
+
+    p->in_frame = 1;
+    if (eof) {
+        uvc_payload_frame_end(p);
+    }
+    pkt[0] = hlen;
+    pkt[1] = flags | (eof ? UVC_STREAM_EOF : 0);
+    return hlen + n;
+}
+
+/*
+ * uvc_payload_fill() for UVC_FRAMING_CODED. The source has to hand out
+ * a whole packet unless the frame ends in it.
+ */
+static inline __attribute__((always_inline))
+uint16 uvc_payload_fill_coded(uvc_payload *p, uint8 *pkt, uint16 size, uint8 hlen,
+                              uint8 flags, const uvc_payload_pull pull) {
+    uint8 eof = 0;
+    uint16 n = pull(pkt + hlen, size - hlen, &eof);
+
+    p->in_frame = 1;
+    if (eof) {
+        uvc_payload_frame_end(p);
+    }
+    pkt[0] = hlen;
+    pkt[1] = flags | (eof ? UVC_STREAM_EOF : 0);
+    return hlen + n;
+}
+
+/*
+ * Presentation time of frame index of a burst: the sensor takes the
+ * frames one after the other between the capture trigger at start and
+ * capture done at end
+ */
+static inline uint32 uvc_payload_burst_pts(uint32 start, uint32 end, uint8 index, uint8 frames) {
+    return start + (uint32)((uint64)(end - start) * index / frames);
+}
+
+#endif
@@ -0,0 +1,1318 @@
+/*
+ * UVC bulk streaming, see uvc_stream.h
+ */
+
+#include "usb_reg_map.h"
+
+#include "uvc_stream.h"
+#include "uvc_payload.h"
+#include "usb_pma.h"
+#include "arducam.h"
+#include "test_pattern.h"
+#include "mem_pool.h"
+#include "luma_sig.h"
+#include "ae_stats.h"
+#include "yuy2_rice.h"
+#include "yuv420.h"
+#include "uvc_clock.h"
+#include "uvc_trigger.h"
+#include "ramfunc.h"
+#include "dwt.h"
+#include "irq.h"
+#include "trace.h"
+
+#define RING_MASK               (UVC_STREAM_RING_SIZE - 1)
+
+/* keep the packet stores ahead of the ring index update */
+#define compiler_barrier()      __asm__ __volatile__("" ::: "memory")
+
+typedef enum {
+    STREAM_IDLE,
+    STREAM_ARMED,               /* waiting for the capture trigger, uvc_trigger.h */
+    STREAM_CAPTURE,             /* waiting for the ArduCAM to finish a frame */
+    STREAM_SCAN,                /* FIFO -> luma signature, chip select held low */
+    STREAM_KEEPALIVE,           /* unchanged frame, header-only payload pending */
+    STREAM_DRAIN,               /* FIFO -> ring, chip select held low */
+    STREAM_APP,                 /* the application queues the packets */
+} stream_state;
+
+/*
+ * What differs between formats, chosen once per commit so that nothing
+ * on the packet path looks at the format again
+ */
+typedef struct stream_policy {
+    void (*drain)(void);        /* drain loop built for the framing */
+    void (*pattern_drain)(void);        /* the same, reading a test pattern */
+    uint8 jpeg;                 /* test patterns are the canned JPEG frames */
+    uint8 cut;                  /* frames are cut to dwMaxVideoFrameSize */
+    uint8 scan;                 /* luma change detection applies */
+    uint8 ae;                   /* exposure statistics from the payload */
+    uint8 coded;                /* lines go through the lossless coder */
+    uint8 m420;                 /* line pairs are repacked to 4:2:0 */
+    uint8 raw;                  /* a byte per pixel, test patterns are the ramp */
+} stream_policy;
+
+/* slots come from mem_pool_packet, taken once by uvc_stream_init() */
+static uvc_packet *ring[UVC_STREAM_RING_SIZE];
+static volatile uint8 ring_head;        /* next slot the main loop fills */
+static volatile uint8 ring_tail;        /* next slot the endpoint sends */
+static volatile uint8 tx_busy;
+
+static stream_state state = STREAM_IDLE;
+static const stream_policy *policy;
+static void (*drain)(void);             /* policy drain for the capture source */
+static uint32 stream_frame_size;        /* in capture bytes, YUY2 for converted formats */
+static uint16 stream_width;
+static uint16 stream_height;
+static uint8 fid;
+static uint8 frame_open;                /* payloads of this FID are queued */
+static uvc_payload payload;
+static uvc_stream_stats stats;
+
+/* change detection */
+static volatile uint8 change_threshold = UVC_STREAM_CHANGE_THRESHOLD;
+static uint8 *scan_buf;                 /* from mem_pool_line */
+static uint32 frame_len;
+static uint32 scanned;
+static uint32 scan_start;
+static luma_sig_acc sig_acc;
+static luma_sig sig_cur;
+static luma_sig sig_ref;                /* last frame sent */
+static uint8 have_ref;
+
+/* fault recovery */
+static volatile uint8 fault_code;       /* pending, set from any context */
+static uint8 recovering;
+static uint32 recover_start;
+static uint32 capture_start;
+/* per frame of the capture, from the committed frame interval */
+static uint32 capture_timeout_us = UVC_STREAM_CAPTURE_TIMEOUT_FRAMES *
+    (USB_UVC_FRAME_INTERVAL / 10);
+static uint32 capture_pts;              /* device clock at the capture's VSYNC */
+static uint32 capture_done_pts;         /* and when the ArduCAM reported done */
+
+/* the sensor frame a capture starts on */
+static uint32 trigger_cycles;           /* when its trigger fired */
+static uint8 vsync_wait;                /* its VSYNC not seen yet */
+static uint8 vsync_low;                 /* VSYNC seen inactive since the start command */
+
+/* burst capture */
+static volatile uint8 burst_req = 1;    /* frames per capture, from the host */
+static uint8 burst_cur = 1;             /* frames in the capture in flight */
+static uint8 burst_set;                 /* programmed into the ArduCAM, 0 unknown */
+
+/* test pattern source */
+static volatile uint8 pattern_req = UVC_STREAM_TEST_PATTERN;
+static uint8 pattern_cur;               /* of the capture in flight */
+
+/* lossless coding, yuy2_rice.h */
+static const uint8 rice_raw = YUY2_RICE_RAW;
+static uint8 *code_buf;                 /* from mem_pool_line, one coded line or M420 pair */
+static yuy2_rice rice;
+static uint8 rice_header[YUY2_RICE_HEADER_SIZE];
+static const uint8 *code_pos;           /* coded bytes not handed out yet */
+static uint16 code_left;
+static const uint8 *code_next;          /* then these, the line of a raw one */
+static uint16 code_next_left;
+static uint16 code_lines;               /* lines of this frame not coded yet */
+static uint32 code_raw;                 /* capture bytes not read yet */
+
+/* 4:2:0, yuv420.h */
+static uint16 m420_line_bytes;          /* YUY2 bytes per line read */
+static const uint8 *m420_pos;           /* M420 bytes not handed out yet */
+static uint16 m420_left;
+static uint8 m420_odd;                  /* the next line ends a pair */
+
+/* last-frame cache, the capture a stopped stream left in the FIFO */
+typedef enum {
+    CACHE_NONE,
+    CACHE_CAPTURING,            /* the sensor was still writing it */
+    CACHE_DONE,                 /* complete, possibly partly read */
+} cache_state;
+
+static cache_state cache;
+static uint32 captured_len;             /* FIFO length at capture done, 0 before */
+static uint8 cache_kind;                /* streamSensorKind() of the stream */
+static uint16 cache_width;
+static uint16 cache_height;
+static uint8 cache_frames;
+static uint32 cache_pts;
+static uint32 cache_done_pts;
+
+/* time to the first frame of a stream, with or without the cache */
+static uint32 open_start;               /* DWT cycles at uvc_stream_start() */
+static uint32 open_frames;              /* frames_done then */
+static uint8 open_waiting;              /* the host has not read a frame since */
+
+/* SPI link check on the markers of sensor JPEG frames */
+static uint8 jpeg_head;                 /* the next packet starts the capture */
+static uint8 jpeg_bad;                  /* this frame had no SOI at the head */
+static uint8 jpeg_error_run;            /* broken frames in a row */
+
+/* exposure statistics */
+static ae_stats_acc ae_acc;
+static ae_stats ae_cur;
+static uint8 ae_ready;
+
+/* application source */
+static uint8 stream_source = UVC_STREAM_SOURCE_SENSOR;
+static uint8 app_acquired;              /* ring[ring_head] is lent out */
+static uint8 eof_in_flight;             /* the packet in PMA ends a frame */
+static volatile uint32 frames_done;     /* frames the host has fully read */
+static uint32 frames_queued;            /* frames whose EOF went into the ring */
+
+/* polled refill */
+static volatile uint8 tx_poll_req = UVC_STREAM_TX_POLLED;
+static uint8 tx_poll;                   /* for the frame being drained */
+static uint8 polling;                   /* in a polled drain pass */
+static uint32 poll_start;
+static uint8 rate_open;                 /* timing the frame being drained */
+static uint32 rate_start;
+static uint32 rate_packets;
+
+static inline uint8 ringCount(void) {
+    return (uint8)(ring_head - ring_tail);
+}
+
+/* endpoint side, called from the USB interrupt or with interrupts off */
+static inline __attribute__((always_inline)) void streamSend(void) {
+    uvc_packet *pkt;
+    uint32 start = dwt_cycles();
+
+    if (ring_head == ring_tail) {
+        tx_busy = 0;
+        stats.ring_empty++;
+        trace_event(TRACE_RING_EMPTY, 0, 0);
+        return;
+    }
+    pkt = ring[ring_tail & RING_MASK];
+    eof_in_flight = pkt->data[1] & UVC_STREAM_EOF;
+    usb_pma_write(pkt->data, pkt->len, USB_TX_ADDR);
+    usb_set_ep_tx_count(USB_TX_ENDP, pkt->len);
+    usb_set_ep_tx_stat(USB_TX_ENDP, USB_EP_STAT_TX_VALID);
+    ring_tail++;
+    tx_busy = 1;
+    stats.packets++;
+
+    stats.send_cycles = dwt_cycles() - start;
+    if (stats.send_cycles > stats.send_cycles_max) {
+        stats.send_cycles_max = stats.send_cycles;
+    }
+}
+
+/* drain start to the host reading the EOF, per refill path */
+static void streamTxRate(void) {
+    uint8 path = tx_poll ? UVC_STREAM_TX_POLL : UVC_STREAM_TX_IRQ;
+
+    rate_open = 0;
+    stats.tx_packets[path] += stats.packets - rate_packets;
+    stats.tx_us[path] += dwt_cycles_to_us(dwt_cycles() - rate_start);
+}
+
+RAMFUNC(RAMFUNC_STREAM_TX, uvc_stream_tx)
+void uvc_stream_tx(void) {
+    trace_event(TRACE_EP_IN, USB_TX_ENDP, 0);
+    /* the host has taken the last packet */
+    if (eof_in_flight) {
+        eof_in_flight = 0;
+        frames_done++;
+        if (rate_open) {
+            streamTxRate();
+        }
+    }
+    streamSend();
+}
+
+/*
+ * Polled refill. Within a polled drain pass the correct-transfer
+ * interrupt is masked and a full ring waits here: the loop spins on
+ * CTR_TX of the streaming endpoint and refills the packet memory itself,
+ * without interrupt entry and the usb_lib dispatch. Returns 1 once a
+ * slot is free, 0 when the pass has used its slice or another endpoint
+ * has a transfer waiting; the interrupt handles that one as soon as the
+ * pass is over, so control requests wait no more than a slice.
+ */
+static int streamPollWait(void) {
+    while (dwt_cycles() - poll_start < UVC_STREAM_POLL_SLICE_US * DWT_CYCLES_PER_US) {
+        uint16 istr = (uint16)USB_BASE->ISTR;
+
+        if ((istr & USB_ISTR_CTR) && (istr & USB_ISTR_EP_ID) != USB_TX_ENDP) {
+            return 0;
+        }
+        if (USB_BASE->EP[USB_TX_ENDP] & USB_EP_CTR_TX) {
+            int sent = 0;
+            uint32 primask;
+
+            /* a fault from the USB interrupt parks the endpoint */
+            primask = irq_save();
+            if (fault_code == UVC_STREAM_ERROR_NONE) {
+                usb_clear_ctr_tx(USB_TX_ENDP);
+                uvc_stream_tx();
+                sent = 1;
+            }
+            irq_restore(primask);
+            return sent;
+        }
+        uvc_clock_poll();
+    }
+    return 0;
+}
+
+/* Back to the interrupt refill, at the end of a polled pass or before
+ * anything in it that is not draining */
+static void streamPollEnd(void) {
+    if (polling) {
+        polling = 0;
+        usb_uvc_set_ctr_irq(1);
+    }
+}
+
+/*
+ * Capture source: the ArduCAM FIFO or a test pattern, chosen per capture.
+ * Only the drain loops read on the packet path, and they are built for
+ * one source each.
+ */
+static inline void sourceBegin(void) {
+    if (pattern_cur == TEST_PATTERN_OFF) {
+        arducam_burst_begin();
+    }
+}
+
+static inline void sourceEnd(void) {
+    if (pattern_cur == TEST_PATTERN_OFF) {
+        arducam_burst_end();
+    }
+}
+
+static void sourceRead(uint8 *buf, uint16 len) {
+    if (pattern_cur == TEST_PATTERN_OFF) {
+        arducam_burst_read(buf, len);
+    } else {
+        test_pattern_read(buf, len);
+    }
+}
+
+static void sourceRewind(void) {
+    if (pattern_cur == TEST_PATTERN_OFF) {
+        arducam_fifo_rewind();
+    } else {
+        test_pattern_rewind();
+    }
+}
+
+static void streamCaptured(void);
+
+/*
+ * The armed capture starts now, cycles is when its trigger fired. The
+ * ArduCAM only begins writing at the sensor's next VSYNC, up to a frame
+ * period later: capture_pts and the trigger delay are taken there, by
+ * streamVsync(). A pattern starts at once.
+ */
+static void streamTrigger(uint32 cycles) {
+    capture_pts = uvc_clock_now();
+    trigger_cycles = cycles;
+    captured_len = 0;
+    vsync_low = 0;
+    if (pattern_cur != TEST_PATTERN_OFF) {
+        /* patterns are laid out in YUY2 pixels, two bytes each */
+        test_pattern_capture(pattern_cur, policy->raw ? stream_width / 2 : stream_width,
+                             stream_height, burst_cur);
+        vsync_wait = 0;
+        uvc_trigger_started(cycles);
+    } else {
+        arducam_start_capture();
+        vsync_wait = 1;
+    }
+    capture_start = dwt_cycles();
+    state = STREAM_CAPTURE;
+    trace_event(TRACE_CAPTURE, burst_cur, pattern_cur);
+}
+
+/*
+ * The first VSYNC after the start command begins the capture. The pin
+ * is sampled once per pass, so the stamp is late by up to the gap
+ * between passes; a pulse that falls between two passes is not seen at
+ * all, and the capture keeps the stamp of its start command.
+ */
+static void streamVsync(uint8 status) {
+    int edge = 0;
+
+    if (!(status & ARDUCAM_TRIG_VSYNC)) {
+        vsync_low = 1;
+    } else if (vsync_low) {
+        /* not the pulse that was on at the command */
+        edge = 1;
+    }
+    if (edge) {
+        capture_pts = uvc_clock_now();
+    } else if (status & ARDUCAM_TRIG_CAP_DONE) {
+        stats.vsync_missed++;
+    } else {
+        return;
+    }
+    vsync_wait = 0;
+    uvc_trigger_started(trigger_cycles);
+}
+
+static void streamStartCapture(void) {
+    uint32 cycles;
+
+    burst_cur = burst_req;
+    pattern_cur = pattern_req;
+    if (pattern_cur != TEST_PATTERN_OFF) {
+        /* the pattern has to match the committed format */
+        if (policy->jpeg) {
+            pattern_cur = TEST_PATTERN_JPEG;
+        } else if (policy->raw) {
+            pattern_cur = TEST_PATTERN_RAMP;
+        } else if (pattern_cur == TEST_PATTERN_JPEG) {
+            pattern_cur = TEST_PATTERN_BARS;
+        }
+    }
+    if (pattern_cur != TEST_PATTERN_OFF) {
+        drain = policy->pattern_drain;
+    } else {
+        drain = policy->drain;
+        /* the trigger below clears the FIFO */
+        cache = CACHE_NONE;
+        if (jpeg_error_run >= UVC_STREAM_SPI_FALLBACK_ERRORS) {
+            jpeg_error_run = 0;
+            if (arducam_spi_fallback() == 0) {
+                trace_event(TRACE_SPI_FALLBACK, arducam_spi_get_stats()->step, 0);
+            }
+        }
+        if (burst_cur != burst_set) {
+            arducam_set_frames(burst_cur);
+            burst_set = burst_cur;
+        }
+    }
+    uvc_trigger_arm();
+    if (uvc_trigger_poll(&cycles)) {
+        streamTrigger(cycles);
+    } else {
+        state = STREAM_ARMED;
+    }
+}
+
+static inline void put32(uint8 *p, uint32 v) {
+    p[0] = (uint8)v;
+    p[1] = (uint8)(v >> 8);
+    p[2] = (uint8)(v >> 16);
+    p[3] = (uint8)(v >> 24);
+}
+
+/* PTS and SCR after the two fixed header bytes, returns the header size */
+static uint8 streamTimestamps(uint8 *hdr, uint32 pts) {
+    const uvc_clock_scr *scr = uvc_clock_get_scr();
+
+    put32(hdr + 2, pts);
+    put32(hdr + 6, scr->stc);
+    hdr[10] = (uint8)scr->sof;
+    hdr[11] = (uint8)(scr->sof >> 8);
+    return UVC_STREAM_HEADER_SIZE_TS;
+}
+
+static void streamRestart(void) {
+    if (stream_source == UVC_STREAM_SOURCE_APP) {
+        state = STREAM_APP;
+    } else {
+        streamStartCapture();
+    }
+}
+
+static void streamKick(void) {
+    uint32 primask;
+
+    primask = irq_save();
+    if (!tx_busy) {
+        streamSend();
+    }
+    irq_restore(primask);
+}
+
+/* the last payload of a frame is in the ring */
+static void streamFrameQueued(void) {
+    trace_event(TRACE_FRAME_END, fid, 0);
+    fid ^= UVC_STREAM_FID;
+    frame_open = 0;
+    frames_queued++;
+    stats.frames++;
+    if (recovering) {
+        recovering = 0;
+        stats.recovery_us = dwt_cycles_to_us(dwt_cycles() - recover_start);
+        if (stats.recovery_us > stats.recovery_us_max) {
+            stats.recovery_us_max = stats.recovery_us;
+        }
+    }
+}
+
+/*
+ * Lossless format: every line is read from the capture source into
+ * scan_buf, which change detection is done with by then, and coded into
+ * code_buf. The drain loop pulls the coded bytes packet by packet and a
+ * frame ends with its last line.
+ */
+static void streamRiceFrame(void) {
+    /* the YUY2 mode is never wider than a line block */
+    yuy2_rice_begin(&rice, (stream_width > MEM_POOL_LINE_SIZE / 2) ?
+                    MEM_POOL_LINE_SIZE / 2 : stream_width);
+    code_lines = 0;
+    if (rice.line_bytes != 0) {
+        code_lines = (code_raw / rice.line_bytes < stream_height) ?
+            (uint16)(code_raw / rice.line_bytes) : stream_height;
+    }
+    yuy2_rice_header(&rice, code_lines, rice_header);
+    code_pos = rice_header;
+    code_left = YUY2_RICE_HEADER_SIZE;
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamRiceLine)
+static void streamRiceLine(void) {
+    uint32 start;
+    uint16 n;
+
+    sourceRead(scan_buf, rice.line_bytes);
+    code_raw -= rice.line_bytes;
+    code_lines--;
+    start = dwt_cycles();
+    n = yuy2_rice_encode_line(&rice, scan_buf, code_buf);
+    stats.code_cycles = dwt_cycles() - start;
+    if (n != 0) {
+        code_pos = code_buf;
+        code_left = n;
+    } else {
+        code_pos = &rice_raw;
+        code_left = 1;
+        code_next = scan_buf;
+        code_next_left = rice.line_bytes;
+    }
+}
+
+static uint16 streamRicePull(uint8 *buf, uint16 len, uint8 *end) {
+    uint16 n = 0;
+
+    if (code_left == 0 && code_next_left == 0 && code_lines == 0) {
+        streamRiceFrame();
+    }
+    while (n < len) {
+        uint16 m;
+
+        if (code_left == 0) {
+            if (code_next_left != 0) {
+                code_pos = code_next;
+                code_left = code_next_left;
+                code_next_left = 0;
+            } else if (code_lines != 0) {
+                streamRiceLine();
+            } else {
+                break;
+            }
+            continue;
+        }
+        m = (code_left < len - n) ? code_left : len - n;
+        memcpy(buf + n, code_pos, m);
+        code_pos += m;
+        code_left -= m;
+        n += m;
+    }
+    *end = (code_left == 0 && code_next_left == 0 && code_lines == 0);
+    return n;
+}
+
+/* a sensor JPEG frame has been queued, ok if its markers were there */
+static void streamJpegCheck(uint8 ok) {
+    jpeg_bad = 0;
+    if (pattern_cur != TEST_PATTERN_OFF) {
+        return;
+    }
+    if (ok) {
+        jpeg_error_run = 0;
+        return;
+    }
+    stats.jpeg_errors++;
+    if (jpeg_error_run < 0xFF) {
+        jpeg_error_run++;
+    }
+}
+
+/*
+ * 4:2:0 format: every YUY2 line is read into scan_buf and split into
+ * code_buf, Y in the first half, UV in the second. The even line of a
+ * pair hands out its Y and leaves its chroma there, the odd line its Y
+ * and the mean of both lines' chroma. A frame is a fixed number of M420
+ * bytes, whole line pairs, so the read never runs past a pair.
+ */
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamM420Line)
+static void streamM420Line(void) {
+    uint16 half = m420_line_bytes / 2;
+
+    sourceRead(scan_buf, m420_line_bytes);
+    if (m420_odd) {
+        yuv420_split(scan_buf, m420_line_bytes, code_buf, code_buf + half, 1);
+        m420_left = 2 * half;
+    } else {
+        yuv420_split(scan_buf, m420_line_bytes, code_buf, code_buf + half, 0);
+        m420_left = half;
+    }
+    m420_pos = code_buf;
+    m420_odd ^= 1;
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamM420Read)
+static void streamM420Read(uint8 *buf, uint16 len) {
+    while (len > 0) {
+        uint16 n;
+
+        if (m420_left == 0) {
+            streamM420Line();
+        }
+        n = (m420_left < len) ? m420_left : len;
+        memcpy(buf, m420_pos, n);
+        m420_pos += n;
+        m420_left -= n;
+        buf += n;
+        len -= n;
+    }
+}
+
+/* M420 bytes of the whole line pairs in len capture bytes */
+static uint32 streamM420Length(uint32 len) {
+    uint32 pair = 2 * (uint32)m420_line_bytes;
+
+    return (pair != 0) ? len / pair * YUV420_PAIR_BYTES(m420_line_bytes) : 0;
+}
+
+/*
+ * FIFO -> ring. Each framing gets its own copy of this loop, see
+ * uvc_payload.h; drain_cycles covers one packet, SPI read and exposure
+ * statistics included. A burst capture holds several frames, each one
+ * gets its own FID and a PTS spread over the capture time.
+ */
+static inline __attribute__((always_inline))
+void drainLoop(const uint8 framing, const uint8 ae, const uvc_payload_read read) {
+    uint32 begin = dwt_cycles();
+    uint16 queued = 0;
+
+    while (!uvc_payload_done(&payload)) {
+        uvc_packet *pkt;
+        uint8 flags = UVC_STREAM_EOH | fid;
+        uint8 hlen = UVC_STREAM_HEADER_SIZE;
+        uint32 start;
+        uint16 len;
+        uint8 eof;
+
+        /* a slow SPI clock never fills the ring the bus empties, so a
+         * pass also ends after a ring's worth of packets, or its slice */
+        if (polling ? dwt_cycles() - poll_start >= UVC_STREAM_POLL_SLICE_US * DWT_CYCLES_PER_US :
+            queued == UVC_STREAM_RING_SIZE) {
+            break;
+        }
+        if (ringCount() == UVC_STREAM_RING_SIZE && !(polling && streamPollWait())) {
+            break;
+        }
+        pkt = ring[ring_head & RING_MASK];
+        start = dwt_cycles();
+
+        if (uvc_payload_frame_start(&payload)) {
+            trace_event(TRACE_FRAME_START, fid, 0);
+            hlen = streamTimestamps(pkt->data, uvc_payload_burst_pts(
+                capture_pts, capture_done_pts, payload.frame, burst_cur));
+            flags |= UVC_STREAM_PTS | UVC_STREAM_SCR;
+        }
+        if (framing == UVC_FRAMING_CODED) {
+            len = uvc_payload_fill_coded(&payload, pkt->data, USB_TX_EPSIZE, hlen, flags,
+                                         streamRicePull);
+        } else {
+            len = uvc_payload_fill(&payload, pkt->data, USB_TX_EPSIZE, hlen, flags,
+                                   framing, read);
+        }
+        if (framing == UVC_FRAMING_EOI) {
+            /* the ArduCAM starts a JPEG capture right at the SOI */
+            if (jpeg_head && len == 0) {
+                jpeg_bad = 1;
+            }
+            jpeg_head = 0;
+        }
+        if (len == 0) {
+            /* FIFO bytes between two JPEGs */
+            continue;
+        }
+        pkt->len = len;
+        eof = pkt->data[1] & UVC_STREAM_EOF;
+        if (ae) {
+            ae_stats_update(&ae_acc, pkt->data + hlen, len - hlen);
+        }
+        stats.drain_cycles = dwt_cycles() - start;
+
+        frame_open = 1;
+        compiler_barrier();
+        ring_head++;
+        queued++;
+        if (!tx_busy) {
+            streamKick();
+        }
+
+        if (eof) {
+            if (framing == UVC_FRAMING_EOI) {
+                /* a frame cut short by the end of the FIFO has no EOI */
+                streamJpegCheck(pkt->data[len - 1] == 0xD9 && !jpeg_bad);
+            }
+            if (ae) {
+                ae_stats_end(&ae_acc);
+                ae_ready = 1;
+                ae_stats_begin(&ae_acc, &ae_cur, stream_width, stream_height);
+            }
+            streamFrameQueued();
+        }
+    }
+
+    /* a pass that found the ring full is not worth a trace entry */
+    if (queued != 0) {
+        trace_event_at(begin, TRACE_DRAIN_BEGIN, 0, 0);
+        trace_event(TRACE_DRAIN_END, 0, queued);
+    }
+    if (uvc_payload_done(&payload)) {
+        /* the next capture's SPI trigger and SOF spin are not part of
+         * the polled slice, the interrupt refills during them */
+        streamPollEnd();
+        sourceEnd();
+        streamStartCapture();
+    }
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainYuy2)
+static void streamDrainYuy2(void) {
+    drainLoop(UVC_FRAMING_FIXED, 1, arducam_burst_read);
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainEoi)
+static void streamDrainEoi(void) {
+    drainLoop(UVC_FRAMING_EOI, 0, arducam_burst_read);
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainRaw)
+static void streamDrainRaw(void) {
+    drainLoop(UVC_FRAMING_FIXED, 0, arducam_burst_read);
+}
+
+/* the pattern drains run from SRAM like the sensor ones, so a pattern
+ * measures the packet path without SPI but with the same fetch costs */
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainPatternYuy2)
+static void streamDrainPatternYuy2(void) {
+    drainLoop(UVC_FRAMING_FIXED, 1, test_pattern_read);
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainPatternEoi)
+static void streamDrainPatternEoi(void) {
+    drainLoop(UVC_FRAMING_EOI, 0, test_pattern_read);
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainPatternRaw)
+static void streamDrainPatternRaw(void) {
+    drainLoop(UVC_FRAMING_FIXED, 0, test_pattern_read);
+}
+
+/* the coder and the 4:2:0 split read whole lines through sourceRead(),
+ * one loop serves both sources */
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainRice)
+static void streamDrainRice(void) {
+    drainLoop(UVC_FRAMING_CODED, 0, sourceRead);
+}
+
+RAMFUNC(RAMFUNC_STREAM_DRAIN, streamDrainM420)
+static void streamDrainM420(void) {
+    drainLoop(UVC_FRAMING_FIXED, 0, streamM420Read);
+}
+
+static const stream_policy policy_yuy2 = {
+    streamDrainYuy2, streamDrainPatternYuy2, 0, 1, 1, 1, 0, 0, 0
+};
+static const stream_policy policy_mjpeg = {
+    streamDrainEoi, streamDrainPatternEoi, 1, 0, 0, 0, 0, 0, 0
+};
+static const stream_policy policy_rice = {
+    streamDrainRice, streamDrainRice, 0, 1, 1, 0, 1, 0, 0
+};
+static const stream_policy policy_m420 = {
+    streamDrainM420, streamDrainM420, 0, 1, 1, 0, 0, 1, 0
+};
+/* the signature samples every 8th byte, B or G of a Bayer frame, still
+ * a measure of brightness for change detection */
+static const stream_policy policy_bayer = {
+    streamDrainRaw, streamDrainPatternRaw, 0, 1, 1, 0, 0, 0, 1
+};
+
+static const stream_policy* streamPolicy(uint8 format) {
+    switch (format) {
+    case USB_UVC_FORMAT_MJPEG:
+        return &policy_mjpeg;
+    case USB_UVC_FORMAT_RICE:
+        return &policy_rice;
+    case USB_UVC_FORMAT_M420:
+        return &policy_m420;
+    case USB_UVC_FORMAT_BAYER:
+        return &policy_bayer;
+    default:
+        return &policy_yuy2;
+    }
+}
+
+/* Queue a payload without data, returns -1 while the ring is full */
+static int streamQueueHeader(uint8 flags) {
+    uvc_packet *pkt;
+
+    if (ringCount() == UVC_STREAM_RING_SIZE) {
+        return -1;
+    }
+    pkt = ring[ring_head & RING_MASK];
+    pkt->data[0] = UVC_STREAM_HEADER_SIZE;
+    pkt->data[1] = UVC_STREAM_EOH | fid | flags;
+    pkt->len = UVC_STREAM_HEADER_SIZE;
+
+    compiler_barrier();
+    ring_head++;
+    if (!tx_busy) {
+        streamKick();
+    }
+    return 0;
+}
+
+int uvc_stream_init(void) {
+    uint8 i;
+
+    if (scan_buf == NULL) {
+        scan_buf = (uint8*)mem_pool_alloc(&mem_pool_line);
+    }
+    if (code_buf == NULL) {
+        code_buf = (uint8*)mem_pool_alloc(&mem_pool_line);
+    }
+    for (i = 0; i < UVC_STREAM_RING_SIZE; i++) {
+        if (ring[i] == NULL) {
+            ring[i] = (uvc_packet*)mem_pool_alloc(&mem_pool_packet);
+        }
+        if (ring[i] == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Last-frame cache. A stream that stops leaves its capture in the
+ * ArduCAM FIFO: complete if it was being read out, still coming in if
+ * the sensor was at it. The next stream that wants the same sensor
+ * output starts on it instead of triggering a capture, so its first
+ * frame is only as far away as the transfer, stamped with the PTS of
+ * when it was taken. The FIFO is the cache, nothing is copied; the
+ * next capture trigger clears it.
+ *
+ * A capture only counts as complete once the ArduCAM has reported it
+ * done and the FIFO still holds the length it reported then. Frames
+ * dropped as unchanged and streams with a fault pending keep nothing.
+ */
+
+/* what the sensor puts in the FIFO for a policy */
+static uint8 streamSensorKind(const stream_policy *p) {
+    return p->jpeg ? 1 : p->raw ? 2 : 0;
+}
+
+static void streamKeepCache(void) {
+    /* stopped already, or never on the FIFO: what is cached stands */
+    if (state == STREAM_IDLE || state == STREAM_APP) {
+        return;
+    }
+    cache = CACHE_NONE;
+    if (stream_source != UVC_STREAM_SOURCE_SENSOR || pattern_cur != TEST_PATTERN_OFF ||
+        fault_code != UVC_STREAM_ERROR_NONE) {
+        return;
+    }
+    if (state == STREAM_CAPTURE) {
+        cache = CACHE_CAPTURING;
+    } else if ((state == STREAM_SCAN || state == STREAM_DRAIN) && captured_len != 0 &&
+               arducam_fifo_length() == captured_len) {
+        cache = CACHE_DONE;
+    } else {
+        return;
+    }
+    cache_kind = streamSensorKind(policy);
+    cache_width = stream_width;
+    cache_height = stream_height;
+    cache_frames = burst_cur;
+    cache_pts = capture_pts;
+    cache_done_pts = capture_done_pts;
+}
+
+/* Start on the cached capture, 0 if there is none that fits */
+static int streamUseCache(void) {
+    /* a triggered stream waits for its trigger, even for the first frame */
+    if (cache == CACHE_NONE || stream_source != UVC_STREAM_SOURCE_SENSOR ||
+        uvc_trigger_mode() != UVC_TRIGGER_FREE ||
+        pattern_req != TEST_PATTERN_OFF || cache_kind != streamSensorKind(policy) ||
+        cache_width != stream_width || cache_height != stream_height ||
+        uvc_clock_now() - cache_pts > UVC_STREAM_CACHE_MAX_AGE_MS *
+        (USB_UVC_CLOCK_FREQUENCY / 1000)) {
+        cache = CACHE_NONE;
+        return 0;
+    }
+    pattern_cur = TEST_PATTERN_OFF;
+    drain = policy->drain;
+    burst_cur = cache_frames;
+    capture_pts = cache_pts;
+    stats.cache_hits++;
+    trace_event(TRACE_CACHE, cache_frames, cache);
+    if (cache == CACHE_CAPTURING) {
+        /* the capture in flight simply becomes this stream's */
+        capture_start = dwt_cycles();
+        state = STREAM_CAPTURE;
+    } else {
+        capture_done_pts = cache_done_pts;
+        arducam_fifo_rewind();
+        streamCaptured();
+    }
+    cache = CACHE_NONE;
+    return 1;
+}
+
+/* frame_size is the committed dwMaxVideoFrameSize, YUY2 frames are cut
+ * to it, anything longer is left over in the FIFO. Coded and 4:2:0
+ * frames are cut to the YUY2 size of the geometry set. */
+void uvc_stream_start(uint8 format, uint32 frame_size) {
+    const stream_policy *next = streamPolicy(format);
+    uint32 primask;
+
+    uvc_stream_stop();
+    if (ring[RING_MASK] == NULL) {
+        return;
+    }
+    if ((next->coded || next->m420) && (scan_buf == NULL || code_buf == NULL)) {
+        return;
+    }
+    policy = next;
+    stream_frame_size = frame_size;
+    if (policy->coded && stream_width != 0) {
+        stream_frame_size = (uint32)YUY2_RICE_LINE_BYTES(stream_width) * stream_height;
+    }
+    if (policy->m420) {
+        /* the YUY2 mode is never wider than a line block */
+        m420_line_bytes = MEM_POOL_LINE_SIZE;
+        if (stream_width != 0 && YUY2_RICE_LINE_BYTES(stream_width) < MEM_POOL_LINE_SIZE) {
+            m420_line_bytes = (uint16)YUY2_RICE_LINE_BYTES(stream_width);
+        }
+        stream_frame_size = frame_size / 3 * 4;
+    }
+    fid = 0;
+    frame_open = 0;
+    have_ref = 0;
+    recovering = 0;
+
+    /* a fault while idle left the endpoint parked */
+    primask = irq_save();
+    if (fault_code != UVC_STREAM_ERROR_NONE) {
+        fault_code = UVC_STREAM_ERROR_NONE;
+        tx_busy = 0;
+    }
+    irq_restore(primask);
+    usb_uvc_set_stream_error(UVC_STREAM_ERROR_NONE);
+    open_start = dwt_cycles();
+    open_frames = frames_done;
+    frames_queued = frames_done;
+    open_waiting = 1;
+    if (!streamUseCache()) {
+        streamRestart();
+    }
+}
+
+void uvc_stream_stop(void) {
+    uint32 primask;
+
+    if (state == STREAM_DRAIN || state == STREAM_SCAN) {
+        sourceEnd();
+    }
+    streamKeepCache();
+    state = STREAM_IDLE;
+    open_waiting = 0;
+
+    /* drop whatever is queued, a packet already in PMA still goes out */
+    primask = irq_save();
+    ring_tail = ring_head;
+    irq_restore(primask);
+}
+
+/* one drain pass, with the endpoint refilled from here in polled mode */
+static void streamDrainPass(void) {
+    if (!tx_poll) {
+        drain();
+        return;
+    }
+    usb_uvc_set_ctr_irq(0);
+    poll_start = dwt_cycles();
+    polling = 1;
+    drain();
+    streamPollEnd();
+}
+
+static void streamStartDrain(void) {
+    if (policy->m420) {
+        m420_left = 0;
+        m420_odd = 0;
+        uvc_payload_begin(&payload, streamM420Length(frame_len),
+                          streamM420Length(stream_frame_size), burst_cur);
+    } else {
+        uvc_payload_begin(&payload, frame_len, policy->cut ? stream_frame_size : 0, burst_cur);
+    }
+    if (policy->coded) {
+        code_raw = frame_len;
+        code_left = 0;
+        code_next_left = 0;
+        code_lines = 0;
+    }
+    if (policy->ae) {
+        ae_stats_begin(&ae_acc, &ae_cur, stream_width, stream_height);
+    }
+    jpeg_head = 1;
+    jpeg_bad = 0;
+    tx_poll = tx_poll_req;
+    rate_start = dwt_cycles();
+    rate_packets = stats.packets;
+    /* packets of the frame before would count towards this one; only
+     * a pattern, drained from SRAM, leaves the refill as the limit */
+    rate_open = (ringCount() == 0 && pattern_cur != TEST_PATTERN_OFF);
+    sourceBegin();
+    state = STREAM_DRAIN;
+    streamDrainPass();
+}
+
+/* one FIFO line per call, so a frame scan does not hold up the loop */
+static void streamScan(void) {
+    uint16 n = (frame_len - scanned > MEM_POOL_LINE_SIZE) ?
+        MEM_POOL_LINE_SIZE : (uint16)(frame_len - scanned);
+
+    sourceRead(scan_buf, n);
+    luma_sig_update(&sig_acc, scan_buf, n);
+    scanned += n;
+    if (scanned < frame_len) {
+        return;
+    }
+
+    sourceEnd();
+    luma_sig_end(&sig_acc);
+    stats.scan_us = dwt_cycles_to_us(dwt_cycles() - scan_start);
+    stats.change = have_ref ? luma_sig_distance(&sig_cur, &sig_ref) : 0xFF;
+    trace_event(TRACE_SCAN, stats.change, 0);
+
+    if (stats.change > change_threshold) {
+        sig_ref = sig_cur;
+        have_ref = 1;
+        sourceRewind();
+        streamStartDrain();
+    } else {
+        stats.skipped++;
+        trace_event(TRACE_DROP, TRACE_DROP_UNCHANGED, 0);
+        state = STREAM_KEEPALIVE;
+    }
+}
+
+/*
+ * An unchanged frame becomes a single payload with no data and no EOF.
+ * It carries the FID of the next frame, which continues it, so the host
+ * never sees an empty frame.
+ */
+static void streamKeepalive(void) {
+    if (streamQueueHeader(0) == 0) {
+        streamStartCapture();
+    }
+}
+
+/*
+ * Drop everything queued, end a half-sent frame with ERR and EOF so the
+ * host discards it, and start over on a fresh capture. A frame is half
+ * sent while it is open or while its EOF is still in the ring or PMA;
+ * the marker carries the FID of the oldest such frame, the host has seen
+ * nothing of the ones after it. With none, no marker is sent and the
+ * FID stays.
+ */
+static void streamRecover(uint8 error) {
+    uint32 primask;
+    uint32 unread;
+
+    trace_event(TRACE_FAULT, error, 0);
+    recover_start = dwt_cycles();
+    if (state == STREAM_DRAIN || state == STREAM_SCAN) {
+        sourceEnd();
+    }
+
+    primask = irq_save();
+    fault_code = UVC_STREAM_ERROR_NONE;
+    unread = frames_queued - frames_done;
+    ring_tail = ring_head;
+    /* a packet of the broken frame may still sit in PMA */
+    usb_set_ep_tx_stat(USB_TX_ENDP, USB_EP_STAT_TX_NAK);
+    tx_busy = 0;
+    eof_in_flight = 0;
+    rate_open = 0;
+    irq_restore(primask);
+
+    usb_uvc_set_stream_error(error);
+    if (frame_open || unread != 0) {
+        trace_event(TRACE_DROP, TRACE_DROP_RECOVER, 0);
+        /* every EOF queued since moved the FID on */
+        if (unread & 1) {
+            fid ^= UVC_STREAM_FID;
+        }
+        frames_queued = frames_done + 1;
+        streamQueueHeader(UVC_STREAM_ERR | UVC_STREAM_EOF);
+        fid ^= UVC_STREAM_FID;
+        frame_open = 0;
+    }
+    stats.faults++;
+    recovering = 1;
+    streamRestart();
+}
+
+/* the capture is in the FIFO or the pattern generator, send it */
+static void streamCaptured(void) {
+    frame_len = (pattern_cur == TEST_PATTERN_OFF) ?
+        arducam_fifo_length() : test_pattern_length();
+    trace_event(TRACE_CAPTURE_DONE, (uint8)(frame_len >> 16), (uint16)frame_len);
+    if (frame_len > ARDUCAM_FIFO_MAX) {
+        /* the write pointer ran past the end, the data is garbage */
+        streamRecover(UVC_STREAM_ERROR_DISCONTINUITY);
+        return;
+    }
+    if (pattern_cur == TEST_PATTERN_OFF) {
+        captured_len = frame_len;
+    }
+    if (policy->cut && frame_len > stream_frame_size * burst_cur) {
+        frame_len = stream_frame_size * burst_cur;
+    }
+    if (frame_len == 0) {
+        streamStartCapture();
+        return;
+    }
+    if (policy->scan && burst_cur == 1 && change_threshold != 0 && scan_buf != NULL) {
+        scan_start = dwt_cycles();
+        scanned = 0;
+        luma_sig_begin(&sig_acc, &sig_cur, frame_len);
+        sourceBegin();
+        state = STREAM_SCAN;
+        streamScan();
+        return;
+    }
+    streamStartDrain();
+}
+
+void uvc_stream_poll(void) {
+    uint32 cycles;
+
+    uvc_clock_poll();
+
+    if (open_waiting && frames_done != open_frames) {
+        open_waiting = 0;
+        stats.first_frame_us = dwt_cycles_to_us(dwt_cycles() - open_start);
+    }
+
+    if (fault_code != UVC_STREAM_ERROR_NONE && state != STREAM_IDLE) {
+        streamRecover(fault_code);
+    }
+
+    switch (state) {
+    case STREAM_IDLE:
+        break;
+
+    case STREAM_ARMED:
+        if (uvc_trigger_poll(&cycles)) {
+            streamTrigger(cycles);
+        }
+        break;
+
+    case STREAM_CAPTURE:
+        if (pattern_cur == TEST_PATTERN_OFF) {
+            uint8 status = arducam_status();
+
+            if (vsync_wait) {
+                streamVsync(status);
+            }
+            if (!(status & ARDUCAM_TRIG_CAP_DONE)) {
+                if (dwt_cycles_to_us(dwt_cycles() - capture_start) >
+                    capture_timeout_us * burst_cur) {
+                    streamRecover(UVC_STREAM_ERROR_INPUT_UNDERRUN);
+                }
+                break;
+            }
+        }
+        capture_done_pts = uvc_clock_now();
+        streamCaptured();
+        break;
+
+    case STREAM_SCAN:
+        streamScan();
+        break;
+
+    case STREAM_KEEPALIVE:
+        streamKeepalive();
+        break;
+
+    case STREAM_DRAIN:
+        streamDrainPass();
+        break;
+
+    case STREAM_APP:
+        break;
+    }
+}
+
+/* Frames per capture, 1 to ARDUCAM_MAX_FRAMES, from the next capture on.
+ * Safe to call from the USB interrupt. */
+void uvc_stream_set_burst(uint8 frames) {
+    if (frames < 1) {
+        frames = 1;
+    }
+    if (frames > ARDUCAM_MAX_FRAMES) {
+        frames = ARDUCAM_MAX_FRAMES;
+    }
+    burst_req = frames;
+}
+
+/* The committed dwFrameInterval, in 100 ns units, sets the capture
+ * timeout from the next capture on; 0 for the descriptor default */
+void uvc_stream_set_interval(uint32 interval) {
+    uint32 us;
+
+    if (interval == 0) {
+        interval = USB_UVC_FRAME_INTERVAL;
+    }
+    us = interval / 10;
+    if (us > UVC_STREAM_CAPTURE_TIMEOUT_MAX_US / UVC_STREAM_CAPTURE_TIMEOUT_FRAMES) {
+        us = UVC_STREAM_CAPTURE_TIMEOUT_MAX_US / UVC_STREAM_CAPTURE_TIMEOUT_FRAMES;
+    }
+    capture_timeout_us = UVC_STREAM_CAPTURE_TIMEOUT_FRAMES * us;
+}
+
+/* A TEST_PATTERN_* in place of the sensor from the next capture on,
+ * TEST_PATTERN_OFF for the sensor. MJPEG streams always get the canned
+ * JPEG frames, YUY2 streams the colour bars in place of them. Safe to
+ * call from the USB interrupt. */
+void uvc_stream_set_pattern(uint8 pattern) {
+    if (pattern >= TEST_PATTERN_COUNT) {
+        pattern = TEST_PATTERN_OFF;
+    }
+    pattern_req = pattern;
+}
+
+/* Output size of the sensor, takes effect from the next frame */
+void uvc_stream_set_geometry(uint16 width, uint16 height) {
+    stream_width = width;
+    stream_height = height;
+}
+
+/* Returns 1 and the statistics of the last YUY2 frame queued, once per
+ * frame. Frames skipped as unchanged do not count. */
+int uvc_stream_get_ae(ae_stats *ae) {
+    if (!ae_ready) {
+        return 0;
+    }
+    *ae = ae_cur;
+    ae_ready = 0;
+    return 1;
+}
+
+/* Forget the capture left in the FIFO, for a change the geometry does
+ * not show: another region of the same size, new sensor settings */
+void uvc_stream_drop_cache(void) {
+    cache = CACHE_NONE;
+}
+
+/* Polled endpoint refill from the next frame on, 0 for the interrupt */
+void uvc_stream_set_polled(uint8 polled) {
+    tx_poll_req = polled ? 1 : 0;
+}
+
+/* Takes effect from the next frame, safe to call from the USB interrupt */
+void uvc_stream_set_threshold(uint8 threshold) {
+    change_threshold = threshold;
+}
+
+/*
+ * Application source
+ *
+ * With UVC_STREAM_SOURCE_APP the sensor is left alone and the packets
+ * come from uvc_stream_acquire()/uvc_stream_submit(). The application
+ * writes its payload straight into the ring slot that the endpoint
+ * sends from; headers are filled in here, without PTS/SCR.
+ */
+
+/* Takes effect at the next uvc_stream_start() */
+void uvc_stream_set_source(uint8 source) {
+    stream_source = source;
+}
+
+/* The next free ring slot, or NULL while not streaming, the ring is
+ * full or a slot is already lent out. The payload starts after
+ * UVC_STREAM_HEADER_SIZE bytes. */
+uvc_packet* uvc_stream_acquire(void) {
+    if (state != STREAM_APP || app_acquired || ringCount() == UVC_STREAM_RING_SIZE) {
+        return NULL;
+    }
+    app_acquired = 1;
+    return ring[ring_head & RING_MASK];
+}
+
+void uvc_stream_release(uvc_packet *pkt) {
+    if (app_acquired && pkt == ring[ring_head & RING_MASK]) {
+        app_acquired = 0;
+    }
+}
+
+/* Queue an acquired slot with len payload bytes, eof ends the frame */
+int uvc_stream_submit(uvc_packet *pkt, uint16 len, uint8 eof) {
+    if (!app_acquired || pkt != ring[ring_head & RING_MASK] ||
+        len > UVC_STREAM_PAYLOAD_SIZE) {
+        return -1;
+    }
+    app_acquired = 0;
+    if (state != STREAM_APP) {
+        /* stopped or recovering, the slot is simply not queued */
+        return -1;
+    }
+    pkt->data[0] = UVC_STREAM_HEADER_SIZE;
+    pkt->data[1] = UVC_STREAM_EOH | fid | (eof ? UVC_STREAM_EOF : 0);
+    pkt->len = UVC_STREAM_HEADER_SIZE + len;
+    if (!frame_open) {
+        trace_event(TRACE_FRAME_START, fid, 0);
+    }
+    frame_open = !eof;
+    if (eof) {
+        streamFrameQueued();
+    }
+
+    compiler_barrier();
+    ring_head++;
+    if (!tx_busy) {
+        streamKick();
+    }
+    return 0;
+}
+
+/* Frames whose last packet the host has read, from either source */
+uint32 uvc_stream_frames_done(void) {
+    return frames_done;
+}
+
+/*
+ * Report a fault from any context, recovery runs from the next
+ * uvc_stream_poll(). The endpoint is parked until then: NAKing, with
+ * tx_busy set so nothing refills it.
+ */
+void uvc_stream_fault(uint8 error) {
+    uint32 primask;
+
+    primask = irq_save();
+    usb_set_ep_tx_stat(USB_TX_ENDP, USB_EP_STAT_TX_NAK);
+    tx_busy = 1;
+    fault_code = error;
+    irq_restore(primask);
+}
+
+const uvc_stream_stats* uvc_stream_get_stats(void) {
+    return &stats;
+}
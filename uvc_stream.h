@@ -0,0 +1,194 @@
+/*
+ * UVC bulk streaming: ArduCAM FIFO -> packet ring -> endpoint
+ *
+ * uvc_stream_poll() runs from the main loop. It captures a frame into
+ * the ArduCAM FIFO and drains it into a ring of ready-made packets, each
+ * one a complete UVC payload with its own header. The endpoint callback
+ * uvc_stream_tx() only copies the next ring slot into packet memory.
+ * The first payload of each frame carries a PTS taken at the sensor
+ * VSYNC that started its capture and an SCR from uvc_clock.h.
+ *
+ * With a change threshold set, a YUY2 frame is read twice: once for its
+ * luma signature, then, if it differs enough from the last frame sent,
+ * again from the rewound FIFO into the ring. An unchanged frame is
+ * replaced by one header-only payload so the host still sees traffic.
+ *
+ * With a burst set, every capture takes several frames back to back
+ * into the FIFO at sensor speed and they are drained one after the
+ * other, each with its own FID and a PTS spread between the capture's
+ * VSYNC and capture done. Change detection is off for bursts.
+ *
+ * A test pattern (test_pattern.h) can stand in for the ArduCAM: the
+ * capture is ready at once and read from a generator instead of SPI,
+ * through the same framing, ring and endpoint refill. Select one with
+ * UVC_STREAM_TEST_PATTERN at build time or uvc_stream_set_pattern().
+ *
+ * YUY2 payloads also feed the exposure statistics of ae_stats.h on
+ * their way into the ring.
+ *
+ * The frame-based lossless format reads the same YUY2 frames from the
+ * FIFO a line at a time and codes each line with yuy2_rice.h on its way
+ * into the ring; a frame ends with its last coded line.
+ *
+ * The 4:2:0 format reads them the same way and repacks every line pair
+ * with yuv420.h: two lines of Y, then one of chroma averaged over both.
+ * Raw Bayer frames go out as they are, a byte per pixel, with the byte
+ * ramp as their test pattern.
+ *
+ * With a capture trigger set (uvc_trigger.h), each capture waits for a
+ * GPIO edge or a chosen USB frame instead of starting as soon as the
+ * last one is out; its PTS is still taken at the VSYNC, the trigger
+ * plus the measured delay.
+ *
+ * In polled mode a drain pass masks the correct-transfer interrupt and,
+ * whenever the ring is full, spins on the endpoint's CTR_TX and refills
+ * it from the main loop. Between passes and between frames the
+ * interrupt does the refill again. tx_packets / tx_us compare the two
+ * on test pattern frames, whose drain runs from SRAM without SPI, so
+ * that the refill and not the FIFO read sets the rate;
+ * tools/refill_model.c models both paths.
+ *
+ * A stream that stops leaves its capture in the ArduCAM FIFO. The next
+ * one with the same sensor output sends that first, with its original
+ * PTS, instead of waiting for a new exposure.
+ *
+ * Sensor JPEG frames are checked for an SOI at the head of the FIFO and
+ * an EOI at their end. A few broken ones in a row take the SPI clock a
+ * step down at the next capture.
+ *
+ * A fault (FIFO overflow, capture timeout, endpoint halt cleared by the
+ * host) ends the frame in flight with an ERR payload, flushes the ring,
+ * moves on to the next FID and restarts capture, without the host
+ * having to reset the device. The capture timeout is a few of the frame
+ * intervals the host committed, see uvc_stream_set_interval().
+ */
+
+#ifndef _UVC_STREAM_H_
+#define _UVC_STREAM_H_
+
+#include <libmaple/libmaple_types.h>
+
+#include "usb_uvc.h"
+#include "ae_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* number of packets buffered between the FIFO and the endpoint, must be
+ * a power of two */
+#define UVC_STREAM_RING_SIZE    8
+
+#define UVC_STREAM_HEADER_SIZE  2
+#define UVC_STREAM_PAYLOAD_SIZE (USB_TX_EPSIZE - UVC_STREAM_HEADER_SIZE)
+/* the first payload of a frame also carries PTS and SCR */
+#define UVC_STREAM_HEADER_SIZE_TS       (UVC_STREAM_HEADER_SIZE + 4 + 6)
+
+/* where the packets come from */
+#define UVC_STREAM_SOURCE_SENSOR        0
+#define UVC_STREAM_SOURCE_APP           1
+
+/* a capture not done after this many committed frame intervals per
+ * frame counts as a fault: up to a sensor frame to its VSYNC, one to
+ * write it, and as much again of slack */
+#define UVC_STREAM_CAPTURE_TIMEOUT_FRAMES       4
+/* and at most this long per frame, so that a burst stays well inside
+ * the 59 s the DWT counter takes to wrap */
+#define UVC_STREAM_CAPTURE_TIMEOUT_MAX_US       8000000
+
+/* a capture left in the FIFO older than this is not sent on the next
+ * stream start */
+#ifndef UVC_STREAM_CACHE_MAX_AGE_MS
+#define UVC_STREAM_CACHE_MAX_AGE_MS     5000
+#endif
+
+/* 1 to refill the endpoint from the drain loop instead of its
+ * interrupt while a frame is sent, see uvc_stream_set_polled() */
+#ifndef UVC_STREAM_TX_POLLED
+#define UVC_STREAM_TX_POLLED    0
+#endif
+
+/* longest a polled drain pass keeps the correct-transfer interrupt
+ * masked, inside the stream task budget */
+#ifndef UVC_STREAM_POLL_SLICE_US
+#define UVC_STREAM_POLL_SLICE_US        450
+#endif
+
+/* uvc_stream_stats.tx_packets and tx_us */
+#define UVC_STREAM_TX_IRQ       0
+#define UVC_STREAM_TX_POLL      1
+
+/* sensor JPEG frames in a row without their SOI or EOI before the SPI
+ * clock steps down, see arducam_spi_fallback() */
+#define UVC_STREAM_SPI_FALLBACK_ERRORS  3
+
+/* bStreamErrorCode, UVC 1.1 4.3.1.7 */
+#define UVC_STREAM_ERROR_NONE           0
+#define UVC_STREAM_ERROR_INPUT_UNDERRUN 2
+#define UVC_STREAM_ERROR_DISCONTINUITY  3
+
+/* largest luma change, in levels, that still counts as the same frame;
+ * 0 sends every frame */
+#ifndef UVC_STREAM_CHANGE_THRESHOLD
+#define UVC_STREAM_CHANGE_THRESHOLD 0
+#endif
+
+/* TEST_PATTERN_* streamed from boot in place of the sensor */
+#ifndef UVC_STREAM_TEST_PATTERN
+#define UVC_STREAM_TEST_PATTERN 0
+#endif
+
+typedef struct uvc_packet {
+    uint8 data[USB_TX_EPSIZE];
+    uint16 len;
+} __attribute__((aligned(4))) uvc_packet;
+
+typedef struct uvc_stream_stats {
+    uint32 frames;              /* frames completely queued */
+    uint32 packets;             /* packets handed to the endpoint */
+    uint32 ring_empty;          /* endpoint went idle waiting for data */
+    uint32 send_cycles;         /* last endpoint refill, PMA copy included */
+    uint32 send_cycles_max;
+    uint32 drain_cycles;        /* last packet filled from the FIFO */
+    uint32 code_cycles;         /* last line of the lossless format, coding only */
+    uint32 skipped;             /* unchanged frames sent as a keepalive */
+    uint32 scan_us;             /* last signature pass over the FIFO */
+    uint8 change;               /* last signature distance */
+    uint32 faults;              /* recoveries started */
+    uint32 recovery_us;         /* fault to the next complete frame queued */
+    uint32 recovery_us_max;
+    uint32 jpeg_errors;         /* sensor JPEG frames without SOI or EOI */
+    uint32 cache_hits;          /* streams started on the capture left in the FIFO */
+    uint32 first_frame_us;      /* last stream start to the host reading its first frame */
+    uint32 vsync_missed;        /* captures stamped at the start command, VSYNC not seen */
+    uint32 tx_packets[2];       /* packets of pattern frames sent, per UVC_STREAM_TX_* refill */
+    uint32 tx_us[2];            /* from their drain start to the host reading the EOF */
+} uvc_stream_stats;
+
+int uvc_stream_init(void);
+void uvc_stream_start(uint8 format, uint32 frame_size);
+void uvc_stream_stop(void);
+void uvc_stream_poll(void);
+void uvc_stream_set_threshold(uint8 threshold);
+void uvc_stream_set_geometry(uint16 width, uint16 height);
+void uvc_stream_set_burst(uint8 frames);
+void uvc_stream_set_interval(uint32 interval);
+void uvc_stream_set_pattern(uint8 pattern);
+void uvc_stream_drop_cache(void);
+void uvc_stream_set_polled(uint8 polled);
+int uvc_stream_get_ae(ae_stats *ae);
+void uvc_stream_fault(uint8 error);
+
+void uvc_stream_set_source(uint8 source);
+uvc_packet* uvc_stream_acquire(void);
+void uvc_stream_release(uvc_packet *pkt);
+int uvc_stream_submit(uvc_packet *pkt, uint16 len, uint8 eof);
+uint32 uvc_stream_frames_done(void);
+void uvc_stream_tx(void);
+const uvc_stream_stats* uvc_stream_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
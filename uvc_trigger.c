@@ -0,0 +1,202 @@
+/*
+ * Capture trigger, see uvc_trigger.h
+ */
+
+#include <libmaple/gpio.h>
+#include <libmaple/exti.h>
+
+#include "usb_reg_map.h"
+
+#include "uvc_trigger.h"
+#include "uvc_clock.h"
+#include "usb_uvc.h"
+#include "dwt.h"
+#include "irq.h"
+#include "trace.h"
+
+/* from the USB interrupt, taken at the next uvc_trigger_arm() */
+static volatile uint8 mode_req = UVC_TRIGGER_FREE;
+static volatile uint16 frame_req;
+static volatile uint16 period_req = 1;
+static volatile uint8 set_pending;
+
+static volatile uint8 mode = UVC_TRIGGER_FREE;
+static uint16 sof_next;                 /* the next USB frame that triggers */
+static uint16 sof_period;
+
+/* the GPIO edge, from the EXTI interrupt */
+static volatile uint8 armed;
+static volatile uint8 fired;
+static volatile uint32 fired_cycles;
+
+static uvc_trigger_stats stats;
+
+static void triggerEdge(void) {
+    uint32 now = dwt_cycles();
+
+    if (mode != UVC_TRIGGER_GPIO) {
+        return;
+    }
+    if (!armed || fired) {
+        stats.missed++;
+        return;
+    }
+    fired_cycles = now;
+    fired = 1;
+}
+
+void uvc_trigger_init(void) {
+    gpio_set_mode(UVC_TRIGGER_GPIO_DEV, UVC_TRIGGER_GPIO_BIT, GPIO_INPUT_PD);
+    exti_attach_interrupt((exti_num)UVC_TRIGGER_GPIO_BIT, gpio_exti_port(UVC_TRIGGER_GPIO_DEV),
+                          triggerEdge, EXTI_RISING);
+}
+
+/* Takes effect at the next capture, safe to call from the USB interrupt */
+void uvc_trigger_set(uint8 new_mode, uint16 frame, uint16 period) {
+    if (new_mode >= UVC_TRIGGER_MODES) {
+        new_mode = UVC_TRIGGER_FREE;
+    }
+    if (period < 1) {
+        period = 1;
+    }
+    if (period > UVC_TRIGGER_PERIOD_MAX) {
+        period = UVC_TRIGGER_PERIOD_MAX;
+    }
+    mode_req = new_mode;
+    frame_req = frame & USB_FNR_FN;
+    period_req = period;
+    set_pending = 1;
+}
+
+/* The settings as uvc_trigger_set() took them */
+void uvc_trigger_get(uint8 *new_mode, uint16 *frame, uint16 *period) {
+    *new_mode = mode_req;
+    *frame = frame_req;
+    *period = period_req;
+}
+
+uint8 uvc_trigger_mode(void) {
+    return mode_req;
+}
+
+/* The trigger frame is already gone. One that is still running is not:
+ * sofFired() starts the capture in it, late. */
+static int sofPassed(uint16 frame) {
+    uint16 ahead = (frame - sof_next) & USB_FNR_FN;
+
+    return ahead != 0 && ahead < UVC_TRIGGER_PERIOD_MAX;
+}
+
+/* Wait for the next trigger; one that comes before this is dropped */
+void uvc_trigger_arm(void) {
+    if (set_pending) {
+        uint32 primask;
+
+        primask = irq_save();
+        mode = mode_req;
+        sof_next = frame_req;
+        sof_period = period_req;
+        set_pending = 0;
+        irq_restore(primask);
+    }
+    if (mode == UVC_TRIGGER_SOF) {
+        uint16 frame = (uint16)(USB_BASE->FNR & USB_FNR_FN);
+
+        /* frames that went by while the last capture drained */
+        while (sofPassed(frame)) {
+            sof_next = (sof_next + sof_period) & USB_FNR_FN;
+            stats.missed++;
+        }
+    }
+    fired = 0;
+    armed = 1;
+}
+
+/*
+ * The SOF that starts the trigger frame. A main loop pass that finds
+ * the frame already running fires late; in the last stretch of the
+ * frame before it, the poll waits for the frame number to move on.
+ * uvc_clock latched its SCR at the first pass after the current SOF,
+ * so the next one is at most 1 ms past that.
+ */
+static int sofFired(uint32 *cycles) {
+    uint16 frame = (uint16)(USB_BASE->FNR & USB_FNR_FN);
+    uint32 start;
+
+    if (frame == sof_next) {
+        stats.late++;
+        *cycles = dwt_cycles();
+        return 1;
+    }
+    if (sofPassed(frame)) {
+        uvc_trigger_arm();
+        return 0;
+    }
+    if (((sof_next - frame) & USB_FNR_FN) != 1 ||
+        uvc_clock_now() - uvc_clock_get_scr()->stc <
+        (1000 - UVC_TRIGGER_SOF_SPIN_US) * (USB_UVC_CLOCK_FREQUENCY / 1000000)) {
+        return 0;
+    }
+    start = dwt_cycles();
+    while ((uint16)(USB_BASE->FNR & USB_FNR_FN) == frame) {
+        if (dwt_cycles() - start > UVC_TRIGGER_SOF_SPIN_US * DWT_CYCLES_PER_US) {
+            return 0;
+        }
+    }
+    *cycles = dwt_cycles();
+    return 1;
+}
+
+/* Returns 1 and the DWT cycle count of the trigger once it has fired,
+ * at once without a trigger set */
+int uvc_trigger_poll(uint32 *cycles) {
+    if (set_pending) {
+        uvc_trigger_arm();
+    }
+    switch (mode) {
+    case UVC_TRIGGER_GPIO:
+        if (!fired) {
+            return 0;
+        }
+        *cycles = fired_cycles;
+        break;
+
+    case UVC_TRIGGER_SOF:
+        if (!sofFired(cycles)) {
+            return 0;
+        }
+        sof_next = (sof_next + sof_period) & USB_FNR_FN;
+        break;
+
+    default:
+        *cycles = dwt_cycles();
+        break;
+    }
+    armed = 0;
+    return 1;
+}
+
+/* The capture started, at the sensor VSYNC for the ArduCAM; cycles from
+ * uvc_trigger_poll(). Returns the trigger to capture delay in
+ * microseconds. */
+uint32 uvc_trigger_started(uint32 cycles) {
+    uint32 us = dwt_cycles_to_us(dwt_cycles() - cycles);
+
+    if (mode == UVC_TRIGGER_FREE) {
+        return 0;
+    }
+    stats.triggers++;
+    stats.delay_us = us;
+    if (us > stats.delay_us_max) {
+        stats.delay_us_max = us;
+    }
+    trace_event(TRACE_TRIGGER, mode, (uint16)(us > 0xFFFF ? 0xFFFF : us));
+    if (mode == UVC_TRIGGER_GPIO) {
+        usb_uvc_button_event();
+    }
+    return us;
+}
+
+const uvc_trigger_stats* uvc_trigger_get_stats(void) {
+    return &stats;
+}
@@ -0,0 +1,79 @@
+/*
+ * Capture trigger for cameras that have to expose together
+ *
+ * Free running, the stream triggers the next capture as soon as the
+ * last one is out of the FIFO, so the captures of two cameras drift
+ * apart. With a trigger set, the stream arms it instead and starts the
+ * capture when it fires:
+ *
+ *   UVC_TRIGGER_GPIO   a rising edge on UVC_TRIGGER_GPIO_DEV/BIT, time
+ *                      stamped in the EXTI interrupt; wire the pins of
+ *                      all cameras to one pulse
+ *   UVC_TRIGGER_SOF    the USB frames wFrame + n * wPeriod (11-bit
+ *                      frame numbers), the same SOF for every device on
+ *                      one host controller
+ *
+ * Triggers that come while no capture is armed are counted as missed
+ * and dropped, a late camera waits for the next one rather than
+ * capturing out of step. The SOF is caught by spinning on the frame
+ * number for the last UVC_TRIGGER_SOF_SPIN_US of the frame before,
+ * otherwise by the next main loop pass, which is counted as late.
+ *
+ * The ArduCAM only writes a whole sensor frame into the FIFO, so a
+ * capture starts with the sensor's next VSYNC after the trigger. The
+ * stream takes the capture's PTS and the trigger delay there. The
+ * OV2640 has no frame sync input and only a reset restarts its timing,
+ * so the sensors keep running free: the captures of all cameras fall
+ * into the same sensor frame period, not onto the same line, and the
+ * PTS says where in it each one started.
+ */
+
+#ifndef _UVC_TRIGGER_H_
+#define _UVC_TRIGGER_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UVC_TRIGGER_FREE        0
+#define UVC_TRIGGER_GPIO        1
+#define UVC_TRIGGER_SOF         2
+#define UVC_TRIGGER_MODES       3
+
+/* trigger input, rising edge, pulled down */
+#ifndef UVC_TRIGGER_GPIO_DEV
+#define UVC_TRIGGER_GPIO_DEV    GPIOB
+#define UVC_TRIGGER_GPIO_BIT    0
+#endif
+
+/* USB frames between SOF triggers; past half the frame number range
+ * the 11-bit numbers no longer tell ahead from behind */
+#define UVC_TRIGGER_PERIOD_MAX  1024
+
+/* longest the stream spins on the frame number, within its task budget */
+#define UVC_TRIGGER_SOF_SPIN_US 250
+
+typedef struct uvc_trigger_stats {
+    uint32 triggers;            /* captures started by a trigger */
+    uint32 missed;              /* edges or frames while nothing was armed */
+    uint32 late;                /* SOFs seen by a main loop pass, not the spin */
+    uint32 delay_us;            /* last trigger to the VSYNC that started its capture */
+    uint32 delay_us_max;
+} uvc_trigger_stats;
+
+void uvc_trigger_init(void);
+void uvc_trigger_set(uint8 mode, uint16 frame, uint16 period);
+void uvc_trigger_get(uint8 *mode, uint16 *frame, uint16 *period);
+uint8 uvc_trigger_mode(void);
+void uvc_trigger_arm(void);
+int uvc_trigger_poll(uint32 *cycles);
+uint32 uvc_trigger_started(uint32 cycles);
+const uvc_trigger_stats* uvc_trigger_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * YUY2 to M420 line pair kernel
+ *
+ * M420 is 4:2:0 at 12 bits per pixel in the order the lines come out of
+ * the FIFO: for every pair of lines the two lines of Y, then one line of
+ * interleaved U and V, each the rounded mean of the two lines' samples.
+ * It needs the chroma of one line kept until the next, nothing more.
+ * Frames are whole line pairs; tools/yuv420_bench.c checks the kernel
+ * against a per-pixel conversion and repacks M420 into NV12.
+ */
+
+#ifndef _YUV420_H_
+#define _YUV420_H_
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bytes of M420 from a line pair of line_bytes YUY2 bytes each */
+#define YUV420_PAIR_BYTES(line_bytes)   ((line_bytes) / 2 * 3)
+#define YUV420_FRAME_SIZE(width, height) \
+    ((uint32)((width) & ~1) * ((height) & ~1) * 3 / 2)
+
+/*
+ * One YUY2 line of line_bytes bytes into its line_bytes / 2 bytes of Y
+ * and line_bytes / 2 bytes of UV. With avg set uv holds the chroma of
+ * the line above and gets the mean of both.
+ */
+static inline __attribute__((always_inline))
+void yuv420_split(const uint8 *line, uint16 line_bytes, uint8 *y, uint8 *uv, const uint8 avg) {
+    const uint8 *end = line + line_bytes;
+
+    while (line < end) {
+        y[0] = line[0];
+        y[1] = line[2];
+        if (avg) {
+            uv[0] = (uint8)((uv[0] + line[1] + 1) >> 1);
+            uv[1] = (uint8)((uv[1] + line[3] + 1) >> 1);
+        } else {
+            uv[0] = line[1];
+            uv[1] = line[3];
+        }
+        line += 4;
+        y += 2;
+        uv += 2;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Lossless line coder for YUY2
+ *
+ * Each line is coded on its own, so the device needs no frame buffer and
+ * codes a line as it comes out of the FIFO. Every sample is predicted
+ * from the one before it of the same component on the line (Y from the
+ * previous Y, U from the previous U, V from the previous V, the first of
+ * each from 128) and the residual goes out as a Golomb-Rice code. The
+ * Rice parameters are chosen from the mean residual of the line above
+ * and sent in the line header, so the decoder keeps no statistics. A line that would not get
+ * smaller goes out raw, a frame never takes more than
+ * YUY2_RICE_FRAME_MAX() bytes.
+ *
+ * Frame: 4 bytes, width and height in pixels, little endian, then
+ * height lines. Line: a header byte and the samples in YUY2 order.
+ *
+ *   header bit 7 set        raw, width * 2 bytes of YUY2 follow
+ *   header bits 6..4        k for Y samples
+ *   header bits 2..0        k for U and V samples
+ *
+ * A sample's residual r = (x - prediction) mod 256, taken as signed, is
+ * mapped to m = 2r for r >= 0 and -2r - 1 otherwise. With q = m >> k,
+ * m is coded MSB first as q one bits, a zero bit and the k low bits of m;
+ * from q = YUY2_RICE_LIMIT on, as YUY2_RICE_LIMIT one bits and m in 8
+ * bits. A coded line is padded with zero bits to a whole byte.
+ *
+ * The encoder is written for the Cortex-M3 drain loop, the decoder for
+ * the host; tools/yuy2_rice_bench.c checks one against the other.
+ */
+
+#ifndef _YUY2_RICE_H_
+#define _YUY2_RICE_H_
+
+#include <string.h>
+
+#include <libmaple/libmaple_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YUY2_RICE_HEADER_SIZE   4
+#define YUY2_RICE_RAW           0x80
+#define YUY2_RICE_K_MAX         7
+/* longest unary part, the escape code is this many ones and 8 bits */
+#define YUY2_RICE_LIMIT         12
+/* residuals count up to this much towards the next k: a few sharp
+ * edges in a flat line cost an escape code each and should not pull k
+ * up for the whole line */
+#define YUY2_RICE_CLIP          32
+/* the most a macropixel can take, four escape codes */
+#define YUY2_RICE_MACROPIXEL_MAX (4 * (YUY2_RICE_LIMIT + 8) / 8)
+
+/* bytes per line of a frame width pixels wide, whole macropixels */
+#define YUY2_RICE_LINE_BYTES(width)     (((width) * 2) & ~3)
+#define YUY2_RICE_FRAME_MAX(width, height) \
+    (YUY2_RICE_HEADER_SIZE + (uint32)(height) * (YUY2_RICE_LINE_BYTES(width) + 1))
+
+typedef struct yuy2_rice {
+    uint16 line_bytes;
+    uint8 k_y;                  /* for the next line */
+    uint8 k_c;
+} yuy2_rice;
+
+static inline void yuy2_rice_begin(yuy2_rice *s, uint16 width) {
+    s->line_bytes = (uint16)YUY2_RICE_LINE_BYTES(width);
+    s->k_y = 2;
+    s->k_c = 1;
+}
+
+/* The frame header for height lines, YUY2_RICE_HEADER_SIZE bytes */
+static inline void yuy2_rice_header(const yuy2_rice *s, uint16 height, uint8 *out) {
+    out[0] = (uint8)(s->line_bytes / 2);
+    out[1] = (uint8)(s->line_bytes / 2 >> 8);
+    out[2] = (uint8)height;
+    out[3] = (uint8)(height >> 8);
+}
+
+/* smallest k that makes n << k cover the sum of n mapped residuals */
+static inline uint8 yuy2_rice_k(uint32 sum, uint32 n) {
+    uint8 k = 0;
+
+    while (k < YUY2_RICE_K_MAX && (n << k) < sum) {
+        k++;
+    }
+    return k;
+}
+
+typedef struct yuy2_rice_bits {
+    uint32 acc;
+    uint8 n;                    /* bits in acc not written out yet */
+    uint8 *out;
+} yuy2_rice_bits;
+
+static inline __attribute__((always_inline))
+void yuy2_rice_put(yuy2_rice_bits *b, uint32 code, uint8 len) {
+    b->acc = (b->acc << len) | code;
+    b->n += len;
+    while (b->n >= 8) {
+        b->n -= 8;
+        *b->out++ = (uint8)(b->acc >> b->n);
+    }
+}
+
+/* Code one sample, returns its mapped residual clipped to YUY2_RICE_CLIP */
+static inline __attribute__((always_inline))
+uint8 yuy2_rice_sample(yuy2_rice_bits *b, uint8 x, uint8 *pred, uint8 k) {
+    int8 r = (int8)(uint8)(x - *pred);
+    uint8 m = (uint8)((r << 1) ^ (r >> 7));
+    uint8 q = m >> k;
+
+    *pred = x;
+    if (q < YUY2_RICE_LIMIT) {
+        yuy2_rice_put(b, ((((1UL << q) - 1) << 1) << k) | (m & ((1U << k) - 1)), q + 1 + k);
+    } else {
+        yuy2_rice_put(b, (((1UL << YUY2_RICE_LIMIT) - 1) << 8) | m, YUY2_RICE_LIMIT + 8);
+    }
+    return (m < YUY2_RICE_CLIP) ? m : YUY2_RICE_CLIP;
+}
+
+/*
+ * Code one line of line_bytes YUY2 bytes into out, header byte first.
+ * Returns the coded length, at most line_bytes, or 0 when the line does
+ * not get smaller: it then goes out as YUY2_RICE_RAW and the line
+ * itself. Either way the Rice parameters move on to the next line.
+ */
+static inline __attribute__((always_inline))
+uint16 yuy2_rice_encode_line(yuy2_rice *s, const uint8 *line, uint8 *out) {
+    const uint8 *end = line + s->line_bytes;
+    const uint8 *p = line;
+    const uint8 *limit = out + s->line_bytes - YUY2_RICE_MACROPIXEL_MAX - 1;
+    yuy2_rice_bits b;
+    uint8 py = 128, pu = 128, pv = 128;
+    uint8 ky = s->k_y, kc = s->k_c;
+    uint32 sum_y = 0, sum_c = 0;
+    uint16 len = 0;
+
+    out[0] = (uint8)(ky << 4 | kc);
+    b.acc = 0;
+    b.n = 0;
+    b.out = out + 1;
+    while (p < end) {
+        if (b.out > limit) {
+            break;
+        }
+        sum_y += yuy2_rice_sample(&b, p[0], &py, ky);
+        sum_c += yuy2_rice_sample(&b, p[1], &pu, kc);
+        sum_y += yuy2_rice_sample(&b, p[2], &py, ky);
+        sum_c += yuy2_rice_sample(&b, p[3], &pv, kc);
+        p += 4;
+    }
+    if (p == end) {
+        if (b.n != 0) {
+            yuy2_rice_put(&b, 0, 8 - b.n);
+        }
+        len = (uint16)(b.out - out);
+    }
+
+    /* both sums cover (p - line) / 2 samples, a raw line's only part */
+    s->k_y = yuy2_rice_k(sum_y, (uint32)(p - line) / 2);
+    s->k_c = yuy2_rice_k(sum_c, (uint32)(p - line) / 2);
+    return len;
+}
+
+/*
+ * Decode one line from in, at most avail bytes, into line_bytes bytes
+ * of YUY2. Returns the bytes taken from in, 0 if the line is cut short
+ * or does not decode.
+ */
+static inline uint32 yuy2_rice_decode_line(const yuy2_rice *s, const uint8 *in, uint32 avail,
+                                           uint8 *line) {
+    uint8 pred[4] = {128, 128, 128, 128};
+    uint64 acc = 0;
+    uint32 pos = 1;
+    uint16 i;
+    uint8 ky, kc;
+    int n = 0;
+
+    if (avail == 0) {
+        return 0;
+    }
+    if (in[0] & YUY2_RICE_RAW) {
+        if (avail < 1 + (uint32)s->line_bytes) {
+            return 0;
+        }
+        memcpy(line, in + 1, s->line_bytes);
+        return 1 + s->line_bytes;
+    }
+    ky = (in[0] >> 4) & 7;
+    kc = in[0] & 7;
+
+    for (i = 0; i < s->line_bytes; i++) {
+        uint8 k = (i & 1) ? kc : ky;
+        /* U and V take turns on the odd bytes */
+        uint8 *pr = &pred[(i & 1) ? (i & 2) + 1 : 0];
+        uint32 q, m;
+        int8 r;
+
+        while (n <= 56 && pos < avail) {
+            acc |= (uint64)in[pos++] << (56 - n);
+            n += 8;
+        }
+        q = (uint32)__builtin_clzll(~acc | 1);
+        if (q >= YUY2_RICE_LIMIT) {
+            if (n < YUY2_RICE_LIMIT + 8) {
+                return 0;
+            }
+            m = (uint32)(acc >> (64 - YUY2_RICE_LIMIT - 8)) & 0xFF;
+            acc <<= YUY2_RICE_LIMIT + 8;
+            n -= YUY2_RICE_LIMIT + 8;
+        } else {
+            if (n < (int)(q + 1 + k)) {
+                return 0;
+            }
+            acc <<= q + 1;
+            m = (q << k) | (k ? (uint32)(acc >> (64 - k)) : 0);
+            acc <<= k;
+            n -= q + 1 + k;
+        }
+        r = (int8)(uint8)((m >> 1) ^ (0 - (m & 1)));
+        *pr = (uint8)(*pr + r);
+        line[i] = *pr;
+    }
+    /* the padding bits of the last byte */
+    return pos - (uint32)(n / 8);
+}
+
+/*
+ * Decode a whole frame of at most len bytes into frame, which holds
+ * max bytes. Returns the bytes taken from in and the size, 0 if the
+ * frame is broken or too big.
+ */
+static inline uint32 yuy2_rice_decode_frame(const uint8 *in, uint32 len, uint8 *frame, uint32 max,
+                                            uint16 *width, uint16 *height) {
+    yuy2_rice s;
+    uint32 pos = YUY2_RICE_HEADER_SIZE;
+    uint16 y;
+
+    if (len < YUY2_RICE_HEADER_SIZE) {
+        return 0;
+    }
+    *width = (uint16)(in[0] | in[1] << 8);
+    *height = (uint16)(in[2] | in[3] << 8);
+    yuy2_rice_begin(&s, *width);
+    if (s.line_bytes == 0 || (uint32)s.line_bytes * *height > max) {
+        return 0;
+    }
+    for (y = 0; y < *height; y++) {
+        uint32 n = yuy2_rice_decode_line(&s, in + pos, len - pos, frame + (uint32)y * s.line_bytes);
+
+        if (n == 0) {
+            return 0;
+        }
+        pos += n;
+    }
+    return pos;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif